@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+#include <lockables/async_guarded.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kNumCoroutine = 10000;
+constexpr int kNumIteration = 10;
+
+lockables::DetachedTask increment(lockables::RunLoop& loop,
+                                  lockables::AsyncGuarded<int64_t>& value,
+                                  std::atomic<int>& remaining) {
+  co_await loop.schedule();
+
+  for (int i = 0; i < kNumIteration; ++i) {
+    auto guard = co_await value.async_exclusive(loop);
+    *guard += 1;
+  }
+
+  if (remaining.fetch_sub(1) == 1) {
+    loop.stop();
+  }
+}
+
+}  // namespace
+
+// Run 10k coroutines that contend on a handful of AsyncGuarded<T> values.
+// First argument is the number of guarded values, second argument is the
+// number of threads that run the loop.
+void BM_AsyncGuarded_Contention(benchmark::State& state) {
+  const auto num_value = static_cast<std::size_t>(state.range(0));
+  const auto num_thread = static_cast<std::size_t>(state.range(1));
+
+  for (auto _ : state) {
+    lockables::RunLoop loop;
+    std::vector<lockables::AsyncGuarded<int64_t>> values(num_value);
+    std::atomic<int> remaining{kNumCoroutine};
+
+    for (int i = 0; i < kNumCoroutine; ++i) {
+      increment(loop, values[static_cast<std::size_t>(i) % num_value],
+                remaining);
+    }
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < num_thread; ++i) {
+      threads.emplace_back([&loop]() { loop.run(); });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * kNumCoroutine * kNumIteration);
+}
+
+BENCHMARK(BM_AsyncGuarded_Contention)
+    ->ArgsProduct({{1, 4, 16}, {1, 4, 8}})
+    ->UseRealTime();
@@ -0,0 +1,144 @@
+#include <benchmark/benchmark.h>
+#include <lockables/concurrent_bitmap.hpp>
+#include <lockables/guarded.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kSize = 1 << 16;
+// Each thread holds this many bits and frees the oldest one per iteration.
+constexpr std::size_t kNumHeld = 16;
+
+using GuardedBits = lockables::Guarded<std::vector<bool>>;
+
+std::optional<std::size_t> allocate(GuardedBits& bits) {
+  auto guard = bits.with_exclusive();
+  const auto itr = std::find(guard->begin(), guard->end(), false);
+  if (itr == guard->end()) {
+    return std::nullopt;
+  }
+
+  *itr = true;
+  return static_cast<std::size_t>(itr - guard->begin());
+}
+
+void reset(GuardedBits& bits, std::size_t index) {
+  auto guard = bits.with_exclusive();
+  (*guard)[index] = false;
+}
+
+// Fill 7/8 of the bits before the run so that allocation has to search. Leave
+// the free bits spread across the range.
+bool is_prefilled(std::size_t index) { return index % 8 != 0; }
+
+}  // namespace
+
+// Resource allocation. Each thread keeps a ring of kNumHeld allocated bits,
+// every iteration frees the oldest one and allocates a new one.
+//
+// Compare Guarded<std::vector<bool>>, with a linear scan under the lock, to
+// the ConcurrentBitmap.
+struct BM_Bitmap_Fixture : benchmark::Fixture {
+  std::unique_ptr<GuardedBits> guarded{};
+  std::unique_ptr<lockables::ConcurrentBitmap> bitmap{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded = std::make_unique<GuardedBits>();
+    bitmap = std::make_unique<lockables::ConcurrentBitmap>(kSize);
+
+    auto guard = guarded->with_exclusive();
+    guard->resize(kSize);
+    for (std::size_t i = 0; i < kSize; ++i) {
+      if (is_prefilled(i)) {
+        (*guard)[i] = true;
+        bitmap->set(i);
+      }
+    }
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded.reset();
+    bitmap.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_Bitmap_Fixture, Guarded)(benchmark::State& state) {
+  std::vector<std::size_t> held(kNumHeld, kSize);
+  std::size_t i = 0;
+  for (auto _ : state) {
+    std::size_t& slot = held[i++ % kNumHeld];
+    if (slot != kSize) {
+      reset(*guarded, slot);
+    }
+    slot = allocate(*guarded).value_or(kSize);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Bitmap_Fixture, Guarded)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_Bitmap_Fixture, ConcurrentBitmap)
+(benchmark::State& state) {
+  std::vector<std::size_t> held(kNumHeld, kSize);
+  std::size_t i = 0;
+  for (auto _ : state) {
+    std::size_t& slot = held[i++ % kNumHeld];
+    if (slot != kSize) {
+      bitmap->reset(slot);
+    }
+    slot = bitmap->allocate().value_or(kSize);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Bitmap_Fixture, ConcurrentBitmap)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+// Bulk scans over the whole range. Count the set bits and find the first
+// clear one.
+BENCHMARK_DEFINE_F(BM_Bitmap_Fixture, GuardedScan)(benchmark::State& state) {
+  for (auto _ : state) {
+    const auto guard = guarded->with_shared();
+    benchmark::DoNotOptimize(std::count(guard->begin(), guard->end(), true));
+    benchmark::DoNotOptimize(std::find(guard->begin(), guard->end(), false));
+  }
+
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(kSize / 8));
+}
+
+BENCHMARK_REGISTER_F(BM_Bitmap_Fixture, GuardedScan)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_Bitmap_Fixture, ConcurrentBitmapScan)
+(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bitmap->count());
+    benchmark::DoNotOptimize(bitmap->find_first_zero());
+  }
+
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(kSize / 8));
+}
+
+BENCHMARK_REGISTER_F(BM_Bitmap_Fixture, ConcurrentBitmapScan)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
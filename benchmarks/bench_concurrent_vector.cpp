@@ -0,0 +1,133 @@
+#include <benchmark/benchmark.h>
+#include <lockables/concurrent_vector.hpp>
+#include <lockables/guarded.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+namespace {
+
+// Readers sum the most recent events.
+constexpr std::size_t kNumRecent = 64;
+
+using GuardedVector =
+    lockables::Guarded<std::vector<int64_t>, std::shared_mutex>;
+
+}  // namespace
+
+// Event buffer. Thread 0 appends one event per iteration. The other threads
+// sum the most recent events.
+//
+// Compare Guarded<std::vector, std::shared_mutex>, where readers hold the lock
+// while they iterate, to the ConcurrentVector, where readers never lock.
+struct BM_ConcurrentVector_Fixture : benchmark::Fixture {
+  std::unique_ptr<GuardedVector> guarded{};
+  std::unique_ptr<lockables::ConcurrentVector<int64_t>> concurrent{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded = std::make_unique<GuardedVector>();
+    concurrent = std::make_unique<lockables::ConcurrentVector<int64_t>>();
+
+    auto guard = guarded->with_exclusive();
+    for (std::size_t i = 0; i < kNumRecent; ++i) {
+      guard->push_back(1);
+      concurrent->push_back(1);
+    }
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded.reset();
+    concurrent.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_ConcurrentVector_Fixture, Guarded)
+(benchmark::State& state) {
+  const bool is_writer = state.thread_index() == 0;
+  int64_t i = 0;
+  for (auto _ : state) {
+    if (is_writer) {
+      auto guard = guarded->with_exclusive();
+      guard->push_back(i++);
+    } else {
+      const auto guard = guarded->with_shared();
+      int64_t sum = 0;
+      for (std::size_t j = guard->size() - kNumRecent; j < guard->size();
+           ++j) {
+        sum += (*guard)[j];
+      }
+      benchmark::DoNotOptimize(sum);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ConcurrentVector_Fixture, Guarded)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ConcurrentVector_Fixture, ConcurrentVector)
+(benchmark::State& state) {
+  const bool is_writer = state.thread_index() == 0;
+  int64_t i = 0;
+  for (auto _ : state) {
+    if (is_writer) {
+      concurrent->push_back(i++);
+    } else {
+      const std::size_t size = concurrent->size();
+      int64_t sum = 0;
+      for (std::size_t j = size - kNumRecent; j < size; ++j) {
+        sum += (*concurrent)[j];
+      }
+      benchmark::DoNotOptimize(sum);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ConcurrentVector_Fixture, ConcurrentVector)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// Every thread appends.
+BENCHMARK_DEFINE_F(BM_ConcurrentVector_Fixture, GuardedPushBack)
+(benchmark::State& state) {
+  int64_t i = 0;
+  for (auto _ : state) {
+    auto guard = guarded->with_exclusive();
+    guard->push_back(i++);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ConcurrentVector_Fixture, GuardedPushBack)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ConcurrentVector_Fixture, ConcurrentVectorPushBack)
+(benchmark::State& state) {
+  int64_t i = 0;
+  for (auto _ : state) {
+    concurrent->push_back(i++);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ConcurrentVector_Fixture, ConcurrentVectorPushBack)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+#include <lockables/double_buffered.hpp>
+#include <lockables/guarded.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <shared_mutex>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kIndexSize = 1 << 16;
+constexpr std::size_t kLookupsPerIteration = 64;
+
+using Index = std::vector<int64_t>;
+
+// Bulk rebuild, fill with new keys and sort.
+void rebuild(Index& index, std::mt19937_64& rng) {
+  index.resize(kIndexSize);
+  for (auto& key : index) {
+    key = static_cast<int64_t>(rng() % (kIndexSize * 4));
+  }
+  std::sort(index.begin(), index.end());
+}
+
+// Reader latency. Time every lookup and keep the mean and the worst one.
+class Stalls {
+ public:
+  template <typename F>
+  void time(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    total_ += elapsed.count();
+    max_ = std::max(max_, elapsed.count());
+    ++count_;
+  }
+
+  void set_counters(benchmark::State& state) const {
+    state.counters["lookup_mean_us"] = total_ / static_cast<double>(count_);
+    state.counters["lookup_max_us"] = max_;
+  }
+
+ private:
+  double total_{};
+  double max_{};
+  std::size_t count_{};
+};
+
+}  // namespace
+
+// Periodic bulk rebuild. One writer thread rebuilds a sorted index of 64K keys
+// in every iteration, one reader thread looks up keys. Reports the mean and
+// worst lookup latency of the reader in microseconds.
+//
+// Compare Guarded<Index, std::shared_mutex>, where the writer rebuilds inside
+// with_exclusive() and readers stall for the whole rebuild, to DoubleBuffered,
+// where the writer rebuilds the back buffer and readers never wait.
+struct BM_DoubleBuffered_Fixture : benchmark::Fixture {
+  std::unique_ptr<lockables::Guarded<Index, std::shared_mutex>> guarded{};
+  std::unique_ptr<lockables::DoubleBuffered<Index>> buffered{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    std::mt19937_64 rng{1};
+    Index index;
+    rebuild(index, rng);
+
+    guarded =
+        std::make_unique<lockables::Guarded<Index, std::shared_mutex>>(index);
+    buffered = std::make_unique<lockables::DoubleBuffered<Index>>(index);
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded.reset();
+    buffered.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_DoubleBuffered_Fixture, Guarded)
+(benchmark::State& state) {
+  std::mt19937_64 rng{static_cast<std::uint64_t>(state.thread_index()) + 1};
+  if (state.thread_index() == 0) {
+    for (auto _ : state) {
+      auto guard = guarded->with_exclusive();
+      rebuild(*guard, rng);
+    }
+  } else {
+    Stalls stalls;
+    for (auto _ : state) {
+      for (std::size_t i = 0; i < kLookupsPerIteration; ++i) {
+        const auto key = static_cast<int64_t>(rng() % (kIndexSize * 4));
+        stalls.time([&]() {
+          const auto guard = guarded->with_shared();
+          benchmark::DoNotOptimize(
+              std::binary_search(guard->begin(), guard->end(), key));
+        });
+      }
+    }
+
+    stalls.set_counters(state);
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_DoubleBuffered_Fixture, Guarded)
+    ->Threads(2)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_DoubleBuffered_Fixture, DoubleBuffered)
+(benchmark::State& state) {
+  std::mt19937_64 rng{static_cast<std::uint64_t>(state.thread_index()) + 1};
+  if (state.thread_index() == 0) {
+    for (auto _ : state) {
+      buffered->update([&](Index& index) { rebuild(index, rng); });
+    }
+  } else {
+    Stalls stalls;
+    for (auto _ : state) {
+      for (std::size_t i = 0; i < kLookupsPerIteration; ++i) {
+        const auto key = static_cast<int64_t>(rng() % (kIndexSize * 4));
+        stalls.time([&]() {
+          const auto guard = buffered->with_shared();
+          benchmark::DoNotOptimize(
+              std::binary_search(guard->begin(), guard->end(), key));
+        });
+      }
+    }
+
+    stalls.set_counters(state);
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_DoubleBuffered_Fixture, DoubleBuffered)
+    ->Threads(2)
+    ->UseRealTime();
@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+#include <lockables/epoch.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+
+// Cost of entering and leaving a read side critical section. Compare the
+// EpochDomain pin to a shared lock on one std::shared_mutex.
+struct BM_Epoch_Fixture : benchmark::Fixture {
+  std::unique_ptr<lockables::EpochDomain> domain{};
+  std::unique_ptr<std::shared_mutex> mutex{};
+  std::unique_ptr<std::atomic<int64_t*>> shared{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    domain = std::make_unique<lockables::EpochDomain>(
+        lockables::EpochDomain::kDefaultBatchSize,
+        static_cast<std::size_t>(state.range(0)));
+    mutex = std::make_unique<std::shared_mutex>();
+    shared = std::make_unique<std::atomic<int64_t*>>(new int64_t{});
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    delete shared->load();
+    shared.reset();
+    mutex.reset();
+    domain.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_Epoch_Fixture, SharedLock)(benchmark::State& state) {
+  for (auto _ : state) {
+    std::shared_lock lock{*mutex};
+    benchmark::DoNotOptimize(*shared->load(std::memory_order_acquire));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Epoch_Fixture, SharedLock)
+    ->Arg(0)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_Epoch_Fixture, Pin)(benchmark::State& state) {
+  for (auto _ : state) {
+    auto guard = domain->pin();
+    benchmark::DoNotOptimize(*shared->load(std::memory_order_acquire));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Epoch_Fixture, Pin)
+    ->Arg(0)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// Retire throughput. Every thread replaces the shared value and retires the
+// old one. The argument is max_retired, zero is unbounded. Reports the number
+// of retired values that were not freed yet at the end of the run.
+BENCHMARK_DEFINE_F(BM_Epoch_Fixture, Retire)(benchmark::State& state) {
+  for (auto _ : state) {
+    int64_t* old = shared->exchange(new int64_t{}, std::memory_order_acq_rel);
+    domain->retire(old);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  // Thread 0 owns the domain, the other threads may be past TearDown.
+  if (state.thread_index() == 0) {
+    state.counters["retired"] =
+        static_cast<double>(domain->retired_approx());
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_Epoch_Fixture, Retire)
+    ->Arg(0)
+    ->Arg(256)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// Readers pin and load the shared value while thread 0 replaces it and
+// retires the old one.
+BENCHMARK_DEFINE_F(BM_Epoch_Fixture, ReadRetire)(benchmark::State& state) {
+  const bool is_writer = state.thread_index() == 0;
+  for (auto _ : state) {
+    if (is_writer) {
+      int64_t* old =
+          shared->exchange(new int64_t{}, std::memory_order_acq_rel);
+      domain->retire(old);
+    } else {
+      auto guard = domain->pin();
+      benchmark::DoNotOptimize(*shared->load(std::memory_order_acquire));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Epoch_Fixture, ReadRetire)
+    ->Arg(0)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
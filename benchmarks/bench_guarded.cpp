@@ -1,5 +1,51 @@
 #include <benchmark/benchmark.h>
 #include <lockables/guarded.hpp>
+#include <lockables/instrumented_mutex.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using Entry = lockables::LockRegistry::Entry;
+
+// Histograms of the mutex that was locked the most between two snapshots of
+// the registry, with the values from before removed.
+lockables::LockHistograms interval(const std::vector<Entry>& before,
+                                   const std::vector<Entry>& after) {
+  lockables::LockHistograms result{};
+  std::uint64_t most = 0;
+  for (const auto& entry : after) {
+    lockables::LockHistograms delta = entry.histograms;
+    for (const auto& old : before) {
+      if (old.id == entry.id) {
+        delta.wait.subtract(old.histograms.wait);
+        delta.hold.subtract(old.histograms.hold);
+      }
+    }
+
+    if (delta.wait.count() > most) {
+      most = delta.wait.count();
+      result = delta;
+    }
+  }
+
+  return result;
+}
+
+void set_percentiles(benchmark::State& state,
+                     const lockables::LockHistograms& histograms) {
+  const auto& wait = histograms.wait;
+  const auto& hold = histograms.hold;
+  state.counters["wait_p50"] = static_cast<double>(wait.percentile(50.0));
+  state.counters["wait_p99"] = static_cast<double>(wait.percentile(99.0));
+  state.counters["wait_p999"] = static_cast<double>(wait.percentile(99.9));
+  state.counters["hold_p50"] = static_cast<double>(hold.percentile(50.0));
+  state.counters["hold_p99"] = static_cast<double>(hold.percentile(99.0));
+  state.counters["hold_p999"] = static_cast<double>(hold.percentile(99.9));
+}
+
+}  // namespace
 
 template <typename T, typename Mutex>
 void BM_Guarded_Shared(benchmark::State& state) {
@@ -126,3 +172,46 @@ BENCHMARK_REGISTER_F(BM_Guarded_Fixture, Shared)
     ->Arg(2)
     ->Arg(4)
     ->Arg(8);
+
+// Histogram mode, run with --benchmark_filter=Histogram. Same as the fixture
+// above with an InstrumentedMutex. Reports the p50, p99, and p99.9 wait and
+// hold times of the run in nanoseconds.
+template <typename Mutex>
+struct BM_Guarded_Histogram_Fixture
+    : BM_Guarded_Fixture<lockables::InstrumentedMutex<Mutex>> {
+  using Base = BM_Guarded_Fixture<lockables::InstrumentedMutex<Mutex>>;
+
+  void RunHistogram(benchmark::State& state) {
+    if (state.thread_index() != 0) {
+      Base::BenchmarkCase(state);
+      return;
+    }
+
+    // Benchmark starts and stops all threads together, the snapshots only
+    // cover the state loop.
+    auto& registry = lockables::LockRegistry::instance();
+    const auto before = registry.snapshot();
+    Base::BenchmarkCase(state);
+    set_percentiles(state, interval(before, registry.snapshot()));
+  }
+};
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_Guarded_Histogram_Fixture, ScopedHistogram,
+                            std::mutex)
+(benchmark::State& state) { this->RunHistogram(state); }
+
+BENCHMARK_REGISTER_F(BM_Guarded_Histogram_Fixture, ScopedHistogram)
+    ->ThreadRange(4, 16)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8);
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_Guarded_Histogram_Fixture, SharedHistogram,
+                            std::shared_mutex)
+(benchmark::State& state) { this->RunHistogram(state); }
+
+BENCHMARK_REGISTER_F(BM_Guarded_Histogram_Fixture, SharedHistogram)
+    ->ThreadRange(4, 16)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8);
@@ -0,0 +1,119 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/guarded_map.hpp>
+
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "zipf.hpp"
+
+namespace {
+
+constexpr std::size_t kNumKey = 1 << 16;
+constexpr std::size_t kTraceLength = 1 << 16;
+constexpr double kSkew = 0.99;
+
+using Map = std::unordered_map<int64_t, int64_t>;
+
+}  // namespace
+
+// Session table workload. Zipfian keys, a percentage of the operations are
+// inserts/updates and the rest are lookups. The first argument is the write
+// percentage.
+//
+// Compare one Guarded<std::unordered_map, std::shared_mutex> to the striped
+// GuardedMap.
+struct BM_Map_Fixture : benchmark::Fixture {
+  lockables::Guarded<Map, std::shared_mutex> guarded{};
+  lockables::GuardedMap<int64_t, int64_t> striped{64};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    auto guard = guarded.with_exclusive();
+    guard->clear();
+    striped.with_all_exclusive([](Map& segment) { segment.clear(); });
+
+    for (std::size_t i = 0; i < kNumKey; i += 2) {
+      const auto key = static_cast<int64_t>(i);
+      guard->emplace(key, key);
+      striped.with_exclusive(key,
+                             [key](Map& segment) { segment.emplace(key, key); });
+    }
+  }
+
+  static std::vector<int64_t> make_trace(const benchmark::State& state) {
+    return bench::make_zipf_trace(
+        kNumKey, kSkew, kTraceLength,
+        static_cast<std::uint64_t>(state.thread_index()) + 1);
+  }
+
+  static bool is_write(const benchmark::State& state, std::size_t i) {
+    return static_cast<int64_t>(i % 100) < state.range(0);
+  }
+
+  void RunGuarded(benchmark::State& state) {
+    const auto trace = make_trace(state);
+    std::size_t i = 0;
+    for (auto _ : state) {
+      const int64_t key = trace[i % trace.size()];
+      if (is_write(state, i)) {
+        auto guard = guarded.with_exclusive();
+        (*guard)[key] += 1;
+      } else {
+        const auto guard = guarded.with_shared();
+        const auto itr = guard->find(key);
+        benchmark::DoNotOptimize(itr != guard->end() ? itr->second : 0);
+      }
+      ++i;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  void RunStriped(benchmark::State& state) {
+    const auto trace = make_trace(state);
+    std::size_t i = 0;
+    for (auto _ : state) {
+      const int64_t key = trace[i % trace.size()];
+      if (is_write(state, i)) {
+        striped.with_exclusive(key, [key](Map& segment) { segment[key] += 1; });
+      } else {
+        benchmark::DoNotOptimize(
+            striped.with_shared(key, [key](const Map& segment) -> int64_t {
+              const auto itr = segment.find(key);
+              return itr != segment.end() ? itr->second : 0;
+            }));
+      }
+      ++i;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_Map_Fixture, Guarded)(benchmark::State& state) {
+  RunGuarded(state);
+}
+
+// Run 1-16 threads with [0, 10, 50] percent writes.
+BENCHMARK_REGISTER_F(BM_Map_Fixture, Guarded)
+    ->ThreadRange(1, 16)
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(50);
+
+BENCHMARK_DEFINE_F(BM_Map_Fixture, GuardedMap)(benchmark::State& state) {
+  RunStriped(state);
+}
+
+// Run 1-16 threads with [0, 10, 50] percent writes.
+BENCHMARK_REGISTER_F(BM_Map_Fixture, GuardedMap)
+    ->ThreadRange(1, 16)
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(50);
@@ -0,0 +1,213 @@
+#include <benchmark/benchmark.h>
+#include <lockables/epoch.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/hazard_pointer.hpp>
+#include <lockables/snapshot.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+// Compare hazard pointers to epoch based reclamation. All threads share one
+// value that writers replace and retire.
+struct BM_Reclaim_Fixture : benchmark::Fixture {
+  std::unique_ptr<lockables::HazardDomain> hazard_domain{};
+  std::unique_ptr<lockables::EpochDomain> epoch_domain{};
+  std::unique_ptr<std::atomic<int64_t*>> shared{};
+  // One hazard pointer per thread. Owned by the fixture since the other
+  // threads may still be running after thread 0 calls TearDown.
+  std::vector<std::unique_ptr<lockables::HazardPointer>> hazards{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    hazard_domain = std::make_unique<lockables::HazardDomain>();
+    epoch_domain = std::make_unique<lockables::EpochDomain>();
+    shared = std::make_unique<std::atomic<int64_t*>>(new int64_t{});
+    for (int i = 0; i < state.threads(); ++i) {
+      hazards.push_back(
+          std::make_unique<lockables::HazardPointer>(*hazard_domain));
+    }
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    hazards.clear();
+    delete shared->load();
+    shared.reset();
+    epoch_domain.reset();
+    hazard_domain.reset();
+  }
+
+  // Thread 0 is the stalled reader. It holds on to one value for the whole
+  // run and samples the number of retired values that are not freed yet.
+  template <typename Domain>
+  static void report_high_water(benchmark::State& state, Domain& domain,
+                                std::size_t high_water) {
+    if (state.thread_index() == 0) {
+      state.counters["high_water"] = static_cast<double>(
+          std::max(high_water, domain.retired_approx()));
+    }
+  }
+};
+
+// Cost of protecting one pointer. The hazard pointer is created once per
+// thread.
+BENCHMARK_DEFINE_F(BM_Reclaim_Fixture, Protect)(benchmark::State& state) {
+  // Thread 0 creates the hazard pointers in SetUp, they are ready once the
+  // loop starts.
+  const auto index = static_cast<std::size_t>(state.thread_index());
+  for (auto _ : state) {
+    const int64_t* value = hazards[index]->protect(*shared);
+    benchmark::DoNotOptimize(*value);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Reclaim_Fixture, Protect)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_Reclaim_Fixture, Pin)(benchmark::State& state) {
+  for (auto _ : state) {
+    auto guard = epoch_domain->pin();
+    benchmark::DoNotOptimize(*shared->load(std::memory_order_acquire));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Reclaim_Fixture, Pin)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// Memory high water mark with one stalled reader. The other threads replace
+// the shared value and retire the old one.
+BENCHMARK_DEFINE_F(BM_Reclaim_Fixture, StalledHazard)
+(benchmark::State& state) {
+  std::size_t high_water = 0;
+  if (state.thread_index() == 0) {
+    auto hazard = hazard_domain->make_hazard_pointer();
+    const int64_t* value = hazard.protect(*shared);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(*value);
+      high_water = std::max(high_water, hazard_domain->retired_approx());
+      std::this_thread::yield();
+    }
+  } else {
+    for (auto _ : state) {
+      int64_t* old =
+          shared->exchange(new int64_t{}, std::memory_order_acq_rel);
+      hazard_domain->retire(old);
+    }
+  }
+
+  report_high_water(state, *hazard_domain, high_water);
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Reclaim_Fixture, StalledHazard)
+    ->ThreadRange(2, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_Reclaim_Fixture, StalledEpoch)
+(benchmark::State& state) {
+  std::size_t high_water = 0;
+  if (state.thread_index() == 0) {
+    auto guard = epoch_domain->pin();
+    const int64_t* value = shared->load(std::memory_order_acquire);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(*value);
+      high_water = std::max(high_water, epoch_domain->retired_approx());
+      std::this_thread::yield();
+    }
+  } else {
+    for (auto _ : state) {
+      int64_t* old =
+          shared->exchange(new int64_t{}, std::memory_order_acq_rel);
+      epoch_domain->retire(old);
+    }
+  }
+
+  report_high_water(state, *epoch_domain, high_water);
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Reclaim_Fixture, StalledEpoch)
+    ->ThreadRange(2, 64)
+    ->UseRealTime();
+
+// Read mostly value. Thread 0 writes, the other threads read.
+//
+// Compare Guarded<int64_t, std::shared_mutex> to the Snapshot.
+struct BM_Snapshot_Fixture : benchmark::Fixture {
+  std::unique_ptr<lockables::Guarded<int64_t, std::shared_mutex>> guarded{};
+  std::unique_ptr<lockables::Snapshot<int64_t>> snapshot{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded =
+        std::make_unique<lockables::Guarded<int64_t, std::shared_mutex>>();
+    snapshot = std::make_unique<lockables::Snapshot<int64_t>>();
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded.reset();
+    snapshot.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_Snapshot_Fixture, Guarded)(benchmark::State& state) {
+  const bool is_writer = state.thread_index() == 0;
+  for (auto _ : state) {
+    if (is_writer) {
+      auto guard = guarded->with_exclusive();
+      *guard += 1;
+    } else {
+      const auto guard = guarded->with_shared();
+      benchmark::DoNotOptimize(*guard);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Snapshot_Fixture, Guarded)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_Snapshot_Fixture, Snapshot)(benchmark::State& state) {
+  const bool is_writer = state.thread_index() == 0;
+  for (auto _ : state) {
+    if (is_writer) {
+      snapshot->update([](int64_t& x) { x += 1; });
+    } else {
+      const auto guard = snapshot->with_shared();
+      benchmark::DoNotOptimize(*guard);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Snapshot_Fixture, Snapshot)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/instrumented_mutex.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+namespace {
+
+using InstrumentedMutex = lockables::InstrumentedMutex<std::mutex>;
+using InstrumentedSharedMutex = lockables::InstrumentedMutex<std::shared_mutex>;
+
+}  // namespace
+
+// Cost of the instrumentation without contention, compare to the plain mutex.
+template <typename Mutex>
+void BM_Instrumented_Exclusive(benchmark::State& state) {
+  lockables::Guarded<int64_t, Mutex> value;
+  for (auto _ : state) {
+    auto guard = value.with_exclusive();
+    *guard += 1;
+    benchmark::DoNotOptimize(*guard);
+  }
+}
+
+BENCHMARK(BM_Instrumented_Exclusive<std::mutex>);
+BENCHMARK(BM_Instrumented_Exclusive<InstrumentedMutex>);
+
+template <typename Mutex>
+void BM_Instrumented_Shared(benchmark::State& state) {
+  lockables::Guarded<int64_t, Mutex> value;
+  for (auto _ : state) {
+    const auto guard = value.with_shared();
+    benchmark::DoNotOptimize(*guard);
+  }
+}
+
+BENCHMARK(BM_Instrumented_Shared<std::shared_mutex>);
+BENCHMARK(BM_Instrumented_Shared<InstrumentedSharedMutex>);
+
+// One thread locks many mutexes in turn, each one nested inside the previous
+// one. The argument is the number of mutexes. Finding the per thread record
+// of each mutex must not get slower with more of them.
+template <typename Mutex>
+void BM_Instrumented_Many(benchmark::State& state) {
+  const auto num_mutex = static_cast<std::size_t>(state.range(0));
+  const auto values =
+      std::make_unique<lockables::Guarded<int64_t, Mutex>[]>(num_mutex);
+
+  std::size_t index = 0;
+  for (auto _ : state) {
+    auto outer = values[index].with_exclusive();
+    index = (index + 1) % num_mutex;
+    auto inner = values[index].with_exclusive();
+    *inner += *outer;
+    benchmark::DoNotOptimize(*inner);
+  }
+
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+
+BENCHMARK(BM_Instrumented_Many<std::mutex>)->RangeMultiplier(8)->Range(2, 1024);
+BENCHMARK(BM_Instrumented_Many<InstrumentedMutex>)
+    ->RangeMultiplier(8)
+    ->Range(2, 1024);
+
+// Cost of the instrumentation with contention. All threads increment one
+// value. The per thread records keep the counters off the contended line.
+template <typename Mutex>
+struct BM_Instrumented_Fixture : benchmark::Fixture {
+  std::unique_ptr<lockables::Guarded<int64_t, Mutex>> value{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    value = std::make_unique<lockables::Guarded<int64_t, Mutex>>();
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    value.reset();
+  }
+
+  void run(benchmark::State& state) {
+    for (auto _ : state) {
+      auto guard = value->with_exclusive();
+      *guard += 1;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+  }
+};
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_Instrumented_Fixture, Mutex, std::mutex)
+(benchmark::State& state) { this->run(state); }
+
+BENCHMARK_REGISTER_F(BM_Instrumented_Fixture, Mutex)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_Instrumented_Fixture, InstrumentedMutex,
+                            InstrumentedMutex)
+(benchmark::State& state) { this->run(state); }
+
+BENCHMARK_REGISTER_F(BM_Instrumented_Fixture, InstrumentedMutex)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/lock_order.hpp>
+
+#include <cstdint>
+#include <mutex>
+
+namespace {
+
+using CheckedMutex = lockables::CheckedMutex<std::mutex>;
+
+}  // namespace
+
+// Cost of the lock order check for nested locks, compare to the plain mutex.
+// After the first iteration the order is known and the check is a thread local
+// lookup.
+template <typename Mutex>
+void BM_LockOrder_Nested(benchmark::State& state) {
+  lockables::Guarded<int64_t, Mutex> value1;
+  lockables::Guarded<int64_t, Mutex> value2;
+  for (auto _ : state) {
+    auto guard1 = value1.with_exclusive();
+    auto guard2 = value2.with_exclusive();
+    *guard2 += *guard1 + 1;
+    benchmark::DoNotOptimize(*guard2);
+  }
+}
+
+BENCHMARK(BM_LockOrder_Nested<std::mutex>)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_LockOrder_Nested<CheckedMutex>)->ThreadRange(1, 64)->UseRealTime();
+
+// The free with_exclusive function only uses blocking locks while it holds
+// none of the locks, so the check does not visit the held locks.
+template <typename Mutex>
+void BM_LockOrder_Multiple(benchmark::State& state) {
+  lockables::Guarded<int64_t, Mutex> value1;
+  lockables::Guarded<int64_t, Mutex> value2;
+  for (auto _ : state) {
+    const int64_t sum = lockables::with_exclusive(
+        [](int64_t& x, int64_t& y) { return x + y; }, value1, value2);
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+BENCHMARK(BM_LockOrder_Multiple<std::mutex>);
+BENCHMARK(BM_LockOrder_Multiple<CheckedMutex>);
@@ -0,0 +1,99 @@
+#include <benchmark/benchmark.h>
+#include <lockables/lock_table.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "zipf.hpp"
+
+namespace {
+
+constexpr std::size_t kNumKey = 1 << 16;
+constexpr std::size_t kTraceLength = 1 << 16;
+
+}  // namespace
+
+// Stripe count versus contention. Threads increment counters in an external
+// array, one per key, under an exclusive lock on the stripe of the key. The
+// argument is the zipf skew times 100, 0 is uniform keys and 99 sends most of
+// the traffic to a few hot keys.
+//
+// One stripe is the same as one global mutex. More stripes help the uniform
+// keys until the threads stop sharing mutexes, but do not help the hot keys
+// which collide on the same stripe no matter the stripe count.
+template <std::size_t N>
+struct BM_LockTable_Fixture : benchmark::Fixture {
+  std::unique_ptr<lockables::LockTable<std::mutex, N>> locks{};
+  std::unique_ptr<std::vector<int64_t>> counters{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    locks = std::make_unique<lockables::LockTable<std::mutex, N>>();
+    counters = std::make_unique<std::vector<int64_t>>(kNumKey);
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    locks.reset();
+    counters.reset();
+  }
+
+  void run(benchmark::State& state) {
+    const auto trace = bench::make_zipf_trace(
+        kNumKey, static_cast<double>(state.range(0)) / 100.0, kTraceLength,
+        static_cast<std::uint64_t>(state.thread_index()) + 1);
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+      const auto key = static_cast<std::size_t>(trace[i++ % trace.size()]);
+      locks->with_exclusive(key, [&]() { ++(*counters)[key]; });
+    }
+
+    state.SetItemsProcessed(state.iterations());
+  }
+};
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_LockTable_Fixture, Stripes1, 1)
+(benchmark::State& state) { this->run(state); }
+
+BENCHMARK_REGISTER_F(BM_LockTable_Fixture, Stripes1)
+    ->Arg(0)
+    ->Arg(99)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_LockTable_Fixture, Stripes16, 16)
+(benchmark::State& state) { this->run(state); }
+
+BENCHMARK_REGISTER_F(BM_LockTable_Fixture, Stripes16)
+    ->Arg(0)
+    ->Arg(99)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_LockTable_Fixture, Stripes256, 256)
+(benchmark::State& state) { this->run(state); }
+
+BENCHMARK_REGISTER_F(BM_LockTable_Fixture, Stripes256)
+    ->Arg(0)
+    ->Arg(99)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_LockTable_Fixture, Stripes4096, 4096)
+(benchmark::State& state) { this->run(state); }
+
+BENCHMARK_REGISTER_F(BM_LockTable_Fixture, Stripes4096)
+    ->Arg(0)
+    ->Arg(99)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
@@ -0,0 +1,244 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/mpmc_queue.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t kCapacity = 1024;
+
+// Bounded queue built the usual way, a std::deque behind one mutex.
+template <typename T>
+class GuardedQueue {
+ public:
+  explicit GuardedQueue(std::size_t capacity) : capacity_{capacity} {}
+
+  bool try_push(T value) {
+    auto guard = queue_.with_exclusive();
+    if (guard->size() >= capacity_) {
+      return false;
+    }
+
+    guard->push_back(std::move(value));
+    return true;
+  }
+
+  bool try_pop(T& value) {
+    auto guard = queue_.with_exclusive();
+    if (guard->empty()) {
+      return false;
+    }
+
+    value = std::move(guard->front());
+    guard->pop_front();
+    return true;
+  }
+
+ private:
+  lockables::Guarded<std::deque<T>> queue_{};
+  std::size_t capacity_;
+};
+
+template <typename Queue, typename T>
+void spin_push(Queue& queue, T value) {
+  while (!queue.try_push(value)) {
+    std::this_thread::yield();
+  }
+}
+
+template <typename Queue, typename T>
+void spin_pop(Queue& queue, T& value) {
+  while (!queue.try_pop(value)) {
+    std::this_thread::yield();
+  }
+}
+
+}  // namespace
+
+// Throughput. Even numbered threads are producers, odd numbered threads are
+// consumers. Every thread runs the same number of iterations so the queue is
+// empty at the end of each run.
+struct BM_MpmcQueue_Fixture : benchmark::Fixture {
+  std::unique_ptr<GuardedQueue<int64_t>> guarded{};
+  std::unique_ptr<lockables::MpmcQueue<int64_t>> mpmc{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded = std::make_unique<GuardedQueue<int64_t>>(kCapacity);
+    mpmc = std::make_unique<lockables::MpmcQueue<int64_t>>(kCapacity);
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded.reset();
+    mpmc.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_MpmcQueue_Fixture, Guarded)(benchmark::State& state) {
+  const bool is_producer = state.thread_index() % 2 == 0;
+  int64_t value = 0;
+  for (auto _ : state) {
+    if (is_producer) {
+      spin_push(*guarded, value++);
+    } else {
+      spin_pop(*guarded, value);
+      benchmark::DoNotOptimize(value);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_MpmcQueue_Fixture, Guarded)
+    ->ThreadRange(2, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_MpmcQueue_Fixture, MpmcQueue)(benchmark::State& state) {
+  const bool is_producer = state.thread_index() % 2 == 0;
+  int64_t value = 0;
+  for (auto _ : state) {
+    if (is_producer) {
+      spin_push(*mpmc, value++);
+    } else {
+      spin_pop(*mpmc, value);
+      benchmark::DoNotOptimize(value);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_MpmcQueue_Fixture, MpmcQueue)
+    ->ThreadRange(2, 64)
+    ->UseRealTime();
+
+// Same as above but park the thread with the blocking push and pop.
+BENCHMARK_DEFINE_F(BM_MpmcQueue_Fixture, MpmcQueueBlocking)
+(benchmark::State& state) {
+  const bool is_producer = state.thread_index() % 2 == 0;
+  int64_t value = 0;
+  for (auto _ : state) {
+    if (is_producer) {
+      mpmc->push(value++);
+    } else {
+      mpmc->pop(value);
+      benchmark::DoNotOptimize(value);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_MpmcQueue_Fixture, MpmcQueueBlocking)
+    ->ThreadRange(2, 64)
+    ->UseRealTime();
+
+// Batches of 32 elements per call.
+BENCHMARK_DEFINE_F(BM_MpmcQueue_Fixture, MpmcQueueBatch)
+(benchmark::State& state) {
+  constexpr std::size_t kBatchSize = 32;
+
+  const bool is_producer = state.thread_index() % 2 == 0;
+  int64_t batch[kBatchSize] = {};
+  for (auto _ : state) {
+    if (is_producer) {
+      mpmc->push_n(batch, kBatchSize);
+    } else {
+      std::size_t count = 0;
+      while (count < kBatchSize) {
+        count += mpmc->pop_n(batch + count, kBatchSize - count);
+      }
+      benchmark::DoNotOptimize(batch);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(kBatchSize));
+}
+
+BENCHMARK_REGISTER_F(BM_MpmcQueue_Fixture, MpmcQueueBatch)
+    ->ThreadRange(2, 64)
+    ->UseRealTime();
+
+// Latency. Two threads pass one element back and forth through a pair of
+// queues. Each iteration is one round trip.
+struct BM_MpmcQueue_PingPong_Fixture : benchmark::Fixture {
+  std::unique_ptr<GuardedQueue<int64_t>> guarded[2]{};
+  std::unique_ptr<lockables::MpmcQueue<int64_t>> mpmc[2]{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    for (int i = 0; i < 2; ++i) {
+      guarded[i] = std::make_unique<GuardedQueue<int64_t>>(kCapacity);
+      mpmc[i] = std::make_unique<lockables::MpmcQueue<int64_t>>(kCapacity);
+    }
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    for (int i = 0; i < 2; ++i) {
+      guarded[i].reset();
+      mpmc[i].reset();
+    }
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_MpmcQueue_PingPong_Fixture, Guarded)
+(benchmark::State& state) {
+  const auto index = static_cast<std::size_t>(state.thread_index());
+  auto& in = *guarded[index];
+  auto& out = *guarded[1 - index];
+  int64_t value = 0;
+  for (auto _ : state) {
+    if (index == 0) {
+      spin_push(out, value);
+      spin_pop(in, value);
+    } else {
+      spin_pop(in, value);
+      spin_push(out, value + 1);
+    }
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_MpmcQueue_PingPong_Fixture, Guarded)
+    ->Threads(2)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_MpmcQueue_PingPong_Fixture, MpmcQueue)
+(benchmark::State& state) {
+  const auto index = static_cast<std::size_t>(state.thread_index());
+  auto& in = *mpmc[index];
+  auto& out = *mpmc[1 - index];
+  int64_t value = 0;
+  for (auto _ : state) {
+    if (index == 0) {
+      spin_push(out, value);
+      spin_pop(in, value);
+    } else {
+      spin_pop(in, value);
+      spin_push(out, value + 1);
+    }
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_MpmcQueue_PingPong_Fixture, MpmcQueue)
+    ->Threads(2)
+    ->UseRealTime();
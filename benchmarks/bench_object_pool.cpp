@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/object_pool.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kBufferSize = 4096;
+
+using Buffer = std::vector<char>;
+using GuardedBuffer = lockables::Guarded<Buffer>;
+
+}  // namespace
+
+// Request handling. Each iteration allocates range(0) guarded buffers, fills
+// them, and then frees them all.
+//
+// Compare std::make_unique<Guarded<Buffer>> to the ObjectPool, which recycles
+// the guarded buffers and their capacity.
+struct BM_ObjectPool_Fixture : benchmark::Fixture {
+  std::unique_ptr<lockables::ObjectPool<Buffer>> pool{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    pool = std::make_unique<lockables::ObjectPool<Buffer>>();
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    pool.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_ObjectPool_Fixture, New)(benchmark::State& state) {
+  const auto num_buffer = static_cast<std::size_t>(state.range(0));
+  std::vector<std::unique_ptr<GuardedBuffer>> buffers;
+  buffers.reserve(num_buffer);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < num_buffer; ++i) {
+      buffers.push_back(std::make_unique<GuardedBuffer>());
+      auto guard = buffers.back()->with_exclusive();
+      guard->resize(kBufferSize);
+      benchmark::DoNotOptimize(guard->data());
+    }
+
+    buffers.clear();
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_REGISTER_F(BM_ObjectPool_Fixture, New)
+    ->Arg(1)
+    ->Arg(64)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ObjectPool_Fixture, Pool)(benchmark::State& state) {
+  const auto num_buffer = static_cast<std::size_t>(state.range(0));
+  std::vector<lockables::ObjectPool<Buffer>::Handle> buffers;
+  buffers.reserve(num_buffer);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < num_buffer; ++i) {
+      buffers.push_back(pool->acquire());
+      auto guard = buffers.back()->with_exclusive();
+      guard->resize(kBufferSize);
+      benchmark::DoNotOptimize(guard->data());
+    }
+
+    buffers.clear();
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_REGISTER_F(BM_ObjectPool_Fixture, Pool)
+    ->Arg(1)
+    ->Arg(64)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
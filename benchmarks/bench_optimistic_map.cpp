@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/optimistic_map.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+using Map = std::unordered_map<int64_t, int64_t>;
+
+// Five percent writes, the rest are lookups.
+constexpr int64_t kWritePercent = 5;
+
+}  // namespace
+
+// Lookup dominated cache workload. The first argument is the number of
+// entries. Keys are uniform over twice the number of entries so about half of
+// the lookups miss.
+//
+// Compare Guarded<std::unordered_map, std::shared_mutex> to the OptimisticMap.
+//
+// The largest registered size is 1M entries. For 100M entries, raise the
+// Range below; the two maps need on the order of 10 GB together.
+struct BM_OptimisticMap_Fixture : benchmark::Fixture {
+  std::unique_ptr<lockables::Guarded<Map, std::shared_mutex>> guarded{};
+  std::unique_ptr<lockables::OptimisticMap<int64_t, int64_t>> optimistic{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    const auto num_entry = state.range(0);
+
+    guarded = std::make_unique<lockables::Guarded<Map, std::shared_mutex>>();
+    optimistic = std::make_unique<lockables::OptimisticMap<int64_t, int64_t>>(
+        static_cast<std::size_t>(num_entry) * 2);
+
+    auto guard = guarded->with_exclusive();
+    guard->reserve(static_cast<std::size_t>(num_entry));
+    for (int64_t key = 0; key < num_entry; ++key) {
+      guard->emplace(key * 2, key);
+      optimistic->with_exclusive(key * 2, [key](int64_t& value) {
+        value = key;
+      });
+    }
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded.reset();
+    optimistic.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_OptimisticMap_Fixture, Guarded)
+(benchmark::State& state) {
+  std::mt19937_64 gen{static_cast<std::uint64_t>(state.thread_index())};
+  std::uniform_int_distribution<int64_t> dist{0, state.range(0) * 2 - 1};
+  int64_t i = 0;
+  for (auto _ : state) {
+    const int64_t key = dist(gen);
+    if (i++ % 100 < kWritePercent) {
+      auto guard = guarded->with_exclusive();
+      (*guard)[key] += 1;
+    } else {
+      const auto guard = guarded->with_shared();
+      const auto itr = guard->find(key);
+      benchmark::DoNotOptimize(itr != guard->end() ? itr->second : 0);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_OptimisticMap_Fixture, Guarded)
+    ->RangeMultiplier(32)
+    ->Range(1 << 10, 1 << 20)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_OptimisticMap_Fixture, OptimisticMap)
+(benchmark::State& state) {
+  std::mt19937_64 gen{static_cast<std::uint64_t>(state.thread_index())};
+  std::uniform_int_distribution<int64_t> dist{0, state.range(0) * 2 - 1};
+  int64_t i = 0;
+  for (auto _ : state) {
+    const int64_t key = dist(gen);
+    if (i++ % 100 < kWritePercent) {
+      optimistic->with_exclusive(key, [](int64_t& value) { value += 1; });
+    } else {
+      int64_t copy = 0;
+      optimistic->with_shared(key,
+                              [&copy](const int64_t& value) { copy = value; });
+      benchmark::DoNotOptimize(copy);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_OptimisticMap_Fixture, OptimisticMap)
+    ->RangeMultiplier(32)
+    ->Range(1 << 10, 1 << 20)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/ranked_mutex.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+template <unsigned Rank>
+using PlainMutex = std::mutex;
+
+// Unchecked, only the static lock order.
+template <unsigned Rank>
+using RankedMutex = lockables::RankedMutex<Rank, std::mutex, false>;
+
+template <template <unsigned> class MutexOf>
+struct Values {
+  lockables::Guarded<int64_t, MutexOf<1>> a{};
+  lockables::Guarded<int64_t, MutexOf<2>> b{};
+  lockables::Guarded<int64_t, MutexOf<3>> c{};
+  lockables::Guarded<int64_t, MutexOf<4>> d{};
+};
+
+}  // namespace
+
+// Lock four values at once with the free with_exclusive function. Half of the
+// threads pass the values in reverse order. std::scoped_lock locks one mutex,
+// tries the rest, and backs off if one is busy. Ranked mutexes are locked in
+// rank order, sorted at compile time, and never back off.
+template <template <unsigned> class MutexOf>
+struct BM_Ranked_Fixture : benchmark::Fixture {
+  std::unique_ptr<Values<MutexOf>> values{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    values = std::make_unique<Values<MutexOf>>();
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    values.reset();
+  }
+
+  void run(benchmark::State& state) {
+    const auto increment = [](auto&... x) { ((x += 1), ...); };
+    const bool reverse = state.thread_index() % 2 == 1;
+    for (auto _ : state) {
+      auto& [a, b, c, d] = *values;
+      if (reverse) {
+        lockables::with_exclusive(increment, d, c, b, a);
+      } else {
+        lockables::with_exclusive(increment, a, b, c, d);
+      }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+  }
+};
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_Ranked_Fixture, ScopedLock, PlainMutex)
+(benchmark::State& state) { this->run(state); }
+
+BENCHMARK_REGISTER_F(BM_Ranked_Fixture, ScopedLock)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_Ranked_Fixture, RankedLock, RankedMutex)
+(benchmark::State& state) { this->run(state); }
+
+BENCHMARK_REGISTER_F(BM_Ranked_Fixture, RankedLock)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
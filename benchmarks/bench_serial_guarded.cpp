@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/serial_guarded.hpp>
+
+#include <future>
+#include <vector>
+
+// Compare async_with_exclusive on a SerialGuarded<T> to the blocking
+// with_exclusive free function on a Guarded<T>. Both fixtures share the values
+// across the threads spawned by the benchmark library.
+struct BM_SerialGuarded_Fixture : benchmark::Fixture {
+  static constexpr int kBatchSize = 64;
+
+  lockables::ThreadPool pool{4};
+  lockables::SerialGuarded<int64_t> value1{pool};
+  lockables::SerialGuarded<int64_t> value2{pool};
+
+  void BenchmarkCase(benchmark::State& state) override {
+    std::vector<std::future<int64_t>> futures;
+    futures.reserve(kBatchSize);
+
+    // Queue a batch of callbacks and then wait for all of them. The caller is
+    // free to do other work in between.
+    for (auto _ : state) {
+      for (int i = 0; i < kBatchSize; ++i) {
+        futures.push_back(lockables::async_with_exclusive(
+            [](int64_t& x, int64_t& y) {
+              x += 1;
+              y += x;
+              return y;
+            },
+            value1, value2));
+      }
+
+      for (auto& future : futures) {
+        benchmark::DoNotOptimize(future.get());
+      }
+
+      futures.clear();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kBatchSize);
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_SerialGuarded_Fixture, AsyncWithExclusive)
+(benchmark::State& state) { BM_SerialGuarded_Fixture::BenchmarkCase(state); }
+
+BENCHMARK_REGISTER_F(BM_SerialGuarded_Fixture, AsyncWithExclusive)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+struct BM_Guarded_WithExclusive_Fixture : benchmark::Fixture {
+  static constexpr int kBatchSize = 64;
+
+  lockables::Guarded<int64_t> value1{};
+  lockables::Guarded<int64_t> value2{};
+
+  void BenchmarkCase(benchmark::State& state) override {
+    for (auto _ : state) {
+      for (int i = 0; i < kBatchSize; ++i) {
+        benchmark::DoNotOptimize(lockables::with_exclusive(
+            [](int64_t& x, int64_t& y) {
+              x += 1;
+              y += x;
+              return y;
+            },
+            value1, value2));
+      }
+    }
+
+    state.SetItemsProcessed(state.iterations() * kBatchSize);
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_Guarded_WithExclusive_Fixture, WithExclusive)
+(benchmark::State& state) {
+  BM_Guarded_WithExclusive_Fixture::BenchmarkCase(state);
+}
+
+BENCHMARK_REGISTER_F(BM_Guarded_WithExclusive_Fixture, WithExclusive)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
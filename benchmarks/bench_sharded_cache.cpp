@@ -0,0 +1,168 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/sharded_cache.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "zipf.hpp"
+
+namespace {
+
+constexpr std::size_t kNumKey = 1 << 16;
+constexpr std::size_t kCapacity = kNumKey / 8;
+constexpr std::size_t kTraceLength = 1 << 16;
+constexpr double kSkew = 0.99;
+
+// Classic LRU. Every hit moves the entry to the front of the list.
+class Lru {
+ public:
+  explicit Lru(std::size_t capacity) : capacity_{capacity} {}
+
+  std::optional<int64_t> get(int64_t key) {
+    const auto itr = index_.find(key);
+    if (itr == index_.end()) {
+      return std::nullopt;
+    }
+
+    items_.splice(items_.begin(), items_, itr->second);
+    return itr->second->second;
+  }
+
+  void put(int64_t key, int64_t value) {
+    if (const auto itr = index_.find(key); itr != index_.end()) {
+      itr->second->second = value;
+      items_.splice(items_.begin(), items_, itr->second);
+      return;
+    }
+
+    if (index_.size() == capacity_) {
+      index_.erase(items_.back().first);
+      items_.pop_back();
+    }
+
+    items_.emplace_front(key, value);
+    index_.emplace(key, items_.begin());
+  }
+
+ private:
+  using List = std::list<std::pair<int64_t, int64_t>>;
+
+  std::size_t capacity_;
+  List items_{};
+  std::unordered_map<int64_t, List::iterator> index_{};
+};
+
+}  // namespace
+
+// Read through cache. Zipfian keys, on a miss load the value and insert it.
+// Reports the hit rate along with the throughput.
+//
+// Compare one Guarded<Lru, std::mutex> to the ShardedCache.
+struct BM_Cache_Fixture : benchmark::Fixture {
+  std::unique_ptr<lockables::Guarded<Lru, std::mutex>> lru{};
+  std::unique_ptr<lockables::ShardedCache<int64_t, int64_t>> sharded{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    lru = std::make_unique<lockables::Guarded<Lru, std::mutex>>(kCapacity);
+    sharded = std::make_unique<lockables::ShardedCache<int64_t, int64_t>>(
+        kCapacity, 64);
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    lru.reset();
+    sharded.reset();
+  }
+
+  static std::vector<int64_t> make_trace(const benchmark::State& state) {
+    return bench::make_zipf_trace(
+        kNumKey, kSkew, kTraceLength,
+        static_cast<std::uint64_t>(state.thread_index()) + 1);
+  }
+
+  static void set_hit_rate(benchmark::State& state, int64_t num_hit) {
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hit_rate"] = benchmark::Counter(
+        static_cast<double>(num_hit) / static_cast<double>(state.iterations()),
+        benchmark::Counter::kAvgThreads);
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_Cache_Fixture, GuardedLru)(benchmark::State& state) {
+  const auto trace = make_trace(state);
+  std::size_t i = 0;
+  int64_t num_hit = 0;
+  for (auto _ : state) {
+    const int64_t key = trace[i++ % trace.size()];
+    auto guard = lru->with_exclusive();
+    if (const auto value = guard->get(key)) {
+      benchmark::DoNotOptimize(*value);
+      ++num_hit;
+    } else {
+      guard->put(key, key);
+    }
+  }
+
+  set_hit_rate(state, num_hit);
+}
+
+BENCHMARK_REGISTER_F(BM_Cache_Fixture, GuardedLru)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_Cache_Fixture, ShardedCache)(benchmark::State& state) {
+  const auto trace = make_trace(state);
+  std::size_t i = 0;
+  int64_t num_hit = 0;
+  for (auto _ : state) {
+    const int64_t key = trace[i++ % trace.size()];
+    if (const auto value = sharded->get(key)) {
+      benchmark::DoNotOptimize(*value);
+      ++num_hit;
+    } else {
+      sharded->put(key, key);
+    }
+  }
+
+  set_hit_rate(state, num_hit);
+}
+
+BENCHMARK_REGISTER_F(BM_Cache_Fixture, ShardedCache)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_Cache_Fixture, ShardedCacheCompute)
+(benchmark::State& state) {
+  const auto trace = make_trace(state);
+  std::size_t i = 0;
+  int64_t num_miss = 0;
+  for (auto _ : state) {
+    const int64_t key = trace[i++ % trace.size()];
+    benchmark::DoNotOptimize(
+        sharded->get_or_compute(key, [&num_miss](const int64_t& k) {
+          ++num_miss;
+          return k;
+        }));
+  }
+
+  set_hit_rate(state, state.iterations() - num_miss);
+}
+
+BENCHMARK_REGISTER_F(BM_Cache_Fixture, ShardedCacheCompute)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
@@ -0,0 +1,158 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/skip_list.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <shared_mutex>
+
+namespace {
+
+using Map = std::map<int64_t, int64_t>;
+using GuardedMap = lockables::Guarded<Map, std::shared_mutex>;
+
+// Keys are uniform in [0, kNumKey). About half of them are present.
+constexpr int64_t kNumKey = 1 << 16;
+
+// Length of one range scan.
+constexpr int kScanLength = 32;
+
+enum class Op { kInsert, kErase, kFind, kScan };
+
+// The benchmark argument is the percentage of scans. The remaining operations
+// are split 20% insert, 20% erase, 60% find.
+Op next_op(std::mt19937_64& gen, int64_t scan_percent) {
+  const auto percent = static_cast<int64_t>(gen() % 100);
+  if (percent < scan_percent) {
+    return Op::kScan;
+  }
+
+  const auto rest = (percent - scan_percent) * 100 / (100 - scan_percent);
+  if (rest < 20) {
+    return Op::kInsert;
+  }
+  if (rest < 40) {
+    return Op::kErase;
+  }
+  return Op::kFind;
+}
+
+}  // namespace
+
+// Order book style workload with inserts, erases, point lookups and short range
+// scans. Compare Guarded<std::map, std::shared_mutex>, where a scan holds a
+// shared lock that blocks all writers, to the SkipList.
+struct BM_SkipList_Fixture : benchmark::Fixture {
+  std::unique_ptr<GuardedMap> guarded{};
+  std::unique_ptr<lockables::SkipList<int64_t, int64_t>> skip_list{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded = std::make_unique<GuardedMap>();
+    skip_list = std::make_unique<lockables::SkipList<int64_t, int64_t>>();
+
+    auto guard = guarded->with_exclusive();
+    for (int64_t key = 0; key < kNumKey; key += 2) {
+      guard->emplace(key, key);
+      skip_list->insert(key, key);
+    }
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded.reset();
+    skip_list.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_SkipList_Fixture, Guarded)(benchmark::State& state) {
+  std::mt19937_64 gen{static_cast<std::uint64_t>(state.thread_index())};
+  std::uniform_int_distribution<int64_t> dist{0, kNumKey - 1};
+  for (auto _ : state) {
+    const int64_t key = dist(gen);
+    switch (next_op(gen, state.range(0))) {
+      case Op::kInsert: {
+        auto guard = guarded->with_exclusive();
+        guard->emplace(key, key);
+        break;
+      }
+      case Op::kErase: {
+        auto guard = guarded->with_exclusive();
+        guard->erase(key);
+        break;
+      }
+      case Op::kFind: {
+        const auto guard = guarded->with_shared();
+        const auto itr = guard->find(key);
+        benchmark::DoNotOptimize(itr != guard->end() ? itr->second : 0);
+        break;
+      }
+      case Op::kScan: {
+        const auto guard = guarded->with_shared();
+        int64_t sum = 0;
+        int count = 0;
+        for (auto itr = guard->lower_bound(key);
+             itr != guard->end() && count < kScanLength; ++itr, ++count) {
+          sum += itr->second;
+        }
+        benchmark::DoNotOptimize(sum);
+        break;
+      }
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_SkipList_Fixture, Guarded)
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(50)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_SkipList_Fixture, SkipList)(benchmark::State& state) {
+  std::mt19937_64 gen{static_cast<std::uint64_t>(state.thread_index())};
+  std::uniform_int_distribution<int64_t> dist{0, kNumKey - 1};
+  for (auto _ : state) {
+    const int64_t key = dist(gen);
+    switch (next_op(gen, state.range(0))) {
+      case Op::kInsert:
+        skip_list->insert(key, key);
+        break;
+      case Op::kErase:
+        skip_list->erase(key);
+        break;
+      case Op::kFind:
+        benchmark::DoNotOptimize(skip_list->find(key));
+        break;
+      case Op::kScan: {
+        // Scan the key range that holds about kScanLength items.
+        int64_t sum = 0;
+        skip_list->for_each(key, key + kScanLength * 2,
+                            [&sum](const int64_t&, const int64_t& value) {
+                              sum += value;
+                            });
+        benchmark::DoNotOptimize(sum);
+        break;
+      }
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_SkipList_Fixture, SkipList)
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(50)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
@@ -0,0 +1,183 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/spsc_queue.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t kCapacity = 1024;
+
+template <std::size_t N>
+struct Message {
+  std::array<std::byte, N> payload{};
+};
+
+template <typename Msg>
+using GuardedDeque = lockables::Guarded<std::deque<Msg>>;
+
+template <typename Msg>
+void produce_guarded(benchmark::State& state, GuardedDeque<Msg>& queue) {
+  Msg message{};
+  for (auto _ : state) {
+    for (;;) {
+      {
+        auto guard = queue.with_exclusive();
+        if (guard->size() < kCapacity) {
+          guard->push_back(message);
+          break;
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+}
+
+template <typename Msg>
+void consume_guarded(benchmark::State& state, GuardedDeque<Msg>& queue) {
+  Msg message{};
+  for (auto _ : state) {
+    for (;;) {
+      {
+        auto guard = queue.with_exclusive();
+        if (!guard->empty()) {
+          message = guard->front();
+          guard->pop_front();
+          break;
+        }
+      }
+      std::this_thread::yield();
+    }
+    benchmark::DoNotOptimize(message);
+  }
+}
+
+template <typename Msg>
+void produce_spsc(benchmark::State& state, lockables::SpscQueue<Msg>& queue) {
+  for (auto _ : state) {
+    Msg* slot = nullptr;
+    while ((slot = queue.reserve()) == nullptr) {
+      std::this_thread::yield();
+    }
+    // Write the message in place.
+    slot->payload.front() = std::byte{1};
+    benchmark::ClobberMemory();
+    queue.commit();
+  }
+}
+
+template <typename Msg>
+void consume_spsc(benchmark::State& state, lockables::SpscQueue<Msg>& queue) {
+  for (auto _ : state) {
+    const Msg* front = nullptr;
+    while ((front = queue.peek()) == nullptr) {
+      std::this_thread::yield();
+    }
+    // Read the message in place.
+    benchmark::DoNotOptimize(front->payload.front());
+    queue.release();
+  }
+}
+
+}  // namespace
+
+// One producer thread and one consumer thread pass messages of N bytes. The
+// Guarded<std::deque> queue copies each message in and out. The SpscQueue
+// writes and reads each message in place.
+template <typename Msg>
+struct BM_SpscQueue_Fixture : benchmark::Fixture {
+  std::unique_ptr<GuardedDeque<Msg>> guarded{};
+  std::unique_ptr<lockables::SpscQueue<Msg>> spsc{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded = std::make_unique<GuardedDeque<Msg>>();
+    spsc = std::make_unique<lockables::SpscQueue<Msg>>(kCapacity);
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded.reset();
+    spsc.reset();
+  }
+
+  void run_guarded(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+      produce_guarded(state, *guarded);
+    } else {
+      consume_guarded(state, *guarded);
+    }
+
+    state.SetBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(sizeof(Msg)));
+  }
+
+  void run_spsc(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+      produce_spsc(state, *spsc);
+    } else {
+      consume_spsc(state, *spsc);
+    }
+
+    state.SetBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(sizeof(Msg)));
+  }
+};
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_SpscQueue_Fixture, Guarded8, Message<8>)
+(benchmark::State& state) { run_guarded(state); }
+BENCHMARK_REGISTER_F(BM_SpscQueue_Fixture, Guarded8)->Threads(2)->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_SpscQueue_Fixture, SpscQueue8, Message<8>)
+(benchmark::State& state) { run_spsc(state); }
+BENCHMARK_REGISTER_F(BM_SpscQueue_Fixture, SpscQueue8)
+    ->Threads(2)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_SpscQueue_Fixture, Guarded64, Message<64>)
+(benchmark::State& state) { run_guarded(state); }
+BENCHMARK_REGISTER_F(BM_SpscQueue_Fixture, Guarded64)
+    ->Threads(2)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_SpscQueue_Fixture, SpscQueue64, Message<64>)
+(benchmark::State& state) { run_spsc(state); }
+BENCHMARK_REGISTER_F(BM_SpscQueue_Fixture, SpscQueue64)
+    ->Threads(2)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_SpscQueue_Fixture, Guarded512, Message<512>)
+(benchmark::State& state) { run_guarded(state); }
+BENCHMARK_REGISTER_F(BM_SpscQueue_Fixture, Guarded512)
+    ->Threads(2)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_SpscQueue_Fixture, SpscQueue512, Message<512>)
+(benchmark::State& state) { run_spsc(state); }
+BENCHMARK_REGISTER_F(BM_SpscQueue_Fixture, SpscQueue512)
+    ->Threads(2)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_SpscQueue_Fixture, Guarded4096, Message<4096>)
+(benchmark::State& state) { run_guarded(state); }
+BENCHMARK_REGISTER_F(BM_SpscQueue_Fixture, Guarded4096)
+    ->Threads(2)
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_SpscQueue_Fixture, SpscQueue4096,
+                            Message<4096>)
+(benchmark::State& state) { run_spsc(state); }
+BENCHMARK_REGISTER_F(BM_SpscQueue_Fixture, SpscQueue4096)
+    ->Threads(2)
+    ->UseRealTime();
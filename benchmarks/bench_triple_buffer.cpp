@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/triple_buffer.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+// Large value, 4 KiB.
+struct Frame {
+  int64_t id{};
+  std::array<int64_t, 511> samples{};
+};
+
+void fill(Frame& frame, int64_t id) {
+  frame.id = id;
+  frame.samples.fill(id);
+}
+
+// Report the mean time per iteration of this thread only. Benchmark counters
+// are summed over threads, so each side sets its own counter.
+void set_latency(benchmark::State& state, const char* name,
+                 std::chrono::steady_clock::time_point start) {
+  const std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  state.counters[name] =
+      elapsed.count() / static_cast<double>(state.iterations());
+}
+
+}  // namespace
+
+// One writer thread fills a 4 KiB frame and publishes it, one reader thread
+// reads the latest frame. Reports the mean latency of each side in ns.
+//
+// Compare Guarded<Frame, std::mutex>, where each side holds the lock for the
+// whole frame, to the TripleBuffer, where neither side waits.
+struct BM_TripleBuffer_Fixture : benchmark::Fixture {
+  std::unique_ptr<lockables::Guarded<Frame, std::mutex>> guarded{};
+  std::unique_ptr<lockables::TripleBuffer<Frame>> triple{};
+
+  void SetUp(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded = std::make_unique<lockables::Guarded<Frame, std::mutex>>();
+    triple = std::make_unique<lockables::TripleBuffer<Frame>>();
+  }
+
+  void TearDown(const benchmark::State& state) override {
+    if (state.thread_index() != 0) {
+      return;
+    }
+
+    guarded.reset();
+    triple.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_TripleBuffer_Fixture, Guarded)
+(benchmark::State& state) {
+  const auto start = std::chrono::steady_clock::now();
+  if (state.thread_index() == 0) {
+    int64_t id = 0;
+    for (auto _ : state) {
+      auto guard = guarded->with_exclusive();
+      fill(*guard, ++id);
+    }
+
+    set_latency(state, "writer_ns", start);
+  } else {
+    for (auto _ : state) {
+      const auto guard = guarded->with_exclusive();
+      benchmark::DoNotOptimize(guard->id);
+      benchmark::DoNotOptimize(guard->samples.back());
+    }
+
+    set_latency(state, "reader_ns", start);
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_TripleBuffer_Fixture, Guarded)
+    ->Threads(2)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_TripleBuffer_Fixture, TripleBuffer)
+(benchmark::State& state) {
+  const auto start = std::chrono::steady_clock::now();
+  if (state.thread_index() == 0) {
+    int64_t id = 0;
+    for (auto _ : state) {
+      ++id;
+      triple->write([id](Frame& frame) { fill(frame, id); });
+      triple->publish();
+    }
+
+    set_latency(state, "writer_ns", start);
+  } else {
+    for (auto _ : state) {
+      const auto frame = triple->read();
+      benchmark::DoNotOptimize(frame->id);
+      benchmark::DoNotOptimize(frame->samples.back());
+    }
+
+    set_latency(state, "reader_ns", start);
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_TripleBuffer_Fixture, TripleBuffer)
+    ->Threads(2)
+    ->UseRealTime();
@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+#include <lockables/guarded.hpp>
+#include <lockables/work_stealing_pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Item {
+  std::uint64_t value{};
+  std::uint64_t cost{};
+};
+
+using Items = std::vector<lockables::Guarded<Item>>;
+
+// Busy work inside the lock, cost is the number of loop iterations.
+void update(Item& item) {
+  for (std::uint64_t i = 0; i < item.cost; ++i) {
+    item.value = item.value * 6364136223846793005ULL + 1442695040888963407ULL;
+  }
+}
+
+}  // namespace
+
+// Update every Guarded item once per iteration. Compare one std::thread per
+// chunk, created on every call, to the work stealing pool.
+//
+// The first argument is the number of items. If the second argument is zero
+// all updates cost the same. Otherwise the first 1/16 of the items cost 16
+// times more than the rest, which is where static chunks fall behind.
+struct BM_WorkStealingPool_Fixture : benchmark::Fixture {
+  std::unique_ptr<Items> items{};
+  std::unique_ptr<lockables::WorkStealingPool> pool{};
+
+  void SetUp(const benchmark::State& state) override {
+    constexpr std::uint64_t kCost = 100;
+
+    const auto num_item = static_cast<std::size_t>(state.range(0));
+    const bool skewed = state.range(1) != 0;
+
+    items = std::make_unique<Items>(num_item);
+    for (std::size_t i = 0; i < num_item; ++i) {
+      auto guard = (*items)[i].with_exclusive();
+      guard->cost = skewed && i < num_item / 16 ? kCost * 16 : kCost;
+    }
+
+    pool = std::make_unique<lockables::WorkStealingPool>();
+  }
+
+  void TearDown(const benchmark::State&) override {
+    pool.reset();
+    items.reset();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_WorkStealingPool_Fixture, ThreadPerChunk)
+(benchmark::State& state) {
+  const std::size_t num_item = items->size();
+  const std::size_t num_thread =
+      lockables::WorkStealingPool::default_num_thread();
+  const std::size_t chunk = (num_item + num_thread - 1) / num_thread;
+
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (std::size_t first = 0; first < num_item; first += chunk) {
+      const std::size_t last = std::min(first + chunk, num_item);
+      threads.emplace_back([this, first, last]() {
+        for (std::size_t i = first; i < last; ++i) {
+          lockables::with_exclusive(update, (*items)[i]);
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(num_item));
+}
+
+BENCHMARK_REGISTER_F(BM_WorkStealingPool_Fixture, ThreadPerChunk)
+    ->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {0, 1}})
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_WorkStealingPool_Fixture, WorkStealingPool)
+(benchmark::State& state) {
+  for (auto _ : state) {
+    lockables::parallel_for_each_exclusive(*pool, *items, update);
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(items->size()));
+}
+
+BENCHMARK_REGISTER_F(BM_WorkStealingPool_Fixture, WorkStealingPool)
+    ->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {0, 1}})
+    ->UseRealTime();
@@ -0,0 +1,66 @@
+#ifndef LOCKABLES_BENCHMARKS_ZIPF_HPP_
+#define LOCKABLES_BENCHMARKS_ZIPF_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace bench {
+
+/**
+  Zipfian distribution over the integers [0, n). Rank 0 is the most popular.
+  Builds the cumulative distribution once and samples with a binary search.
+  Good enough to generate key traces before a benchmark loop starts.
+*/
+class ZipfDistribution {
+ public:
+  ZipfDistribution(std::size_t n, double skew) : cdf_(n) {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+      cdf_[i] = sum;
+    }
+
+    for (auto& value : cdf_) {
+      value /= sum;
+    }
+  }
+
+  template <typename Generator>
+  std::size_t operator()(Generator& gen) const {
+    std::uniform_real_distribution<double> uniform{0.0, 1.0};
+    const auto itr = std::lower_bound(cdf_.begin(), cdf_.end(), uniform(gen));
+    return std::min(static_cast<std::size_t>(itr - cdf_.begin()),
+                    cdf_.size() - 1);
+  }
+
+ private:
+  std::vector<double> cdf_;
+};
+
+/**
+  Generate a trace of keys in [0, n) with a Zipfian distribution. Scatter the
+  ranks so that the popular keys are not also adjacent integers. If n is a
+  power of two the scatter is a permutation.
+*/
+inline std::vector<std::int64_t> make_zipf_trace(std::size_t n, double skew,
+                                                 std::size_t length,
+                                                 std::uint64_t seed) {
+  const ZipfDistribution dist{n, skew};
+  std::mt19937_64 gen{seed};
+
+  std::vector<std::int64_t> trace(length);
+  for (auto& key : trace) {
+    const auto rank = static_cast<std::uint64_t>(dist(gen));
+    key = static_cast<std::int64_t>((rank * 0x9E3779B97F4A7C15ULL) % n);
+  }
+
+  return trace;
+}
+
+}  // namespace bench
+
+#endif  // LOCKABLES_BENCHMARKS_ZIPF_HPP_
@@ -1,5 +1,11 @@
 include(cmake/folders.cmake)
 
+# USDT probes for bpftrace or perf, see include/lockables/trace.hpp.
+option(ENABLE_USDT "Build tests and benchmarks with USDT probes" OFF)
+if(ENABLE_USDT)
+    add_compile_definitions(LOCKABLES_ENABLE_USDT)
+endif()
+
 include(CTest)
 if(BUILD_TESTING)
     add_subdirectory(tests)
@@ -15,9 +15,14 @@ class LockablesConan(ConanFile):
 
     options = {
         "developer_mode": [True, False],
-        "enable_benchmarks": [True, False]
+        "enable_benchmarks": [True, False],
+        "enable_usdt": [True, False]
+    }
+    default_options = {
+        "developer_mode": False,
+        "enable_benchmarks": False,
+        "enable_usdt": False
     }
-    default_options = {"developer_mode": False, "enable_benchmarks": False}
 
     def build_requirements(self):
         if not self.options.developer_mode:
@@ -38,6 +43,8 @@ class LockablesConan(ConanFile):
             variables["lockables_DEVELOPER_MODE"] = True
         if self.options.enable_benchmarks:
             variables["ENABLE_BENCHMARKS"] = True
+        if self.options.enable_usdt:
+            variables["ENABLE_USDT"] = True
 
         cmake = CMake(self)
         cmake.configure(variables=variables)
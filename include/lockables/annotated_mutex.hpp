@@ -0,0 +1,166 @@
+//
+// lockables/annotated_mutex.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  AnnotatedMutex<Mutex> wraps a mutex as a capability for the Clang Thread
+  Safety Analysis. The std mutex types are not annotated in libstdc++, so the
+  analysis can not reason about them.
+
+  AnnotatedMutex {
+    Mutex mutex
+  }
+
+  Use it as the mutex of a Guarded<T>, or to guard plain data members with
+  LOCKABLES_GUARDED_BY. The AnnotatedLock and AnnotatedSharedLock RAII types
+  tell the analysis which capability they hold.
+
+  Wrap the other mutex types to combine checks, e.g.,
+  AnnotatedMutex<OwnedMutex<std::mutex>>. Without Clang there is no change.
+
+  Usage:
+
+  class Account {
+   public:
+    void deposit(int amount) {
+      AnnotatedLock lock{mutex_};
+      balance_ += amount;
+    }
+
+    int balance() const {
+      AnnotatedSharedLock lock{mutex_};
+      return balance_;
+    }
+
+   private:
+    mutable AnnotatedMutex<std::shared_mutex> mutex_;
+    int balance_ LOCKABLES_GUARDED_BY(mutex_) = 0;
+  };
+*/
+#ifndef LOCKABLES_ANNOTATED_MUTEX_HPP_
+#define LOCKABLES_ANNOTATED_MUTEX_HPP_
+
+#include <lockables/guarded.hpp>
+#include <lockables/thread_annotations.hpp>
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace lockables {
+
+/**
+  AnnotatedMutex<Mutex> meets the same Lockable or SharedLockable requirements
+  as Mutex. The analysis trusts the annotations, the method bodies are not
+  checked.
+*/
+template <typename Mutex = std::mutex>
+class LOCKABLES_CAPABILITY("mutex") AnnotatedMutex {
+ public:
+  using mutex_type = Mutex;
+
+  AnnotatedMutex() = default;
+
+  /**
+    Name from a Guarded<T> constructor tag, passed on to Mutex.
+  */
+  explicit AnnotatedMutex(LockName name)
+      : mutex_{detail::make_mutex<Mutex>(name)} {}
+
+  // Rule of 5. No copy or move.
+  AnnotatedMutex(const AnnotatedMutex&) = delete;
+  AnnotatedMutex(AnnotatedMutex&&) noexcept = delete;
+  AnnotatedMutex& operator=(const AnnotatedMutex&) = delete;
+  AnnotatedMutex& operator=(AnnotatedMutex&&) noexcept = delete;
+  ~AnnotatedMutex() = default;
+
+  void lock() LOCKABLES_ACQUIRE() LOCKABLES_NO_THREAD_SAFETY_ANALYSIS {
+    mutex_.lock();
+  }
+
+  bool try_lock() LOCKABLES_TRY_ACQUIRE(true)
+      LOCKABLES_NO_THREAD_SAFETY_ANALYSIS {
+    return mutex_.try_lock();
+  }
+
+  void unlock() LOCKABLES_RELEASE() LOCKABLES_NO_THREAD_SAFETY_ANALYSIS {
+    mutex_.unlock();
+  }
+
+  void lock_shared() LOCKABLES_ACQUIRE_SHARED()
+      LOCKABLES_NO_THREAD_SAFETY_ANALYSIS {
+    mutex_.lock_shared();
+  }
+
+  bool try_lock_shared() LOCKABLES_TRY_ACQUIRE_SHARED(true)
+      LOCKABLES_NO_THREAD_SAFETY_ANALYSIS {
+    return mutex_.try_lock_shared();
+  }
+
+  void unlock_shared() LOCKABLES_RELEASE_SHARED()
+      LOCKABLES_NO_THREAD_SAFETY_ANALYSIS {
+    mutex_.unlock_shared();
+  }
+
+ private:
+  Mutex mutex_{};
+};
+
+/**
+  Exclusive RAII lock of an annotated mutex. Like std::scoped_lock<Mutex> for
+  one mutex.
+*/
+template <typename Mutex>
+class LOCKABLES_SCOPED_CAPABILITY AnnotatedLock {
+ public:
+  explicit AnnotatedLock(Mutex& mutex) LOCKABLES_ACQUIRE(mutex)
+      LOCKABLES_NO_THREAD_SAFETY_ANALYSIS : mutex_{mutex} {
+    mutex_.lock();
+  }
+
+  // Rule of 5. No copy or move.
+  AnnotatedLock(const AnnotatedLock&) = delete;
+  AnnotatedLock(AnnotatedLock&&) noexcept = delete;
+  AnnotatedLock& operator=(const AnnotatedLock&) = delete;
+  AnnotatedLock& operator=(AnnotatedLock&&) noexcept = delete;
+  ~AnnotatedLock() LOCKABLES_RELEASE() LOCKABLES_NO_THREAD_SAFETY_ANALYSIS {
+    mutex_.unlock();
+  }
+
+ private:
+  Mutex& mutex_;
+};
+
+/**
+  Shared RAII lock of an annotated mutex. Like std::shared_lock<Mutex>, but
+  always owns the lock.
+*/
+template <typename Mutex>
+class LOCKABLES_SCOPED_CAPABILITY AnnotatedSharedLock {
+ public:
+  explicit AnnotatedSharedLock(Mutex& mutex) LOCKABLES_ACQUIRE_SHARED(mutex)
+      LOCKABLES_NO_THREAD_SAFETY_ANALYSIS : mutex_{mutex} {
+    mutex_.lock_shared();
+  }
+
+  // Rule of 5. No copy or move.
+  AnnotatedSharedLock(const AnnotatedSharedLock&) = delete;
+  AnnotatedSharedLock(AnnotatedSharedLock&&) noexcept = delete;
+  AnnotatedSharedLock& operator=(const AnnotatedSharedLock&) = delete;
+  AnnotatedSharedLock& operator=(AnnotatedSharedLock&&) noexcept = delete;
+  ~AnnotatedSharedLock() LOCKABLES_RELEASE()
+      LOCKABLES_NO_THREAD_SAFETY_ANALYSIS {
+    mutex_.unlock_shared();
+  }
+
+ private:
+  Mutex& mutex_;
+};
+
+template <typename Mutex>
+struct SharedLock<AnnotatedMutex<Mutex>>
+    : WrappedSharedLock<AnnotatedMutex<Mutex>> {};
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_ANNOTATED_MUTEX_HPP_
@@ -0,0 +1,554 @@
+//
+// lockables/async_guarded.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  AsyncGuarded<T> is a class template that stores a coroutine aware mutex
+  together with the value it guards. Requires C++20 coroutines.
+
+  AsyncGuarded {
+    T value
+    AsyncSharedMutex mutex
+  }
+
+  Coroutines read or write the guarded value by awaiting the pointer like
+  AsyncGuardedScope<T> object. A coroutine that can not acquire the lock is
+  suspended, the thread is not blocked. The coroutine is resumed when the lock
+  is handed over to it by the unlocking thread.
+
+  AsyncGuardedScope {
+    T* non_owning
+    AsyncSharedMutex* mutex
+  }
+
+  Usage:
+
+  AsyncGuarded<int> value{9};
+
+  DetachedTask writer(RunLoop& loop, AsyncGuarded<int>& value) {
+    co_await loop.schedule();
+
+    // Writer access. The mutex is locked until guard goes out of scope.
+    auto guard = co_await value.async_exclusive();
+
+    *guard += 10;
+  }
+
+  DetachedTask reader(RunLoop& loop, AsyncGuarded<int>& value) {
+    co_await loop.schedule();
+
+    // Reader access.
+    const auto guard = co_await value.async_shared();
+
+    int copy = *guard;
+  }
+*/
+#ifndef LOCKABLES_ASYNC_GUARDED_HPP_
+#define LOCKABLES_ASYNC_GUARDED_HPP_
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "lockables/async_guarded.hpp requires C++20 coroutines"
+#endif
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace lockables {
+
+/**
+  AsyncSharedMutex is a reader/writer mutex for coroutines. Allow multiple
+  reader coroutines or one writer coroutine to own the lock at a time.
+
+  Waiters are queued in first in, first out order. A reader that arrives while
+  a writer is queued waits behind that writer so writers are not starved.
+
+  The unlocking thread hands the lock over to the next waiter(s) and then
+  resumes them, either inline or by posting them to an executor.
+*/
+class AsyncSharedMutex {
+ public:
+  /**
+    Intrusive queue node. Stored in the awaiter object that lives in the frame
+    of the suspended coroutine, so waiting does not allocate.
+  */
+  struct Waiter {
+    std::coroutine_handle<> handle{};
+    void* executor{};
+    void (*resume)(void* executor, std::coroutine_handle<> handle){};
+    Waiter* next{};
+    bool exclusive{};
+  };
+
+  AsyncSharedMutex() = default;
+
+  // Rule of 5. No copy or move.
+  AsyncSharedMutex(const AsyncSharedMutex&) = delete;
+  AsyncSharedMutex(AsyncSharedMutex&&) noexcept = delete;
+  AsyncSharedMutex& operator=(const AsyncSharedMutex&) = delete;
+  AsyncSharedMutex& operator=(AsyncSharedMutex&&) noexcept = delete;
+  ~AsyncSharedMutex() = default;
+
+  [[nodiscard]] bool try_lock();
+  [[nodiscard]] bool try_lock_shared();
+
+  void unlock();
+  void unlock_shared();
+
+  /**
+    Acquire the lock now and return false, or append the waiter to the queue
+    and return true. Used by the awaiter in await_suspend.
+  */
+  [[nodiscard]] bool lock_or_enqueue(Waiter& waiter);
+
+ private:
+  // Called with mutex_ held. Pop the next waiter(s) that can own the lock and
+  // return them as a list.
+  Waiter* take_next_owners();
+
+  static void resume_all(Waiter* list);
+
+  std::mutex mutex_{};
+  // -1 if a writer owns the lock, otherwise the number of readers.
+  std::ptrdiff_t state_{};
+  Waiter* head_{};
+  Waiter* tail_{};
+};
+
+/**
+  AsyncGuardedScope<T> is a pointer like object that owns a lock on an
+  AsyncSharedMutex and has a non-owning pointer to the guarded value of type T
+  in AsyncGuarded<T>.
+
+  Unlike GuardedScope<T> this object is movable so it can be returned from
+  co_await. By convention, a shared lock is held if T is const.
+*/
+template <typename T>
+class AsyncGuardedScope {
+ public:
+  using pointer = T*;
+  using element_type = T;
+
+  AsyncGuardedScope(pointer ptr, AsyncSharedMutex* mutex)
+      : non_owning_{ptr}, mutex_{mutex} {}
+
+  // Rule of 5. Move only.
+  AsyncGuardedScope(const AsyncGuardedScope&) = delete;
+  AsyncGuardedScope(AsyncGuardedScope&& other) noexcept
+      : non_owning_{std::exchange(other.non_owning_, nullptr)},
+        mutex_{std::exchange(other.mutex_, nullptr)} {}
+  AsyncGuardedScope& operator=(const AsyncGuardedScope&) = delete;
+  AsyncGuardedScope& operator=(AsyncGuardedScope&& other) noexcept {
+    if (this != &other) {
+      unlock();
+      non_owning_ = std::exchange(other.non_owning_, nullptr);
+      mutex_ = std::exchange(other.mutex_, nullptr);
+    }
+    return *this;
+  }
+  ~AsyncGuardedScope() { unlock(); }
+
+  explicit operator bool() const noexcept { return non_owning_ != nullptr; }
+
+  std::add_lvalue_reference_t<T> operator*() const noexcept {
+    return *non_owning_;
+  }
+
+  pointer operator->() const noexcept { return non_owning_; }
+
+ private:
+  void unlock() {
+    if (mutex_ == nullptr) {
+      return;
+    }
+
+    if constexpr (std::is_const_v<T>) {
+      mutex_->unlock_shared();
+    } else {
+      mutex_->unlock();
+    }
+
+    mutex_ = nullptr;
+    non_owning_ = nullptr;
+  }
+
+  pointer non_owning_;
+  AsyncSharedMutex* mutex_;
+};
+
+/**
+  Awaitable returned by the AsyncGuarded<T> methods. The result of co_await is
+  an AsyncGuardedScope<T> that owns the lock.
+
+  If the Executor is not void, a suspended coroutine is resumed by posting it
+  to the executor instead of inline on the unlocking thread. This bounds the
+  stack depth when many coroutines hand the lock over to each other.
+*/
+template <typename T, typename Executor = void>
+class AsyncLockOperation {
+ public:
+  using scope_type = AsyncGuardedScope<T>;
+
+  AsyncLockOperation(T* ptr, AsyncSharedMutex& mutex, Executor* executor)
+      : non_owning_{ptr}, mutex_{mutex} {
+    waiter_.exclusive = !std::is_const_v<T>;
+    if constexpr (std::is_void_v<Executor>) {
+      waiter_.resume = [](void*, std::coroutine_handle<> handle) {
+        handle.resume();
+      };
+    } else {
+      waiter_.executor = executor;
+      waiter_.resume = [](void* ex, std::coroutine_handle<> handle) {
+        static_cast<Executor*>(ex)->post(handle);
+      };
+    }
+  }
+
+  bool await_ready() {
+    if constexpr (std::is_const_v<T>) {
+      return mutex_.try_lock_shared();
+    } else {
+      return mutex_.try_lock();
+    }
+  }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    waiter_.handle = handle;
+    return mutex_.lock_or_enqueue(waiter_);
+  }
+
+  [[nodiscard]] scope_type await_resume() noexcept {
+    return scope_type{non_owning_, &mutex_};
+  }
+
+ private:
+  T* non_owning_;
+  AsyncSharedMutex& mutex_;
+  AsyncSharedMutex::Waiter waiter_{};
+};
+
+/**
+  AsyncGuarded<T> is a class template that stores an AsyncSharedMutex together
+  with the value it guards. Allow multiple reader coroutines or one writer
+  coroutine access to the guarded value at a time.
+
+  Methods return an awaitable. The result of co_await is the
+  AsyncGuardedScope<T> pointer like object that also holds the lock. When the
+  object goes out of scope the lock is released.
+
+  The user must not keep a pointer or reference to the guarded value after the
+  AsyncGuardedScope<T> goes out of scope.
+
+  Usage:
+
+  AsyncGuarded<std::vector<int>> value{1, 2, 3, 4, 5};
+
+  // Reader with shared lock.
+  {
+    const auto guard = co_await value.async_shared();
+
+    if (!guard->empty()) {
+      int copy = guard->back();
+    }
+  }
+
+  // Writer with exclusive lock. Resume on the loop if we had to wait.
+  {
+    auto guard = co_await value.async_exclusive(loop);
+
+    guard->push_back(100);
+  }
+*/
+template <typename T>
+class AsyncGuarded {
+ public:
+  using shared_scope = AsyncGuardedScope<const T>;
+  using exclusive_scope = AsyncGuardedScope<T>;
+
+  /**
+    Construct a guarded value of type T. All arguments in the parameter pack
+    Args are forwarded to the constructor of T.
+   */
+  template <typename... Args>
+  explicit AsyncGuarded(Args&&... args);
+
+  /**
+    Reader coroutine access. Awaits a shared lock. The coroutine is resumed
+    inline on the unlocking thread if it had to wait.
+  */
+  [[nodiscard]] AsyncLockOperation<const T> async_shared() const;
+
+  /**
+    Reader coroutine access. Awaits a shared lock. The coroutine is resumed by
+    posting it to the executor if it had to wait.
+  */
+  template <typename Executor>
+  [[nodiscard]] AsyncLockOperation<const T, Executor> async_shared(
+      Executor& executor) const;
+
+  /**
+    Writer coroutine access. Awaits an exclusive lock. The coroutine is resumed
+    inline on the unlocking thread if it had to wait.
+  */
+  [[nodiscard]] AsyncLockOperation<T> async_exclusive();
+
+  /**
+    Writer coroutine access. Awaits an exclusive lock. The coroutine is resumed
+    by posting it to the executor if it had to wait.
+  */
+  template <typename Executor>
+  [[nodiscard]] AsyncLockOperation<T, Executor> async_exclusive(
+      Executor& executor);
+
+ private:
+  T value_{};
+  mutable AsyncSharedMutex mutex_{};
+};
+
+template <typename T>
+template <typename... Args>
+AsyncGuarded<T>::AsyncGuarded(Args&&... args)
+    : value_{std::forward<Args>(args)...} {}
+
+template <typename T>
+auto AsyncGuarded<T>::async_shared() const -> AsyncLockOperation<const T> {
+  return AsyncLockOperation<const T>{&value_, mutex_, nullptr};
+}
+
+template <typename T>
+template <typename Executor>
+auto AsyncGuarded<T>::async_shared(Executor& executor) const
+    -> AsyncLockOperation<const T, Executor> {
+  return AsyncLockOperation<const T, Executor>{&value_, mutex_, &executor};
+}
+
+template <typename T>
+auto AsyncGuarded<T>::async_exclusive() -> AsyncLockOperation<T> {
+  return AsyncLockOperation<T>{&value_, mutex_, nullptr};
+}
+
+template <typename T>
+template <typename Executor>
+auto AsyncGuarded<T>::async_exclusive(Executor& executor)
+    -> AsyncLockOperation<T, Executor> {
+  return AsyncLockOperation<T, Executor>{&value_, mutex_, &executor};
+}
+
+inline bool AsyncSharedMutex::try_lock() {
+  std::scoped_lock lock{mutex_};
+  if (state_ != 0) {
+    return false;
+  }
+
+  state_ = -1;
+  return true;
+}
+
+inline bool AsyncSharedMutex::try_lock_shared() {
+  std::scoped_lock lock{mutex_};
+  // Readers wait behind a queued writer.
+  if (state_ < 0 || head_ != nullptr) {
+    return false;
+  }
+
+  ++state_;
+  return true;
+}
+
+inline bool AsyncSharedMutex::lock_or_enqueue(Waiter& waiter) {
+  {
+    std::scoped_lock lock{mutex_};
+    if (waiter.exclusive) {
+      if (state_ == 0) {
+        state_ = -1;
+        return false;
+      }
+    } else if (state_ >= 0 && head_ == nullptr) {
+      ++state_;
+      return false;
+    }
+
+    waiter.next = nullptr;
+    if (tail_ == nullptr) {
+      head_ = &waiter;
+    } else {
+      tail_->next = &waiter;
+    }
+    tail_ = &waiter;
+  }
+
+  return true;
+}
+
+inline void AsyncSharedMutex::unlock() {
+  Waiter* list = nullptr;
+  {
+    std::scoped_lock lock{mutex_};
+    state_ = 0;
+    list = take_next_owners();
+  }
+
+  resume_all(list);
+}
+
+inline void AsyncSharedMutex::unlock_shared() {
+  Waiter* list = nullptr;
+  {
+    std::scoped_lock lock{mutex_};
+    if (--state_ == 0) {
+      list = take_next_owners();
+    }
+  }
+
+  resume_all(list);
+}
+
+inline auto AsyncSharedMutex::take_next_owners() -> Waiter* {
+  if (head_ == nullptr) {
+    return nullptr;
+  }
+
+  Waiter* list = head_;
+  if (head_->exclusive) {
+    // One writer.
+    state_ = -1;
+    head_ = head_->next;
+    list->next = nullptr;
+  } else {
+    // All of the readers at the front of the queue.
+    Waiter* last = head_;
+    ++state_;
+    while (last->next != nullptr && !last->next->exclusive) {
+      last = last->next;
+      ++state_;
+    }
+    head_ = last->next;
+    last->next = nullptr;
+  }
+
+  if (head_ == nullptr) {
+    tail_ = nullptr;
+  }
+
+  return list;
+}
+
+inline void AsyncSharedMutex::resume_all(Waiter* list) {
+  while (list != nullptr) {
+    // The waiter lives in the coroutine frame. Read everything we need before
+    // resuming since the frame may be gone afterwards.
+    Waiter* next = list->next;
+    list->resume(list->executor, list->handle);
+    list = next;
+  }
+}
+
+/**
+  RunLoop is a simple executor bundled for tests and benchmarks. Any number of
+  threads may call run() to resume the coroutines posted to the loop.
+
+  Usage:
+
+  RunLoop loop;
+
+  DetachedTask task(RunLoop& loop) {
+    // Continue on one of the threads that called loop.run().
+    co_await loop.schedule();
+  }
+
+  task(loop);
+
+  std::thread thread{[&loop]() { loop.run(); }};
+  loop.stop();
+  thread.join();
+*/
+class RunLoop {
+ public:
+  /**
+    Awaitable that posts the current coroutine to the loop.
+  */
+  class ScheduleOperation {
+   public:
+    explicit ScheduleOperation(RunLoop& loop) : loop_{loop} {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { loop_.post(handle); }
+    void await_resume() const noexcept {}
+
+   private:
+    RunLoop& loop_;
+  };
+
+  [[nodiscard]] ScheduleOperation schedule() {
+    return ScheduleOperation{*this};
+  }
+
+  void post(std::coroutine_handle<> handle) {
+    {
+      std::scoped_lock lock{mutex_};
+      queue_.push_back(handle);
+    }
+    cv_.notify_one();
+  }
+
+  /**
+    Resume posted coroutines on the calling thread until stop() is called and
+    the queue is empty.
+  */
+  void run() {
+    for (;;) {
+      std::coroutine_handle<> handle;
+      {
+        std::unique_lock lock{mutex_};
+        cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          return;
+        }
+
+        handle = queue_.front();
+        queue_.pop_front();
+      }
+
+      handle.resume();
+    }
+  }
+
+  void stop() {
+    {
+      std::scoped_lock lock{mutex_};
+      stop_ = true;
+    }
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_{};
+  std::condition_variable cv_{};
+  std::deque<std::coroutine_handle<>> queue_{};
+  bool stop_{};
+};
+
+/**
+  DetachedTask is a fire and forget coroutine return type. The coroutine starts
+  immediately on the calling thread and destroys its own frame when it
+  completes. Usually the first statement is co_await loop.schedule().
+*/
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_ASYNC_GUARDED_HPP_
@@ -0,0 +1,33 @@
+//
+// lockables/cache_line.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  Cache line size used to pad data that is written by different threads so
+  that it does not share a cache line (false sharing).
+
+  Usage:
+
+  struct alignas(lockables::kCacheLineSize) Counter {
+    std::atomic<int> value;
+  };
+*/
+#ifndef LOCKABLES_CACHE_LINE_HPP_
+#define LOCKABLES_CACHE_LINE_HPP_
+
+#include <cstddef>
+
+namespace lockables {
+
+/**
+  Use a fixed 64 bytes instead of std::hardware_destructive_interference_size.
+  The standard constant is not available in all of the standard libraries we
+  support, and GCC warns that its value may differ between compiler flags
+  which is a problem for a header only library.
+*/
+inline constexpr std::size_t kCacheLineSize = 64;
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_CACHE_LINE_HPP_
@@ -0,0 +1,340 @@
+//
+// lockables/concurrent_bitmap.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  ConcurrentBitmap is a fixed size bitmap for resource allocation. Threads
+  allocate and free bits without a lock. Each 64 bit word is updated with one
+  atomic fetch_or or fetch_and. A summary level with one bit per word marks
+  the full words so that allocate skips 4096 bits at a time.
+
+  ConcurrentBitmap {
+    std::atomic<uint64_t> summary[num_word / 64]
+    std::atomic<uint64_t> words[size / 64]
+  }
+
+  Usage:
+
+  ConcurrentBitmap slots{1024};
+
+  // Find a clear bit and set it.
+  if (std::optional<std::size_t> slot = slots.allocate()) {
+    // ...
+    slots.reset(*slot);
+  }
+*/
+#ifndef LOCKABLES_CONCURRENT_BITMAP_HPP_
+#define LOCKABLES_CONCURRENT_BITMAP_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <thread>
+
+namespace lockables {
+
+namespace detail {
+
+/**
+  Number of set bits.
+*/
+constexpr unsigned popcount64(std::uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(
+      __builtin_popcountll(static_cast<unsigned long long>(value)));
+#else
+  unsigned result = 0;
+  for (; value != 0; value &= value - 1) {
+    ++result;
+  }
+  return result;
+#endif
+}
+
+/**
+  Index of the lowest set bit. Undefined for zero.
+*/
+constexpr unsigned countr_zero64(std::uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(
+      __builtin_ctzll(static_cast<unsigned long long>(value)));
+#else
+  unsigned result = 0;
+  for (; (value & 1) == 0; value >>= 1) {
+    ++result;
+  }
+  return result;
+#endif
+}
+
+}  // namespace detail
+
+/**
+  ConcurrentBitmap stores size bits, all clear on construction.
+
+  The allocate method starts at a per thread hint, the word it last allocated
+  from, so threads tend to stay in different words. It reads the summary to
+  find a word that is not full, takes the lowest clear bit of that word, and
+  claims it with fetch_or. If another thread got there first it tries the
+  next clear bit. The thread that fills a word sets its summary bit, and the
+  thread that frees a bit in a full word clears it.
+
+  The individual bit operations are atomic. The bulk scans, count and
+  find_first_zero, read one word at a time with relaxed loads. Under
+  concurrent updates they return a result that was true of each word at some
+  point during the scan, not a snapshot of the whole range.
+*/
+class ConcurrentBitmap {
+ public:
+  static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+  explicit ConcurrentBitmap(std::size_t size);
+
+  // Rule of 5. No copy or move.
+  ConcurrentBitmap(const ConcurrentBitmap&) = delete;
+  ConcurrentBitmap(ConcurrentBitmap&&) noexcept = delete;
+  ConcurrentBitmap& operator=(const ConcurrentBitmap&) = delete;
+  ConcurrentBitmap& operator=(ConcurrentBitmap&&) noexcept = delete;
+  ~ConcurrentBitmap() = default;
+
+  /**
+    Find a clear bit, set it, and return its index. Return empty if every bit
+    is set.
+  */
+  [[nodiscard]] std::optional<std::size_t> allocate();
+
+  /**
+    Set the bit at index. Return true if it was clear.
+  */
+  bool set(std::size_t index) noexcept;
+
+  /**
+    Clear the bit at index. Return true if it was set.
+  */
+  bool reset(std::size_t index) noexcept;
+
+  [[nodiscard]] bool test(std::size_t index) const noexcept {
+    return (words_[index / kWordBits].load(std::memory_order_acquire) &
+            bit(index)) != 0;
+  }
+
+  /**
+    Number of set bits in [first, last).
+  */
+  [[nodiscard]] std::size_t count(std::size_t first,
+                                  std::size_t last) const noexcept;
+
+  [[nodiscard]] std::size_t count() const noexcept { return count(0, size_); }
+
+  /**
+    Index of the first clear bit in [first, last), or npos.
+  */
+  [[nodiscard]] std::size_t find_first_zero(std::size_t first,
+                                            std::size_t last) const noexcept;
+
+  [[nodiscard]] std::size_t find_first_zero() const noexcept {
+    return find_first_zero(0, size_);
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+ private:
+  static constexpr std::size_t kWordBits = 64;
+  static constexpr std::uint64_t kFull = ~std::uint64_t{0};
+
+  static constexpr std::uint64_t bit(std::size_t index) noexcept {
+    return std::uint64_t{1} << (index % kWordBits);
+  }
+
+  // Mask of bits [first, last) within one word, last may be 64.
+  static constexpr std::uint64_t range_mask(std::size_t first,
+                                            std::size_t last) noexcept {
+    const std::uint64_t upper =
+        last == kWordBits ? kFull : (std::uint64_t{1} << last) - 1;
+    return upper & (kFull << first);
+  }
+
+  // Word to start looking in, for this thread.
+  static std::size_t& hint() noexcept {
+    static thread_local std::size_t hint =
+        std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return hint;
+  }
+
+  // Try to claim a clear bit in word. Return the bit index in the word.
+  std::optional<std::size_t> allocate_in(std::size_t word) noexcept;
+
+  void mark_full(std::size_t word) noexcept;
+
+  std::size_t size_;
+  std::size_t num_word_;
+  std::size_t num_summary_;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> words_;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> summary_;
+};
+
+inline ConcurrentBitmap::ConcurrentBitmap(std::size_t size)
+    : size_{size},
+      num_word_{(size + kWordBits - 1) / kWordBits},
+      num_summary_{(num_word_ + kWordBits - 1) / kWordBits},
+      words_{std::make_unique<std::atomic<std::uint64_t>[]>(num_word_)},
+      summary_{std::make_unique<std::atomic<std::uint64_t>[]>(num_summary_)} {
+  // Set the bits past the end so that the last word fills up like the others.
+  if (const auto tail = size_ % kWordBits; tail != 0) {
+    words_[num_word_ - 1].store(range_mask(tail, kWordBits),
+                                std::memory_order_relaxed);
+  }
+
+  // Mark the summary bits past the last word as full.
+  if (const auto tail = num_word_ % kWordBits; tail != 0) {
+    summary_[num_summary_ - 1].store(range_mask(tail, kWordBits),
+                                     std::memory_order_relaxed);
+  }
+}
+
+inline std::optional<std::size_t> ConcurrentBitmap::allocate() {
+  if (num_word_ == 0) {
+    return std::nullopt;
+  }
+
+  std::size_t& start = hint();
+  const std::size_t start_word = start % num_word_;
+  const std::size_t start_summary = start_word / kWordBits;
+  const std::size_t start_bit = start_word % kWordBits;
+
+  // Visit the summary word of the hint twice, first from the hint to its end,
+  // and last from its beginning up to the hint.
+  for (std::size_t n = 0; n <= num_summary_; ++n) {
+    const std::size_t index = (start_summary + n) % num_summary_;
+    std::uint64_t mask = kFull;
+    if (n == 0) {
+      mask = range_mask(start_bit, kWordBits);
+    } else if (n == num_summary_) {
+      if (start_bit == 0) {
+        break;
+      }
+      mask = range_mask(0, start_bit);
+    }
+
+    auto free = ~summary_[index].load(std::memory_order_acquire) & mask;
+    for (; free != 0; free &= free - 1) {
+      const std::size_t word =
+          index * kWordBits + detail::countr_zero64(free);
+      if (const auto offset = allocate_in(word)) {
+        start = word;
+        return word * kWordBits + *offset;
+      }
+    }
+  }
+
+  return std::nullopt;
+}
+
+inline auto ConcurrentBitmap::allocate_in(std::size_t word) noexcept
+    -> std::optional<std::size_t> {
+  auto& value = words_[word];
+  auto current = value.load(std::memory_order_relaxed);
+  while (current != kFull) {
+    const auto offset = detail::countr_zero64(~current);
+    const auto mask = std::uint64_t{1} << offset;
+    const auto previous = value.fetch_or(mask, std::memory_order_seq_cst);
+    if ((previous & mask) == 0) {
+      if ((previous | mask) == kFull) {
+        mark_full(word);
+      }
+      return offset;
+    }
+
+    // Lost the race for that bit.
+    current = previous | mask;
+  }
+
+  mark_full(word);
+  return std::nullopt;
+}
+
+inline void ConcurrentBitmap::mark_full(std::size_t word) noexcept {
+  auto& summary = summary_[word / kWordBits];
+  const auto mask = bit(word);
+  summary.fetch_or(mask, std::memory_order_seq_cst);
+
+  // A bit may have been freed before the summary bit was set. The thread that
+  // freed it cleared the summary bit first, so clear it again.
+  if (words_[word].load(std::memory_order_seq_cst) != kFull) {
+    summary.fetch_and(~mask, std::memory_order_seq_cst);
+  }
+}
+
+inline bool ConcurrentBitmap::set(std::size_t index) noexcept {
+  const std::size_t word = index / kWordBits;
+  const auto mask = bit(index);
+  const auto previous = words_[word].fetch_or(mask, std::memory_order_seq_cst);
+  if ((previous & mask) != 0) {
+    return false;
+  }
+
+  if ((previous | mask) == kFull) {
+    mark_full(word);
+  }
+
+  return true;
+}
+
+inline bool ConcurrentBitmap::reset(std::size_t index) noexcept {
+  const std::size_t word = index / kWordBits;
+  const auto mask = bit(index);
+  const auto previous =
+      words_[word].fetch_and(~mask, std::memory_order_seq_cst);
+  if (previous == kFull) {
+    summary_[word / kWordBits].fetch_and(~bit(word),
+                                         std::memory_order_seq_cst);
+  }
+
+  return (previous & mask) != 0;
+}
+
+inline std::size_t ConcurrentBitmap::count(std::size_t first,
+                                           std::size_t last) const noexcept {
+  std::size_t result = 0;
+  while (first < last) {
+    const std::size_t word = first / kWordBits;
+    const std::size_t end = std::min((word + 1) * kWordBits, last);
+    const auto mask =
+        range_mask(first % kWordBits, end - word * kWordBits);
+    result += detail::popcount64(
+        words_[word].load(std::memory_order_relaxed) & mask);
+    first = end;
+  }
+
+  return result;
+}
+
+inline std::size_t ConcurrentBitmap::find_first_zero(
+    std::size_t first, std::size_t last) const noexcept {
+  // Read every word, do not skip the ones the summary marks full. mark_full
+  // sets a summary bit before it checks the word again, so a bit freed in
+  // that window is clear in the word but not yet in the summary.
+  while (first < last) {
+    const std::size_t word = first / kWordBits;
+    const std::size_t end = std::min((word + 1) * kWordBits, last);
+    const auto mask = range_mask(first % kWordBits, end - word * kWordBits);
+    const auto zeros = ~words_[word].load(std::memory_order_relaxed) & mask;
+    if (zeros != 0) {
+      return word * kWordBits + detail::countr_zero64(zeros);
+    }
+
+    first = end;
+  }
+
+  return npos;
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_CONCURRENT_BITMAP_HPP_
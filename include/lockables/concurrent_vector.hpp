@@ -0,0 +1,367 @@
+//
+// lockables/concurrent_vector.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  ConcurrentVector<T> is an append only vector. Writers push_back without a
+  lock. Readers iterate up to the published size without a lock. Elements are
+  stored in segments that double in size and are never relocated, so element
+  addresses are stable.
+
+  ConcurrentVector {
+    std::atomic<Slot*> segments[N]
+    std::atomic<size_t> reserved
+    std::atomic<size_t> published
+  }
+
+  Usage:
+
+  ConcurrentVector<Event> events;
+
+  // Writer threads.
+  events.push_back(Event{1});
+
+  // Reader threads. Only visits the elements published when begin() and end()
+  // were called.
+  for (const Event& event : events) {
+    // ...
+  }
+*/
+#ifndef LOCKABLES_CONCURRENT_VECTOR_HPP_
+#define LOCKABLES_CONCURRENT_VECTOR_HPP_
+
+#include <lockables/cache_line.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace lockables {
+
+namespace detail {
+
+/**
+  Index of the highest set bit. Undefined for zero.
+*/
+constexpr unsigned floor_log2(std::size_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(sizeof(unsigned long long) * 8 - 1) -
+         static_cast<unsigned>(
+             __builtin_clzll(static_cast<unsigned long long>(value)));
+#else
+  unsigned result = 0;
+  while (value >>= 1) {
+    ++result;
+  }
+  return result;
+#endif
+}
+
+}  // namespace detail
+
+/**
+  ConcurrentVector<T> stores elements in segments. Segment 0 holds the first
+  kFirstSegmentSize elements and each following segment is twice as large as
+  the one before it. A segment is allocated by the first writer that needs it.
+
+  The push_back methods reserve an index with one atomic increment, construct
+  the element in place, and then mark it ready. The published size only moves
+  past an index once the element and all of the elements before it are ready,
+  so readers never see a partially constructed element. Writers that finish
+  out of order advance the published size for each other.
+
+  If the constructor of T throws, its index is never published and neither is
+  any element after it.
+
+  Elements are never moved or destroyed until the vector is destroyed. The
+  vector only synchronizes the append. If elements are modified after they are
+  published, the element type must provide its own synchronization.
+*/
+template <typename T>
+class ConcurrentVector {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using reference = T&;
+  using const_reference = const T&;
+
+  class const_iterator;
+
+  static constexpr std::size_t kFirstSegmentSize = 64;
+
+  ConcurrentVector() = default;
+
+  // Rule of 5. No copy or move.
+  ConcurrentVector(const ConcurrentVector&) = delete;
+  ConcurrentVector(ConcurrentVector&&) noexcept = delete;
+  ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+  ConcurrentVector& operator=(ConcurrentVector&&) noexcept = delete;
+  ~ConcurrentVector();
+
+  /**
+    Construct an element at the back of the vector. Return its index. Never
+    locks. The element is visible to readers once all of the elements before
+    it are also constructed.
+  */
+  template <typename... Args>
+  std::size_t emplace_back(Args&&... args);
+
+  std::size_t push_back(const T& value) { return emplace_back(value); }
+  std::size_t push_back(T&& value) { return emplace_back(std::move(value)); }
+
+  /**
+    Number of published elements. Elements [0, size()) may be read without a
+    lock.
+  */
+  [[nodiscard]] std::size_t size() const noexcept {
+    return published_.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  /**
+    Access a published element. The index must be less than size().
+  */
+  [[nodiscard]] T& operator[](std::size_t index) noexcept;
+  [[nodiscard]] const T& operator[](std::size_t index) const noexcept;
+
+  /**
+    Access a published element. Throws std::out_of_range if index is not less
+    than size().
+  */
+  [[nodiscard]] T& at(std::size_t index);
+  [[nodiscard]] const T& at(std::size_t index) const;
+
+  /**
+    Iterate over the published elements. Elements pushed after the call to
+    end() are not visited.
+  */
+  [[nodiscard]] const_iterator begin() const noexcept {
+    return const_iterator{this, 0};
+  }
+  [[nodiscard]] const_iterator end() const noexcept {
+    return const_iterator{this, size()};
+  }
+
+ private:
+  struct Slot {
+    std::atomic<bool> ready;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T* value() noexcept {
+      return std::launder(reinterpret_cast<T*>(storage));
+    }
+    const T* value() const noexcept {
+      return std::launder(reinterpret_cast<const T*>(storage));
+    }
+  };
+
+  static constexpr unsigned kFirstSegmentShift =
+      detail::floor_log2(kFirstSegmentSize);
+  static constexpr std::size_t kMaxSegment =
+      sizeof(std::size_t) * 8 - kFirstSegmentShift;
+
+  static_assert((kFirstSegmentSize & (kFirstSegmentSize - 1)) == 0,
+                "kFirstSegmentSize must be a power of two");
+
+  static constexpr unsigned segment_of(std::size_t index) noexcept {
+    return detail::floor_log2(index + kFirstSegmentSize) - kFirstSegmentShift;
+  }
+
+  static constexpr std::size_t segment_begin(unsigned segment) noexcept {
+    return (std::size_t{1} << (segment + kFirstSegmentShift)) -
+           kFirstSegmentSize;
+  }
+
+  static constexpr std::size_t segment_size(unsigned segment) noexcept {
+    return std::size_t{1} << (segment + kFirstSegmentShift);
+  }
+
+  // Slot for index, or nullptr if its segment is not allocated yet.
+  Slot* find_slot(std::size_t index) const noexcept;
+
+  // Slot for index. Allocates the segment if needed.
+  Slot& get_slot(std::size_t index);
+
+  // Move the published size forward over all ready elements.
+  void publish() noexcept;
+
+  std::atomic<Slot*> segments_[kMaxSegment] = {};
+
+  // Writers increment reserved, readers load published. Keep them apart.
+  alignas(kCacheLineSize) std::atomic<std::size_t> reserved_{};
+  alignas(kCacheLineSize) std::atomic<std::size_t> published_{};
+};
+
+/**
+  Forward iterator over a range of published elements.
+*/
+template <typename T>
+class ConcurrentVector<T>::const_iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const T*;
+  using reference = const T&;
+
+  const_iterator() = default;
+
+  reference operator*() const noexcept { return (*vector_)[index_]; }
+  pointer operator->() const noexcept { return &(*vector_)[index_]; }
+
+  const_iterator& operator++() noexcept {
+    ++index_;
+    return *this;
+  }
+
+  const_iterator operator++(int) noexcept {
+    const_iterator copy{*this};
+    ++index_;
+    return copy;
+  }
+
+  friend bool operator==(const const_iterator& lhs,
+                         const const_iterator& rhs) noexcept {
+    return lhs.index_ == rhs.index_;
+  }
+
+  friend bool operator!=(const const_iterator& lhs,
+                         const const_iterator& rhs) noexcept {
+    return lhs.index_ != rhs.index_;
+  }
+
+ private:
+  friend class ConcurrentVector;
+
+  const_iterator(const ConcurrentVector* vector, std::size_t index) noexcept
+      : vector_{vector}, index_{index} {}
+
+  const ConcurrentVector* vector_{};
+  std::size_t index_{};
+};
+
+template <typename T>
+ConcurrentVector<T>::~ConcurrentVector() {
+  for (unsigned segment = 0; segment < kMaxSegment; ++segment) {
+    Slot* slots = segments_[segment].load(std::memory_order_relaxed);
+    if (slots == nullptr) {
+      continue;
+    }
+
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (std::size_t i = 0; i < segment_size(segment); ++i) {
+        if (slots[i].ready.load(std::memory_order_relaxed)) {
+          std::destroy_at(slots[i].value());
+        }
+      }
+    }
+
+    delete[] slots;
+  }
+}
+
+template <typename T>
+auto ConcurrentVector<T>::find_slot(std::size_t index) const noexcept
+    -> Slot* {
+  const auto segment = segment_of(index);
+  Slot* slots = segments_[segment].load(std::memory_order_acquire);
+  if (slots == nullptr) {
+    return nullptr;
+  }
+
+  return &slots[index - segment_begin(segment)];
+}
+
+template <typename T>
+auto ConcurrentVector<T>::get_slot(std::size_t index) -> Slot& {
+  const auto segment = segment_of(index);
+  if (segment >= kMaxSegment) {
+    throw std::length_error{"ConcurrentVector is full"};
+  }
+
+  Slot* slots = segments_[segment].load(std::memory_order_acquire);
+  if (slots == nullptr) {
+    // Race the other writers to install the segment. The loser frees its copy.
+    std::unique_ptr<Slot[]> allocated{new Slot[segment_size(segment)]()};
+    if (segments_[segment].compare_exchange_strong(
+            slots, allocated.get(), std::memory_order_acq_rel,
+            std::memory_order_acquire)) {
+      slots = allocated.release();
+    }
+  }
+
+  return slots[index - segment_begin(segment)];
+}
+
+template <typename T>
+void ConcurrentVector<T>::publish() noexcept {
+  // The ready flags use sequentially consistent stores and loads. A writer
+  // that stops because the element before it is not ready yet is guaranteed
+  // that the writer of that element will see its ready flag and keep going.
+  auto published = published_.load(std::memory_order_acquire);
+  for (;;) {
+    const Slot* slot = find_slot(published);
+    if (slot == nullptr || !slot->ready.load(std::memory_order_seq_cst)) {
+      return;
+    }
+
+    // On failure published is reloaded, try again from there.
+    if (published_.compare_exchange_weak(published, published + 1,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+      ++published;
+    }
+  }
+}
+
+template <typename T>
+template <typename... Args>
+std::size_t ConcurrentVector<T>::emplace_back(Args&&... args) {
+  const auto index = reserved_.fetch_add(1, std::memory_order_relaxed);
+
+  Slot& slot = get_slot(index);
+  ::new (static_cast<void*>(slot.storage)) T(std::forward<Args>(args)...);
+  slot.ready.store(true, std::memory_order_seq_cst);
+
+  publish();
+  return index;
+}
+
+template <typename T>
+T& ConcurrentVector<T>::operator[](std::size_t index) noexcept {
+  return *find_slot(index)->value();
+}
+
+template <typename T>
+const T& ConcurrentVector<T>::operator[](std::size_t index) const noexcept {
+  return *find_slot(index)->value();
+}
+
+template <typename T>
+T& ConcurrentVector<T>::at(std::size_t index) {
+  if (index >= size()) {
+    throw std::out_of_range{"ConcurrentVector index out of range"};
+  }
+
+  return (*this)[index];
+}
+
+template <typename T>
+const T& ConcurrentVector<T>::at(std::size_t index) const {
+  if (index >= size()) {
+    throw std::out_of_range{"ConcurrentVector index out of range"};
+  }
+
+  return (*this)[index];
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_CONCURRENT_VECTOR_HPP_
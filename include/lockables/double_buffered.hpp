@@ -0,0 +1,266 @@
+//
+// lockables/double_buffered.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  DoubleBuffered<T> is for values that are rebuilt in bulk while readers keep
+  querying them. Readers use the front buffer. The writer rebuilds the back
+  buffer without blocking any reader, then swaps the two in O(1).
+
+  DoubleBuffered {
+    T buffers[2]
+    std::atomic<size_t> readers[2]  // one per cache line
+    std::atomic<unsigned> front
+    Mutex mutex                     // writers only
+  }
+
+  Readers access the value using the pointer like DoubleBufferedScope<T>
+  object. Writers access the back buffer using DoubleBufferedBackScope<T>.
+
+  DoubleBufferedScope {
+    std::atomic<size_t>& readers
+    const T* non_owning
+  }
+
+  Usage:
+
+  DoubleBuffered<Index> index;
+
+  // Reader. Never waits for the writer.
+  {
+    const auto guard = index.with_shared();
+    auto result = guard->find(key);
+  }
+
+  // Writer. Rebuild the back buffer, then publish it.
+  {
+    auto back = index.with_back();
+    back->rebuild(records);
+  }
+  index.swap();
+*/
+#ifndef LOCKABLES_DOUBLE_BUFFERED_HPP_
+#define LOCKABLES_DOUBLE_BUFFERED_HPP_
+
+#include <lockables/cache_line.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace lockables {
+
+/**
+  Pointer like object for the front buffer of a DoubleBuffered<T>. Keeps the
+  buffer from being reused by the writer while it is alive.
+*/
+template <typename T>
+class DoubleBufferedScope;
+
+/**
+  Pointer like object for the back buffer of a DoubleBuffered<T>. Holds the
+  writer lock while it is alive.
+*/
+template <typename T, typename Mutex>
+class DoubleBufferedBackScope;
+
+/**
+  DoubleBuffered<T, Mutex> owns two values of T, the front buffer that readers
+  use and the back buffer that the writer rebuilds. Readers never lock and
+  never wait for the writer.
+
+  Each buffer has a count of active readers. A reader increments the count of
+  the front buffer, then checks that it is still the front buffer. The
+  with_back() method waits for the count of the back buffer to drain to zero,
+  i.e., for the readers that started before the last swap() to finish, before
+  it hands out the back buffer. The swap() method only stores the new front
+  index.
+
+  The back buffer is not a copy of the front buffer. It holds the value from
+  before the last swap(). The writer should rebuild the whole value.
+
+  Writers are serialized by the mutex. A reader that holds a scope across a
+  swap() blocks the next with_back() until it releases the scope.
+*/
+template <typename T, typename Mutex = std::mutex>
+class DoubleBuffered {
+ public:
+  using value_type = T;
+  using mutex_type = Mutex;
+
+  /**
+    Construct both buffers with arguments. Uses brace initialization, same as
+    Guarded<T>.
+  */
+  template <typename... Args>
+  explicit DoubleBuffered(const Args&... args)
+      : buffers_{T{args...}, T{args...}} {}
+
+  // Rule of 5. No copy or move.
+  DoubleBuffered(const DoubleBuffered&) = delete;
+  DoubleBuffered(DoubleBuffered&&) noexcept = delete;
+  DoubleBuffered& operator=(const DoubleBuffered&) = delete;
+  DoubleBuffered& operator=(DoubleBuffered&&) noexcept = delete;
+  ~DoubleBuffered() = default;
+
+  /**
+    Reader access to the front buffer. Lock free.
+  */
+  [[nodiscard]] DoubleBufferedScope<T> with_shared() const noexcept;
+
+  /**
+    Writer access to the back buffer. Locks the writer mutex and waits for
+    readers of the back buffer to finish. Readers do not see the changes until
+    swap().
+  */
+  [[nodiscard]] DoubleBufferedBackScope<T, Mutex> with_back();
+
+  /**
+    Writer. Make the back buffer the front buffer. Locks the writer mutex, so
+    the DoubleBufferedBackScope must be released first.
+  */
+  void swap();
+
+  /**
+    Writer. Call f(T&) with the back buffer and swap. Returns the result of f.
+    If f throws, nothing is swapped.
+  */
+  template <typename F>
+  auto update(F&& f) -> std::invoke_result_t<F, T&>;
+
+ private:
+  struct alignas(kCacheLineSize) Readers {
+    std::atomic<std::size_t> count{};
+  };
+
+  // Wait for the readers of the back buffer to finish. Call with the writer
+  // mutex held.
+  T& drain_back() noexcept;
+
+  T buffers_[2];
+  mutable Readers readers_[2]{};
+  alignas(kCacheLineSize) std::atomic<unsigned> front_{};
+  Mutex mutex_{};
+};
+
+template <typename T>
+class DoubleBufferedScope {
+ public:
+  using element_type = const T;
+  using pointer = const T*;
+  using reference = const T&;
+
+  DoubleBufferedScope(const T& value, std::atomic<std::size_t>& readers)
+      : readers_{readers}, non_owning_{&value} {}
+
+  // Rule of 5. No copy or move.
+  DoubleBufferedScope(const DoubleBufferedScope&) = delete;
+  DoubleBufferedScope(DoubleBufferedScope&&) noexcept = delete;
+  DoubleBufferedScope& operator=(const DoubleBufferedScope&) = delete;
+  DoubleBufferedScope& operator=(DoubleBufferedScope&&) noexcept = delete;
+  ~DoubleBufferedScope() { readers_.fetch_sub(1, std::memory_order_release); }
+
+  [[nodiscard]] pointer get() const noexcept { return non_owning_; }
+  [[nodiscard]] reference operator*() const noexcept { return *non_owning_; }
+  [[nodiscard]] pointer operator->() const noexcept { return non_owning_; }
+
+ private:
+  std::atomic<std::size_t>& readers_;
+  pointer non_owning_;
+};
+
+template <typename T, typename Mutex>
+class DoubleBufferedBackScope {
+ public:
+  using element_type = T;
+  using pointer = T*;
+  using reference = T&;
+
+  DoubleBufferedBackScope(T& value, std::unique_lock<Mutex> lock)
+      : lock_{std::move(lock)}, non_owning_{&value} {}
+
+  // Rule of 5. No copy or move.
+  DoubleBufferedBackScope(const DoubleBufferedBackScope&) = delete;
+  DoubleBufferedBackScope(DoubleBufferedBackScope&&) noexcept = delete;
+  DoubleBufferedBackScope& operator=(const DoubleBufferedBackScope&) = delete;
+  DoubleBufferedBackScope& operator=(DoubleBufferedBackScope&&) noexcept =
+      delete;
+  ~DoubleBufferedBackScope() = default;
+
+  [[nodiscard]] pointer get() const noexcept { return non_owning_; }
+  [[nodiscard]] reference operator*() const noexcept { return *non_owning_; }
+  [[nodiscard]] pointer operator->() const noexcept { return non_owning_; }
+
+ private:
+  std::unique_lock<Mutex> lock_;
+  pointer non_owning_;
+};
+
+template <typename T, typename Mutex>
+DoubleBufferedScope<T> DoubleBuffered<T, Mutex>::with_shared() const noexcept {
+  unsigned front = front_.load(std::memory_order_acquire);
+  for (;;) {
+    auto& readers = readers_[front].count;
+    readers.fetch_add(1, std::memory_order_seq_cst);
+
+    // Pairs with the store in swap() and the load in drain_back(). Either the
+    // writer sees this reader, or this reader sees the new front.
+    const unsigned current = front_.load(std::memory_order_seq_cst);
+    if (current == front) {
+      return DoubleBufferedScope<T>{buffers_[front], readers};
+    }
+
+    readers.fetch_sub(1, std::memory_order_release);
+    front = current;
+  }
+}
+
+template <typename T, typename Mutex>
+DoubleBufferedBackScope<T, Mutex> DoubleBuffered<T, Mutex>::with_back() {
+  std::unique_lock<Mutex> lock{mutex_};
+  return DoubleBufferedBackScope<T, Mutex>{drain_back(), std::move(lock)};
+}
+
+template <typename T, typename Mutex>
+void DoubleBuffered<T, Mutex>::swap() {
+  std::scoped_lock<Mutex> lock{mutex_};
+  front_.store(1 - front_.load(std::memory_order_relaxed),
+               std::memory_order_seq_cst);
+}
+
+template <typename T, typename Mutex>
+template <typename F>
+auto DoubleBuffered<T, Mutex>::update(F&& f) -> std::invoke_result_t<F, T&> {
+  std::scoped_lock<Mutex> lock{mutex_};
+  T& back = drain_back();
+  const unsigned next = 1 - front_.load(std::memory_order_relaxed);
+  if constexpr (std::is_void_v<std::invoke_result_t<F, T&>>) {
+    std::invoke(std::forward<F>(f), back);
+    front_.store(next, std::memory_order_seq_cst);
+  } else {
+    auto result = std::invoke(std::forward<F>(f), back);
+    front_.store(next, std::memory_order_seq_cst);
+    return result;
+  }
+}
+
+template <typename T, typename Mutex>
+T& DoubleBuffered<T, Mutex>::drain_back() noexcept {
+  // Only writers change the front index, and they hold the mutex.
+  const unsigned back = 1 - front_.load(std::memory_order_relaxed);
+  const auto& readers = readers_[back].count;
+  while (readers.load(std::memory_order_seq_cst) != 0) {
+    std::this_thread::yield();
+  }
+
+  return buffers_[back];
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_DOUBLE_BUFFERED_HPP_
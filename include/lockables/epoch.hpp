@@ -0,0 +1,424 @@
+//
+// lockables/epoch.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  EpochDomain is epoch based memory reclamation for lock free containers.
+  Readers pin the domain while they hold pointers to shared nodes. Writers
+  retire nodes after they unlink them. A retired node is freed once every
+  thread that could have seen it has unpinned.
+
+  EpochDomain {
+    std::atomic<uint64_t> epoch
+    Record {
+      std::atomic<uint64_t> epoch  // pinned epoch, or inactive
+      Bag {
+        uint64_t epoch
+        std::vector<Retired> items
+      } bags[3]
+    } records[num_thread]
+  }
+
+  The pointer like EpochGuard object holds the pin, in the style of
+  GuardedScope.
+
+  EpochGuard {
+    EpochDomain& domain
+    Record* record
+  }
+
+  Usage:
+
+  EpochDomain domain;
+  std::atomic<Node*> head;
+
+  {
+    // Reader. Nodes reachable from head are not freed while guard is alive.
+    auto guard = domain.pin();
+
+    Node* node = head.load();
+    // ...
+  }
+
+  // Writer. Unlink the node first, then retire it.
+  Node* node = head.exchange(nullptr);
+  domain.retire(node);
+
+  References:
+
+  Keir Fraser, Practical lock-freedom, PhD thesis, University of Cambridge,
+  2004.
+*/
+#ifndef LOCKABLES_EPOCH_HPP_
+#define LOCKABLES_EPOCH_HPP_
+
+#include <lockables/cache_line.hpp>
+#include <lockables/thread_records.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace lockables {
+
+class EpochGuard;
+
+/**
+  EpochDomain tracks a global epoch and one record per thread that uses the
+  domain. Pinning copies the global epoch into the thread's record. The global
+  epoch only advances when every pinned thread has seen the current one, so a
+  thread that is pinned holds the global epoch to within one of its own.
+
+  A node retired in epoch e is put in a per thread bag for that epoch. It is
+  safe to free once the global epoch reaches e + 2. Each thread frees its own
+  bags. After every batch_size retires it tries to advance the global epoch and
+  frees the bags that are old enough, so the cost is amortized over the batch.
+
+  A pinned thread that stalls stops the epoch and therefore all reclamation,
+  no other thread can free its nodes for it. If max_retired is set, it is back
+  pressure on the writers. A thread that has more than max_retired nodes
+  waiting to be freed waits at its next quiescent point, an unpinned retire()
+  or the end of its outermost pin, for the stalled readers to move on. It
+  waits for at most max_wait and then goes on with the nodes still queued, so
+  the limit is soft. While a reader is stalled, every such quiescent point
+  waits again, which slows the writer down to one retire per max_wait.
+  Readers that stay pinned for a long time may call EpochGuard::repin() when
+  they hold no pointers to let the epoch move.
+
+  When a thread exits, its record and any nodes still waiting in it are
+  handed to the next thread that uses the domain. The destructor frees all of
+  the remaining nodes. No thread may be pinned when the domain is destroyed.
+*/
+class EpochDomain {
+ public:
+  using deleter_type = void (*)(void*);
+
+  static constexpr std::size_t kDefaultBatchSize = 64;
+  static constexpr std::size_t kUnbounded = 0;
+  static constexpr std::chrono::nanoseconds kDefaultMaxWait =
+      std::chrono::milliseconds{10};
+
+  explicit EpochDomain(std::size_t batch_size = kDefaultBatchSize,
+                       std::size_t max_retired = kUnbounded,
+                       std::chrono::nanoseconds max_wait = kDefaultMaxWait);
+
+  // Rule of 5. No copy or move.
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain(EpochDomain&&) noexcept = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+  EpochDomain& operator=(EpochDomain&&) noexcept = delete;
+  ~EpochDomain();
+
+  /**
+    Pin the calling thread. Pins nest, only the outermost one is published.
+  */
+  [[nodiscard]] EpochGuard pin();
+
+  /**
+    Call deleter(ptr) once no thread that was pinned at the time of this call
+    is still pinned. The caller must have unlinked ptr so that threads that
+    pin later can not reach it.
+  */
+  void retire(void* ptr, deleter_type deleter);
+
+  template <typename T>
+  void retire(T* ptr) {
+    retire(static_cast<void*>(ptr),
+           [](void* p) { delete static_cast<T*>(p); });
+  }
+
+  /**
+    Try to advance the global epoch and free the calling thread's retired
+    nodes that are old enough.
+  */
+  void collect();
+
+  /**
+    Current global epoch.
+  */
+  [[nodiscard]] std::uint64_t epoch() const noexcept {
+    return epoch_.load(std::memory_order_relaxed);
+  }
+
+  /**
+    Approximate number of retired nodes that are not freed yet, over all
+    threads.
+  */
+  [[nodiscard]] std::size_t retired_approx() const noexcept;
+
+ private:
+  friend class EpochGuard;
+  friend class detail::ThreadRecords<EpochDomain>;
+
+  struct Retired {
+    void* ptr;
+    deleter_type deleter;
+  };
+
+  struct Bag {
+    std::uint64_t epoch{};
+    std::vector<Retired> items{};
+  };
+
+  static constexpr std::uint64_t kInactive =
+      std::numeric_limits<std::uint64_t>::max();
+  static constexpr std::size_t kNumBag = 3;
+
+  struct alignas(kCacheLineSize) Record {
+    // Written by the owner. Read by threads that try to advance the epoch.
+    std::atomic<std::uint64_t> epoch{kInactive};
+    std::atomic<bool> in_use{};
+    std::atomic<std::size_t> num_retired{};
+    // Immutable once the record is published.
+    Record* next{};
+
+    // Owner only.
+    std::size_t depth{};
+    std::size_t num_since_collect{};
+    Bag bags[kNumBag]{};
+  };
+
+  using Records = detail::ThreadRecords<EpochDomain>;
+
+  // The calling thread's record in this domain.
+  Record& local() { return Records::local(id_, slot_, records_); }
+
+  // Thread exit. Free what is old enough, the rest waits for the next thread
+  // that takes over the record.
+  void release_record(Record& record) { collect(record); }
+
+  void enter(Record& record) noexcept;
+  void leave(Record& record);
+
+  bool try_advance() noexcept;
+  void collect(Record& record);
+  static void free_bag(Record& record, Bag& bag);
+
+  // Back pressure. Collect until record is at or under max_retired_, or
+  // until max_wait_ has passed.
+  void throttle(Record& record);
+
+  std::uint64_t id_;
+  std::size_t slot_;
+  std::size_t batch_size_;
+  std::size_t max_retired_;
+  std::chrono::nanoseconds max_wait_;
+  detail::RecordList<Record> records_{};
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> epoch_{};
+};
+
+/**
+  RAII pin on an EpochDomain. Nodes that the thread loads while the guard is
+  alive are not freed until it goes out of scope.
+*/
+class EpochGuard {
+ public:
+  explicit EpochGuard(EpochDomain& domain)
+      : domain_{domain}, record_{domain.local()} {
+    domain_.enter(record_);
+  }
+
+  // Rule of 5. No copy or move.
+  EpochGuard(const EpochGuard&) = delete;
+  EpochGuard(EpochGuard&&) noexcept = delete;
+  EpochGuard& operator=(const EpochGuard&) = delete;
+  EpochGuard& operator=(EpochGuard&&) noexcept = delete;
+  ~EpochGuard() { domain_.leave(record_); }
+
+  /**
+    Unpin and pin again so that a long running reader does not hold back the
+    epoch. The caller must not use any pointer it loaded before the call. Does
+    nothing inside of a nested pin.
+  */
+  void repin() noexcept;
+
+ private:
+  EpochDomain& domain_;
+  EpochDomain::Record& record_;
+};
+
+inline EpochDomain::EpochDomain(std::size_t batch_size,
+                                std::size_t max_retired,
+                                std::chrono::nanoseconds max_wait)
+    : id_{Records::next_id()},
+      slot_{Records::acquire_slot()},
+      batch_size_{std::max<std::size_t>(batch_size, 1)},
+      max_retired_{max_retired},
+      max_wait_{max_wait} {
+  Records::registry().with_exclusive()->emplace(id_, this);
+}
+
+inline EpochDomain::~EpochDomain() {
+  // Wait for exiting threads that are handing back their records.
+  Records::registry().with_exclusive()->erase(id_);
+  Records::release_slot(slot_);
+
+  // The records are deleted with records_.
+  for (Record* record = records_.head(); record != nullptr;
+       record = record->next) {
+    for (Bag& bag : record->bags) {
+      for (const Retired& item : bag.items) {
+        item.deleter(item.ptr);
+      }
+    }
+  }
+}
+
+inline EpochGuard EpochDomain::pin() { return EpochGuard{*this}; }
+
+inline void EpochDomain::enter(Record& record) noexcept {
+  if (record.depth++ != 0) {
+    return;
+  }
+
+  // Publish the pin before any load of a shared pointer. The seq_cst exchange
+  // pairs with the loads in try_advance(). It also releases the accesses of
+  // the previous pin to the thread that sees the new one.
+  record.epoch.exchange(epoch_.load(std::memory_order_seq_cst),
+                        std::memory_order_seq_cst);
+}
+
+inline void EpochDomain::leave(Record& record) {
+  if (--record.depth != 0) {
+    return;
+  }
+
+  record.epoch.store(kInactive, std::memory_order_release);
+
+  if (max_retired_ != kUnbounded &&
+      record.num_retired.load(std::memory_order_relaxed) > max_retired_) {
+    throttle(record);
+  }
+}
+
+inline void EpochGuard::repin() noexcept {
+  if (record_.depth != 1) {
+    return;
+  }
+
+  const auto epoch = domain_.epoch_.load(std::memory_order_seq_cst);
+  if (record_.epoch.load(std::memory_order_relaxed) == epoch) {
+    return;
+  }
+
+  // Same as enter().
+  record_.epoch.exchange(epoch, std::memory_order_seq_cst);
+}
+
+inline void EpochDomain::retire(void* ptr, deleter_type deleter) {
+  Record& record = local();
+
+  // Read the epoch after the caller unlinked ptr.
+  const auto epoch = epoch_.load(std::memory_order_seq_cst);
+  Bag& bag = record.bags[epoch % kNumBag];
+  if (bag.epoch != epoch) {
+    // The bag is from epoch - 3 or older. Everything in it is safe to free.
+    free_bag(record, bag);
+    bag.epoch = epoch;
+  }
+
+  bag.items.push_back(Retired{ptr, deleter});
+  record.num_retired.store(
+      record.num_retired.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+
+  if (++record.num_since_collect >= batch_size_) {
+    collect(record);
+  }
+
+  if (max_retired_ != kUnbounded && record.depth == 0 &&
+      record.num_retired.load(std::memory_order_relaxed) > max_retired_) {
+    throttle(record);
+  }
+}
+
+inline void EpochDomain::collect() { collect(local()); }
+
+inline std::size_t EpochDomain::retired_approx() const noexcept {
+  std::size_t count = 0;
+  for (const Record* record = records_.head(); record != nullptr;
+       record = record->next) {
+    count += record->num_retired.load(std::memory_order_relaxed);
+  }
+
+  return count;
+}
+
+inline bool EpochDomain::try_advance() noexcept {
+  const auto epoch = epoch_.load(std::memory_order_seq_cst);
+
+  // Pairs with the exchange in enter(). A seq_cst load is also an acquire of
+  // the accesses that the reader made before it unpinned or pinned again, so
+  // they happen before the nodes are freed.
+  for (const Record* record = records_.head(); record != nullptr;
+       record = record->next) {
+    const auto pinned = record->epoch.load(std::memory_order_seq_cst);
+    if (pinned != kInactive && pinned != epoch) {
+      return false;
+    }
+  }
+
+  auto expected = epoch;
+  epoch_.compare_exchange_strong(expected, epoch + 1,
+                                 std::memory_order_release,
+                                 std::memory_order_relaxed);
+  return true;
+}
+
+inline void EpochDomain::collect(Record& record) {
+  record.num_since_collect = 0;
+  try_advance();
+
+  const auto epoch = epoch_.load(std::memory_order_acquire);
+  for (Bag& bag : record.bags) {
+    if (!bag.items.empty() && bag.epoch + 2 <= epoch) {
+      free_bag(record, bag);
+    }
+  }
+}
+
+inline void EpochDomain::free_bag(Record& record, Bag& bag) {
+  if (bag.items.empty()) {
+    return;
+  }
+
+  // A deleter may retire more nodes into this record. Free a copy.
+  std::vector<Retired> items;
+  items.swap(bag.items);
+  record.num_retired.store(
+      record.num_retired.load(std::memory_order_relaxed) - items.size(),
+      std::memory_order_relaxed);
+
+  for (const Retired& item : items) {
+    item.deleter(item.ptr);
+  }
+
+  // Keep the capacity for the next epoch.
+  if (bag.items.empty()) {
+    items.clear();
+    bag.items.swap(items);
+  }
+}
+
+inline void EpochDomain::throttle(Record& record) {
+  const auto deadline = std::chrono::steady_clock::now() + max_wait_;
+  for (;;) {
+    collect(record);
+    if (record.num_retired.load(std::memory_order_relaxed) <= max_retired_ ||
+        std::chrono::steady_clock::now() >= deadline) {
+      return;
+    }
+
+    std::this_thread::yield();
+  }
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_EPOCH_HPP_
@@ -44,6 +44,9 @@
 #ifndef LOCKABLES_GUARDED_HPP_
 #define LOCKABLES_GUARDED_HPP_
 
+#include <lockables/thread_annotations.hpp>
+#include <lockables/trace.hpp>
+
 #include <functional>
 #include <mutex>
 #include <shared_mutex>
@@ -67,6 +70,37 @@ namespace lockables {
 template <typename T, typename Mutex>
 class GuardedScope;
 
+/**
+  LockName is a constructor tag that names the mutex of a Guarded<T>, e.g., to
+  identify it in lock statistics. The name must outlive the mutex, use a string
+  literal.
+
+  Usage:
+
+  Guarded<Order, InstrumentedMutex<std::mutex>> order{LockName{"order"}};
+
+  A mutex that is not constructible from a LockName ignores the name, so the
+  same code builds with a plain std::mutex.
+*/
+struct LockName {
+  constexpr explicit LockName(const char* name) noexcept : value{name} {}
+
+  const char* value;
+};
+
+namespace detail {
+
+template <typename Mutex>
+Mutex make_mutex(LockName name) {
+  if constexpr (std::is_constructible_v<Mutex, LockName>) {
+    return Mutex{name};
+  } else {
+    return Mutex{};
+  }
+}
+
+}  // namespace detail
+
 /**
   Guarded<T> is a class template that stores a mutex together with the value it
   guards. Allow multiple reader threads or one writer thread access to the
@@ -78,6 +112,12 @@ class GuardedScope;
   The user must not keep a pointer or reference to the guarded value after the
   GuardedScope<T> goes out of scope.
 
+  The Clang Thread Safety Analysis, version 16 or newer, treats the returned
+  GuardedScope<T> as a scoped capability on the mutex. Build with
+  -Wthread-safety to catch, e.g., a second lock of the same value in one scope.
+  Method bodies and the with_exclusive function are not analyzed, the std lock
+  types they use may not be annotated.
+
   Usage:
 
   // Parameters are forwarded to the std::vector constructor.
@@ -128,6 +168,13 @@ class Guarded {
   template <typename... Args>
   explicit Guarded(Args&&... args);
 
+  /**
+    Construct a guarded value of type T with a named mutex. All arguments in
+    the parameter pack Args are forwarded to the constructor of T.
+   */
+  template <typename... Args>
+  explicit Guarded(LockName name, Args&&... args);
+
   /**
     Reader thread access. Acquires a shared lock. Return a pointer like object
     to the guarded value.
@@ -153,7 +200,8 @@ class Guarded {
       }
     }
   */
-  [[nodiscard]] shared_scope with_shared() const;
+  [[nodiscard]] shared_scope with_shared() const
+      LOCKABLES_ACQUIRE_SHARED(mutex_) LOCKABLES_NO_THREAD_SAFETY_ANALYSIS;
 
   /**
     Writer thread access. Acquires an exclusive lock. Return a pointer like
@@ -179,10 +227,11 @@ class Guarded {
       guard->push_back(10);
     }
    */
-  [[nodiscard]] exclusive_scope with_exclusive();
+  [[nodiscard]] exclusive_scope with_exclusive() LOCKABLES_ACQUIRE(mutex_)
+      LOCKABLES_NO_THREAD_SAFETY_ANALYSIS;
 
  private:
-  T value_{};
+  T value_ LOCKABLES_GUARDED_BY(mutex_){};
   mutable Mutex mutex_{};
 
   // The with_exclusive function needs access to the internals to lock multiple
@@ -197,6 +246,12 @@ template <typename... Args>
 Guarded<T, Mutex>::Guarded(Args&&... args)
     : value_{std::forward<Args>(args)...} {}
 
+template <typename T, typename Mutex>
+template <typename... Args>
+Guarded<T, Mutex>::Guarded(LockName name, Args&&... args)
+    : value_{std::forward<Args>(args)...},
+      mutex_{detail::make_mutex<Mutex>(name)} {}
+
 template <typename T, typename Mutex>
 auto Guarded<T, Mutex>::with_shared() const -> shared_scope {
   return shared_scope{&value_, mutex_};
@@ -207,6 +262,22 @@ auto Guarded<T, Mutex>::with_exclusive() -> exclusive_scope {
   return exclusive_scope{&value_, mutex_};
 }
 
+/**
+  Type trait to select which lock the with_exclusive function uses to lock one
+  or more mutexes at once.
+
+  Defaults to std::scoped_lock<MutexTypes...>, which uses a deadlock avoidance
+  algorithm to lock multiple mutexes. Specialize it for mutex types with a
+  known lock order.
+*/
+template <typename... MutexTypes>
+struct ExclusiveLock {
+  using type = std::scoped_lock<MutexTypes...>;
+};
+
+template <typename... MutexTypes>
+using exclusive_lock_t = typename ExclusiveLock<MutexTypes...>::type;
+
 /**
   The with_exclusive function provides access to one or more Guarded<T> objects
   from a user supplied callback.
@@ -223,7 +294,8 @@ auto Guarded<T, Mutex>::with_exclusive() -> exclusive_scope {
       value);
 
   The intent is to support locking of multiple Guarded<T> objects. The
-  with_exclusive function relies on std::scoped_lock for deadlock avoidance.
+  with_exclusive function relies on std::scoped_lock for deadlock avoidance,
+  or on the lock order of the mutex types, see ExclusiveLock.
 
   Usage:
 
@@ -245,8 +317,9 @@ auto Guarded<T, Mutex>::with_exclusive() -> exclusive_scope {
 */
 template <typename F, typename... ValueTypes, typename... MutexTypes>
 std::invoke_result_t<F, ValueTypes&...> with_exclusive(
-    F&& f, Guarded<ValueTypes, MutexTypes>&... values) {
-  std::scoped_lock<MutexTypes...> lock{
+    F&& f, Guarded<ValueTypes, MutexTypes>&... values)
+    LOCKABLES_NO_THREAD_SAFETY_ANALYSIS {
+  exclusive_lock_t<MutexTypes...> lock{
       std::forward<MutexTypes&>(values.mutex_)...};
   return std::invoke(std::forward<F>(f),
                      std::forward<ValueTypes&>(values.value_)...);
@@ -285,12 +358,30 @@ struct SharedLock<std::shared_timed_mutex> {
   using type = std::shared_lock<std::shared_timed_mutex>;
 };
 
+/**
+  SharedLock for a mutex type that wraps another one and names it in its
+  mutex_type member. Readers of a Guarded<T, Wrapper> use a shared lock if
+  readers of a Guarded<T, Wrapper::mutex_type> do.
+
+  Usage:
+
+  template <typename Mutex>
+  struct SharedLock<MyMutex<Mutex>> : WrappedSharedLock<MyMutex<Mutex>> {};
+*/
+template <typename Wrapper>
+struct WrappedSharedLock {
+  using type = std::conditional_t<
+      std::is_same_v<shared_lock_t<typename Wrapper::mutex_type>,
+                     std::scoped_lock<typename Wrapper::mutex_type>>,
+      std::scoped_lock<Wrapper>, std::shared_lock<Wrapper>>;
+};
+
 /**
   GuardedScope<T> is a pointer like object that owns a lock and has a non-owning
   pointer to the guarded value of type T in Guarded<T>.
 */
 template <typename T, typename Mutex>
-class GuardedScope {
+class LOCKABLES_SCOPED_CAPABILITY GuardedScope {
  public:
   // Model a restricted std::unique_ptr interface.
   using pointer = T*;
@@ -301,15 +392,33 @@ class GuardedScope {
   using lock_type = std::conditional_t<std::is_const_v<T>, shared_lock_t<Mutex>,
                                        std::scoped_lock<Mutex>>;
 
-  // RAII to support std::scoped_lock.
-  GuardedScope(pointer ptr, Mutex& mutex) : non_owning_{ptr}, lock_{mutex} {}
+  // RAII to support std::scoped_lock. A scoped capability for the Clang Thread
+  // Safety Analysis, shared if T is const. Optional USDT probes before and
+  // after the lock, see lockables/trace.hpp.
+  template <typename U = T, std::enable_if_t<!std::is_const_v<U>, int> = 0>
+  GuardedScope(pointer ptr, Mutex& mutex) LOCKABLES_ACQUIRE(mutex)
+      LOCKABLES_NO_THREAD_SAFETY_ANALYSIS
+      : non_owning_{detail::trace_lock_begin(ptr, mutex)},
+        lock_{mutex} {
+    detail::trace_lock_acquired(non_owning_, mutex);
+  }
+
+  template <typename U = T, std::enable_if_t<std::is_const_v<U>, int> = 0>
+  GuardedScope(pointer ptr, Mutex& mutex) LOCKABLES_ACQUIRE_SHARED(mutex)
+      LOCKABLES_NO_THREAD_SAFETY_ANALYSIS
+      : non_owning_{detail::trace_lock_begin(ptr, mutex)},
+        lock_{mutex} {
+    detail::trace_lock_acquired(non_owning_, mutex);
+  }
 
   // Rule of 5. No copy or move.
   GuardedScope(const GuardedScope&) = delete;
   GuardedScope(GuardedScope&&) noexcept = delete;
   GuardedScope& operator=(const GuardedScope&) = delete;
   GuardedScope& operator=(GuardedScope&&) noexcept = delete;
-  ~GuardedScope() = default;
+  ~GuardedScope() LOCKABLES_RELEASE() {
+    detail::trace_lock_release(non_owning_);
+  }
 
   explicit operator bool() const noexcept { return non_owning_ != nullptr; }
 
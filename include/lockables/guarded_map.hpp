@@ -0,0 +1,267 @@
+//
+// lockables/guarded_map.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  GuardedMap<Key, Value> is a class template that stripes a hash map across
+  multiple independently guarded segments. Each key belongs to one segment.
+  Operations on keys in different segments do not contend on the same mutex.
+
+  GuardedMap {
+    Guarded<std::unordered_map<Key, Value>, std::shared_mutex> segments[N]
+  }
+
+  Usage:
+
+  GuardedMap<std::string, int> map;
+
+  // Writer access to the segment that owns the key "a".
+  map.with_exclusive("a", [](auto& segment) { segment["a"] += 10; });
+
+  // Reader access to the segment that owns the key "a".
+  const int copy = map.with_shared("a", [](const auto& segment) {
+    auto itr = segment.find("a");
+    return itr != segment.end() ? itr->second : 0;
+  });
+
+  assert(copy == 10);
+*/
+#ifndef LOCKABLES_GUARDED_MAP_HPP_
+#define LOCKABLES_GUARDED_MAP_HPP_
+
+#include <lockables/cache_line.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/hash.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace lockables {
+
+/**
+  GuardedMap<Key, Value> stores a power of two number of
+  Guarded<std::unordered_map<Key, Value>, Mutex> segments. Methods select the
+  segment that owns a key and run a user supplied callback with a shared or
+  exclusive lock on that segment.
+
+  Each segment grows (rehashes) on its own, under its own lock, so a resize
+  only blocks the keys in one segment.
+
+  The callback receives the whole segment, which is a std::unordered_map. Only
+  access the key that was passed in, or other keys that map to the same
+  segment. The same rules as Guarded<T> apply: do not keep a pointer or
+  reference to the segment or its elements after the callback returns.
+
+  Usage:
+
+  GuardedMap<int, std::string> map{64};
+
+  map.with_exclusive(1, [](auto& segment) {
+    segment.emplace(1, "Hello");
+  });
+
+  // Whole map operations lock all of the segments.
+  const std::size_t size = map.size();
+
+  map.with_all_exclusive([](auto& segment) { segment.clear(); });
+*/
+template <typename Key, typename Value, typename Mutex = std::shared_mutex,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class GuardedMap {
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using segment_type = std::unordered_map<Key, Value, Hash, KeyEqual>;
+  using guarded_type = Guarded<segment_type, Mutex>;
+
+  static constexpr std::size_t kDefaultNumSegment = 16;
+
+  /**
+    Construct an empty map. The number of segments is rounded up to a power of
+    two.
+  */
+  explicit GuardedMap(std::size_t num_segment = kDefaultNumSegment);
+
+  /**
+    Reader access to the segment that owns key. Acquires a shared lock and
+    returns the result of f(const segment_type&).
+  */
+  template <typename F>
+  std::invoke_result_t<F, const segment_type&> with_shared(const Key& key,
+                                                           F&& f) const;
+
+  /**
+    Writer access to the segment that owns key. Acquires an exclusive lock and
+    returns the result of f(segment_type&).
+  */
+  template <typename F>
+  std::invoke_result_t<F, segment_type&> with_exclusive(const Key& key, F&& f);
+
+  /**
+    Reader access to the whole map. Acquires a shared lock on all segments, in
+    order, and then calls f(const segment_type&) once for each segment.
+  */
+  template <typename F>
+  void with_all_shared(F&& f) const;
+
+  /**
+    Writer access to the whole map. Acquires an exclusive lock on all segments,
+    in order, and then calls f(segment_type&) once for each segment.
+  */
+  template <typename F>
+  void with_all_exclusive(F&& f);
+
+  /**
+    Total number of elements. Locks all segments.
+  */
+  [[nodiscard]] std::size_t size() const;
+
+  /**
+    Reserve space for at least count elements spread over all segments. Locks
+    one segment at a time.
+  */
+  void reserve(std::size_t count);
+
+  [[nodiscard]] std::size_t num_segment() const noexcept {
+    return num_segment_;
+  }
+
+  /**
+    Index of the segment that owns key.
+  */
+  [[nodiscard]] std::size_t segment_index(const Key& key) const;
+
+ private:
+  // Pad each segment to its own cache line(s) so that locking one mutex does
+  // not invalidate the line of its neighbor.
+  struct alignas(kCacheLineSize) Segment {
+    guarded_type value{};
+  };
+
+  std::size_t num_segment_;
+  unsigned shift_;
+  std::unique_ptr<Segment[]> segments_;
+  Hash hash_{};
+};
+
+template <typename Key, typename Value, typename Mutex, typename Hash,
+          typename KeyEqual>
+GuardedMap<Key, Value, Mutex, Hash, KeyEqual>::GuardedMap(
+    std::size_t num_segment)
+    : num_segment_{1}, shift_{64} {
+  while (num_segment_ < num_segment) {
+    num_segment_ *= 2;
+    --shift_;
+  }
+
+  segments_ = std::make_unique<Segment[]>(num_segment_);
+}
+
+template <typename Key, typename Value, typename Mutex, typename Hash,
+          typename KeyEqual>
+std::size_t GuardedMap<Key, Value, Mutex, Hash, KeyEqual>::segment_index(
+    const Key& key) const {
+  if (num_segment_ == 1) {
+    return 0;
+  }
+
+  return detail::fibonacci_hash(static_cast<std::uint64_t>(hash_(key)), shift_);
+}
+
+template <typename Key, typename Value, typename Mutex, typename Hash,
+          typename KeyEqual>
+template <typename F>
+auto GuardedMap<Key, Value, Mutex, Hash, KeyEqual>::with_shared(const Key& key,
+                                                                F&& f) const
+    -> std::invoke_result_t<F, const segment_type&> {
+  const auto guard = segments_[segment_index(key)].value.with_shared();
+  return std::invoke(std::forward<F>(f), *guard);
+}
+
+template <typename Key, typename Value, typename Mutex, typename Hash,
+          typename KeyEqual>
+template <typename F>
+auto GuardedMap<Key, Value, Mutex, Hash, KeyEqual>::with_exclusive(
+    const Key& key, F&& f) -> std::invoke_result_t<F, segment_type&> {
+  auto guard = segments_[segment_index(key)].value.with_exclusive();
+  return std::invoke(std::forward<F>(f), *guard);
+}
+
+template <typename Key, typename Value, typename Mutex, typename Hash,
+          typename KeyEqual>
+template <typename F>
+void GuardedMap<Key, Value, Mutex, Hash, KeyEqual>::with_all_shared(
+    F&& f) const {
+  // GuardedScope is not movable, so build each one in place in an optional.
+  // Always lock in index order so that whole map operations do not deadlock
+  // each other. The scopes unlock in reverse order on the way out.
+  struct Locked {
+    explicit Locked(const guarded_type& value) : scope{value.with_shared()} {}
+
+    typename guarded_type::shared_scope scope;
+  };
+
+  auto locked = std::make_unique<std::optional<Locked>[]>(num_segment_);
+  for (std::size_t i = 0; i < num_segment_; ++i) {
+    locked[i].emplace(segments_[i].value);
+  }
+
+  for (std::size_t i = 0; i < num_segment_; ++i) {
+    std::invoke(f, *locked[i]->scope);
+  }
+}
+
+template <typename Key, typename Value, typename Mutex, typename Hash,
+          typename KeyEqual>
+template <typename F>
+void GuardedMap<Key, Value, Mutex, Hash, KeyEqual>::with_all_exclusive(F&& f) {
+  // Same as with_all_shared.
+  struct Locked {
+    explicit Locked(guarded_type& value) : scope{value.with_exclusive()} {}
+
+    typename guarded_type::exclusive_scope scope;
+  };
+
+  auto locked = std::make_unique<std::optional<Locked>[]>(num_segment_);
+  for (std::size_t i = 0; i < num_segment_; ++i) {
+    locked[i].emplace(segments_[i].value);
+  }
+
+  for (std::size_t i = 0; i < num_segment_; ++i) {
+    std::invoke(f, *locked[i]->scope);
+  }
+}
+
+template <typename Key, typename Value, typename Mutex, typename Hash,
+          typename KeyEqual>
+std::size_t GuardedMap<Key, Value, Mutex, Hash, KeyEqual>::size() const {
+  std::size_t count = 0;
+  with_all_shared([&count](const segment_type& segment) {
+    count += segment.size();
+  });
+  return count;
+}
+
+template <typename Key, typename Value, typename Mutex, typename Hash,
+          typename KeyEqual>
+void GuardedMap<Key, Value, Mutex, Hash, KeyEqual>::reserve(
+    std::size_t count) {
+  const std::size_t per_segment = (count + num_segment_ - 1) / num_segment_;
+  for (std::size_t i = 0; i < num_segment_; ++i) {
+    auto guard = segments_[i].value.with_exclusive();
+    guard->reserve(per_segment);
+  }
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_GUARDED_MAP_HPP_
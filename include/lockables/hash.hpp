@@ -0,0 +1,37 @@
+//
+// lockables/hash.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  Hash helpers shared by the striped and open addressing containers.
+*/
+#ifndef LOCKABLES_HASH_HPP_
+#define LOCKABLES_HASH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lockables {
+
+namespace detail {
+
+/**
+  Fibonacci hashing. Multiply by 2^64 divided by the golden ratio and keep the
+  high 64 - shift bits of the product, an index in [0, 2^(64 - shift)).
+
+  Spreads std::hash values that are the identity. The high bits are also not
+  correlated with the bucket index that std::unordered_map computes from the
+  low bits of the same hash. The shift is taken modulo 64.
+*/
+constexpr std::size_t fibonacci_hash(std::uint64_t hash,
+                                     unsigned shift) noexcept {
+  constexpr std::uint64_t kGoldenRatio = 0x9E3779B97F4A7C15ULL;
+  return static_cast<std::size_t>((hash * kGoldenRatio) >> (shift & 63U));
+}
+
+}  // namespace detail
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_HASH_HPP_
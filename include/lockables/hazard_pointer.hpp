@@ -0,0 +1,342 @@
+//
+// lockables/hazard_pointer.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  HazardDomain is hazard pointer memory reclamation for lock free containers.
+  A reader publishes the one pointer it is about to use in a hazard slot. A
+  writer retires nodes after it unlinks them. A retired node is freed by a
+  scan that finds no hazard slot pointing to it.
+
+  Unlike epoch based reclamation, a stalled reader only keeps the nodes that
+  it protects alive. The number of retired nodes that are not freed is
+  bounded by the scan threshold plus the number of hazard slots.
+
+  HazardDomain {
+    Slot {
+      std::atomic<const void*> ptr
+    } slots[num_hazard_pointer]
+    Retired* retired  // lock free stack
+  }
+
+  HazardPointer {
+    Slot& slot
+  }
+
+  Usage:
+
+  HazardDomain domain;
+  std::atomic<Node*> head;
+
+  {
+    // Reader. The node is not freed while hazard protects it.
+    HazardPointer hazard = domain.make_hazard_pointer();
+
+    Node* node = hazard.protect(head);
+    // ...
+  }
+
+  // Writer. Unlink the node first, then retire it.
+  Node* node = head.exchange(nullptr);
+  domain.retire(node);
+
+  References:
+
+  Maged M. Michael, Hazard Pointers: Safe Memory Reclamation for Lock-Free
+  Objects, IEEE TPDS 2004.
+
+  P2530, Hazard Pointers for C++26.
+*/
+#ifndef LOCKABLES_HAZARD_POINTER_HPP_
+#define LOCKABLES_HAZARD_POINTER_HPP_
+
+#include <lockables/cache_line.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace lockables {
+
+class HazardPointer;
+
+/**
+  HazardDomain owns the hazard slots and the list of retired nodes.
+
+  Every retire() pushes the node on a shared lock free stack. Once the number
+  of retired nodes reaches the threshold, which is the larger of
+  kMinScanThreshold and twice the number of hazard slots, the retiring thread
+  scans. It takes the whole stack, reads every hazard slot, frees the nodes
+  that are not protected, and pushes the rest back. At most one node per slot
+  survives a scan, so every scan frees at least half of the nodes it takes.
+
+  No HazardPointer may be alive when the domain is destroyed. The destructor
+  frees all of the remaining nodes.
+*/
+class HazardDomain {
+ public:
+  using deleter_type = void (*)(void*);
+
+  static constexpr std::size_t kMinScanThreshold = 64;
+
+  HazardDomain() = default;
+
+  // Rule of 5. No copy or move.
+  HazardDomain(const HazardDomain&) = delete;
+  HazardDomain(HazardDomain&&) noexcept = delete;
+  HazardDomain& operator=(const HazardDomain&) = delete;
+  HazardDomain& operator=(HazardDomain&&) noexcept = delete;
+  ~HazardDomain();
+
+  /**
+    Return a hazard pointer that owns one slot in this domain. Slots are
+    reused after the hazard pointer is destroyed. Creating a hazard pointer
+    scans the slots for a free one, so keep it for more than one protect()
+    where possible.
+  */
+  [[nodiscard]] HazardPointer make_hazard_pointer();
+
+  /**
+    Call deleter(ptr) once no hazard pointer protects ptr. The caller must have
+    unlinked ptr so that readers can not protect it again.
+  */
+  void retire(void* ptr, deleter_type deleter);
+
+  template <typename T>
+  void retire(T* ptr) {
+    retire(static_cast<void*>(ptr),
+           [](void* p) { delete static_cast<T*>(p); });
+  }
+
+  /**
+    Free every retired node that is not protected right now.
+  */
+  void scan();
+
+  /**
+    Approximate number of retired nodes that are not freed yet.
+  */
+  [[nodiscard]] std::size_t retired_approx() const noexcept {
+    return num_retired_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend class HazardPointer;
+
+  // One slot per cache line so that readers do not share lines.
+  struct alignas(kCacheLineSize) Slot {
+    std::atomic<const void*> ptr{};
+    std::atomic<bool> in_use{};
+    // Immutable once the slot is published.
+    Slot* next{};
+  };
+
+  struct Retired {
+    void* ptr;
+    deleter_type deleter;
+    Retired* next;
+  };
+
+  Slot& acquire_slot();
+
+  // Push the chain [first, last] on the retired stack.
+  void push_retired(Retired* first, Retired* last) noexcept;
+
+  [[nodiscard]] std::size_t scan_threshold() const noexcept {
+    return std::max(kMinScanThreshold,
+                    2 * num_slot_.load(std::memory_order_relaxed));
+  }
+
+  std::atomic<Slot*> slots_{};
+  std::atomic<std::size_t> num_slot_{};
+  alignas(kCacheLineSize) std::atomic<Retired*> retired_{};
+  std::atomic<std::size_t> num_retired_{};
+};
+
+/**
+  HazardPointer owns one hazard slot. It protects at most one pointer at a
+  time.
+*/
+class HazardPointer {
+ public:
+  explicit HazardPointer(HazardDomain& domain)
+      : slot_{domain.acquire_slot()} {}
+
+  // Rule of 5. No copy or move.
+  HazardPointer(const HazardPointer&) = delete;
+  HazardPointer(HazardPointer&&) noexcept = delete;
+  HazardPointer& operator=(const HazardPointer&) = delete;
+  HazardPointer& operator=(HazardPointer&&) noexcept = delete;
+  ~HazardPointer() {
+    slot_.ptr.store(nullptr, std::memory_order_release);
+    slot_.in_use.store(false, std::memory_order_release);
+  }
+
+  /**
+    Load src and protect the result. Return the pointer, which is safe to use
+    until the protection is reset or replaced.
+  */
+  template <typename T>
+  T* protect(const std::atomic<T*>& src) noexcept {
+    T* ptr = src.load(std::memory_order_relaxed);
+    while (!try_protect(ptr, src)) {
+    }
+
+    return ptr;
+  }
+
+  /**
+    Protect ptr, which was loaded from src. Return true if src still holds
+    ptr, in which case ptr is safe to use. Otherwise ptr is set to the new
+    value of src and the caller may try again.
+  */
+  template <typename T>
+  bool try_protect(T*& ptr, const std::atomic<T*>& src) noexcept {
+    T* expected = ptr;
+    slot_.ptr.store(expected, std::memory_order_relaxed);
+    // Publish the hazard before the validating load. Pairs with the fence in
+    // HazardDomain::scan().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    ptr = src.load(std::memory_order_acquire);
+    if (ptr != expected) {
+      slot_.ptr.store(nullptr, std::memory_order_release);
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+    Protect a pointer that is already known to be safe, e.g., one that is
+    protected by another hazard pointer.
+  */
+  template <typename T>
+  void reset_protection(const T* ptr) noexcept {
+    slot_.ptr.store(ptr, std::memory_order_release);
+  }
+
+  void reset_protection() noexcept {
+    slot_.ptr.store(nullptr, std::memory_order_release);
+  }
+
+ private:
+  HazardDomain::Slot& slot_;
+};
+
+inline HazardDomain::~HazardDomain() {
+  Retired* node = retired_.load(std::memory_order_acquire);
+  while (node != nullptr) {
+    Retired* next = node->next;
+    node->deleter(node->ptr);
+    delete node;
+    node = next;
+  }
+
+  Slot* slot = slots_.load(std::memory_order_acquire);
+  while (slot != nullptr) {
+    Slot* next = slot->next;
+    delete slot;
+    slot = next;
+  }
+}
+
+inline HazardPointer HazardDomain::make_hazard_pointer() {
+  return HazardPointer{*this};
+}
+
+inline auto HazardDomain::acquire_slot() -> Slot& {
+  for (Slot* slot = slots_.load(std::memory_order_acquire); slot != nullptr;
+       slot = slot->next) {
+    if (!slot->in_use.load(std::memory_order_relaxed) &&
+        !slot->in_use.exchange(true, std::memory_order_acquire)) {
+      return *slot;
+    }
+  }
+
+  auto* slot = new Slot{};
+  slot->in_use.store(true, std::memory_order_relaxed);
+
+  Slot* head = slots_.load(std::memory_order_relaxed);
+  do {
+    slot->next = head;
+  } while (!slots_.compare_exchange_weak(
+      head, slot, std::memory_order_release, std::memory_order_relaxed));
+
+  num_slot_.fetch_add(1, std::memory_order_relaxed);
+  return *slot;
+}
+
+inline void HazardDomain::push_retired(Retired* first,
+                                       Retired* last) noexcept {
+  Retired* head = retired_.load(std::memory_order_relaxed);
+  do {
+    last->next = head;
+  } while (!retired_.compare_exchange_weak(
+      head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+inline void HazardDomain::retire(void* ptr, deleter_type deleter) {
+  auto* node = new Retired{ptr, deleter, nullptr};
+  push_retired(node, node);
+
+  if (num_retired_.fetch_add(1, std::memory_order_relaxed) + 1 >=
+      scan_threshold()) {
+    scan();
+  }
+}
+
+inline void HazardDomain::scan() {
+  // Take every retired node. Concurrent scans get disjoint lists.
+  Retired* list = retired_.exchange(nullptr, std::memory_order_acquire);
+  if (list == nullptr) {
+    return;
+  }
+
+  // Order the unlinks of the retired nodes before the reads of the slots.
+  // Pairs with the fence in HazardPointer::try_protect().
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  std::vector<const void*> hazards;
+  hazards.reserve(num_slot_.load(std::memory_order_relaxed));
+  for (const Slot* slot = slots_.load(std::memory_order_acquire);
+       slot != nullptr; slot = slot->next) {
+    if (const void* ptr = slot->ptr.load(std::memory_order_acquire)) {
+      hazards.push_back(ptr);
+    }
+  }
+  std::sort(hazards.begin(), hazards.end());
+
+  Retired* keep_first = nullptr;
+  Retired* keep_last = nullptr;
+  std::size_t num_freed = 0;
+  while (list != nullptr) {
+    Retired* node = list;
+    list = list->next;
+
+    if (std::binary_search(hazards.begin(), hazards.end(),
+                           static_cast<const void*>(node->ptr))) {
+      node->next = keep_first;
+      keep_first = node;
+      if (keep_last == nullptr) {
+        keep_last = node;
+      }
+      continue;
+    }
+
+    node->deleter(node->ptr);
+    delete node;
+    ++num_freed;
+  }
+
+  num_retired_.fetch_sub(num_freed, std::memory_order_relaxed);
+
+  if (keep_first != nullptr) {
+    push_retired(keep_first, keep_last);
+  }
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_HAZARD_POINTER_HPP_
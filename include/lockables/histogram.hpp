@@ -0,0 +1,193 @@
+//
+// lockables/histogram.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  LatencyHistogram is a log linear histogram of durations in nanoseconds, in
+  the style of HdrHistogram. Each power of two range is split into 16 linear
+  sub-buckets, so a recorded value is off by at most 1/16 of its magnitude.
+  Use it to find tail latency that an average hides.
+
+  LatencyHistogram {
+    uint64_t counts[kNumBucket]  // 16 per power of two, up to 2^32 ns
+    uint64_t total
+  }
+
+  Usage:
+
+  LatencyHistogram histogram;
+  histogram.record(150);
+  histogram.record(2000);
+
+  uint64_t p99 = histogram.percentile(99.0);
+*/
+#ifndef LOCKABLES_HISTOGRAM_HPP_
+#define LOCKABLES_HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace lockables {
+
+namespace detail {
+
+/**
+  Index of the highest set bit. Undefined for zero.
+*/
+constexpr unsigned log2_floor64(std::uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63U - static_cast<unsigned>(
+                   __builtin_clzll(static_cast<unsigned long long>(value)));
+#else
+  unsigned result = 0;
+  while (value >>= 1) {
+    ++result;
+  }
+  return result;
+#endif
+}
+
+}  // namespace detail
+
+/**
+  LatencyHistogram counts values in [0, 2^32) nanoseconds, about 4.3
+  seconds. Larger values are counted in the last bucket.
+
+  Values below 16 have a bucket each. Above that, the bucket of a value is
+  its highest set bit and the next four bits. The percentile() method returns
+  the highest value that is in the same bucket as the value at that rank.
+
+  Not thread safe. The InstrumentedMutex keeps one per thread and merges them
+  into a LatencyHistogram on read.
+*/
+class LatencyHistogram {
+ public:
+  static constexpr unsigned kSubBucketBits = 4;
+  static constexpr unsigned kMaxBits = 32;
+  static constexpr std::uint64_t kSubBucketCount = std::uint64_t{1}
+                                                   << kSubBucketBits;
+  static constexpr std::size_t kNumBucket =
+      (kMaxBits - kSubBucketBits + 1) * kSubBucketCount;
+  static constexpr std::uint64_t kMaxValue = (std::uint64_t{1} << kMaxBits) - 1;
+
+  /**
+    Bucket of value.
+  */
+  static constexpr std::size_t bucket_index(std::uint64_t value) noexcept {
+    value = std::min(value, kMaxValue);
+    if (value < kSubBucketCount) {
+      return static_cast<std::size_t>(value);
+    }
+
+    const unsigned exponent = detail::log2_floor64(value);
+    const unsigned shift = exponent - kSubBucketBits;
+    return static_cast<std::size_t>((shift + 1) * kSubBucketCount +
+                                    ((value >> shift) - kSubBucketCount));
+  }
+
+  /**
+    Highest value in bucket.
+  */
+  static constexpr std::uint64_t bucket_upper(std::size_t index) noexcept {
+    if (index < kSubBucketCount) {
+      return index;
+    }
+
+    const auto shift = static_cast<unsigned>(index / kSubBucketCount - 1);
+    const auto sub = static_cast<std::uint64_t>(index % kSubBucketCount);
+    const std::uint64_t lower = (kSubBucketCount + sub) << shift;
+    return lower + (std::uint64_t{1} << shift) - 1;
+  }
+
+  void record(std::uint64_t value, std::uint64_t count = 1) noexcept {
+    counts_[bucket_index(value)] += count;
+    total_ += count;
+  }
+
+  /**
+    Add count values to bucket. Use to merge from another representation.
+  */
+  void add_bucket(std::size_t index, std::uint64_t count) noexcept {
+    counts_[index] += count;
+    total_ += count;
+  }
+
+  void add(const LatencyHistogram& other) noexcept {
+    for (std::size_t i = 0; i < kNumBucket; ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+  }
+
+  /**
+    Remove the values of an earlier copy of this histogram, e.g., to get the
+    values recorded in an interval. Every bucket of other must be less than or
+    equal to the same bucket here.
+  */
+  void subtract(const LatencyHistogram& other) noexcept {
+    for (std::size_t i = 0; i < kNumBucket; ++i) {
+      counts_[i] -= other.counts_[i];
+    }
+    total_ -= other.total_;
+  }
+
+  /**
+    Value at percentile in [0, 100]. Zero if empty.
+  */
+  [[nodiscard]] std::uint64_t percentile(double percent) const noexcept;
+
+  /**
+    Highest recorded value, to bucket precision. Zero if empty.
+  */
+  [[nodiscard]] std::uint64_t max() const noexcept;
+
+  [[nodiscard]] std::uint64_t count() const noexcept { return total_; }
+
+  [[nodiscard]] std::uint64_t bucket_count(std::size_t index) const noexcept {
+    return counts_[index];
+  }
+
+ private:
+  std::array<std::uint64_t, kNumBucket> counts_{};
+  std::uint64_t total_{};
+};
+
+inline std::uint64_t LatencyHistogram::percentile(
+    double percent) const noexcept {
+  if (total_ == 0) {
+    return 0;
+  }
+
+  const double clamped = std::clamp(percent, 0.0, 100.0);
+  const auto rank = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(
+             std::ceil(clamped / 100.0 * static_cast<double>(total_))));
+
+  std::uint64_t sum = 0;
+  for (std::size_t i = 0; i < kNumBucket; ++i) {
+    sum += counts_[i];
+    if (sum >= rank) {
+      return bucket_upper(i);
+    }
+  }
+
+  return max();
+}
+
+inline std::uint64_t LatencyHistogram::max() const noexcept {
+  for (std::size_t i = kNumBucket; i > 0; --i) {
+    if (counts_[i - 1] != 0) {
+      return bucket_upper(i - 1);
+    }
+  }
+
+  return 0;
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_HISTOGRAM_HPP_
@@ -0,0 +1,519 @@
+//
+// lockables/instrumented_mutex.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  InstrumentedMutex<Mutex> wraps a mutex and records lock contention
+  statistics for each instance, including wait time and hold time histograms.
+  Use it as the Mutex of a Guarded<T> to find out which values are hot. The
+  LockRegistry lists every live instrumented mutex and dumps their statistics.
+
+  InstrumentedMutex {
+    Mutex mutex
+    LockCounters {
+      uint64_t id
+      size_t slot  // index of the per thread record cache
+      Record {
+        uint64_t acquisitions, contended
+        uint64_t total_wait_ns, max_wait_ns, total_hold_ns, max_hold_ns
+        uint64_t hold_buckets[kNumBucket]
+        uint64_t* wait_buckets  // [kNumBucket], on first contended lock
+      } records  // one per thread, lock free list
+      std::string name
+    }
+  }
+
+  Usage:
+
+  // Same as Guarded<Order, std::mutex>, unless instrumentation is compiled
+  // out with LOCKABLES_DISABLE_INSTRUMENTATION. The name identifies it in the
+  // registry.
+  Guarded<Order, instrumented_mutex_t<std::mutex>> order{LockName{"order"}};
+
+  {
+    auto guard = order.with_exclusive();
+    guard->quantity = 10;
+  }
+
+  // Print the statistics of every live instrumented mutex, the most waited on
+  // first.
+  LockRegistry::instance().dump(std::cout);
+*/
+#ifndef LOCKABLES_INSTRUMENTED_MUTEX_HPP_
+#define LOCKABLES_INSTRUMENTED_MUTEX_HPP_
+
+#include <lockables/cache_line.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/histogram.hpp>
+#include <lockables/thread_records.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lockables {
+
+/**
+  Lock statistics of one mutex. Wait time is measured from the first attempt
+  to lock to the time the lock is acquired, and is zero for an acquisition
+  that was not contended. Hold time is measured from the time the lock is
+  acquired to the time it is released. Both include shared locks.
+*/
+struct LockStats {
+  std::uint64_t acquisitions{};
+  std::uint64_t contended{};
+  std::chrono::nanoseconds wait_total{};
+  std::chrono::nanoseconds wait_max{};
+  std::chrono::nanoseconds hold_total{};
+  std::chrono::nanoseconds hold_max{};
+};
+
+/**
+  Wait time and hold time histograms of one mutex, in nanoseconds. Every
+  acquisition records a wait time, zero if it was not contended.
+*/
+struct LockHistograms {
+  LatencyHistogram wait{};
+  LatencyHistogram hold{};
+};
+
+namespace detail {
+
+/**
+  Per instance counters. Each thread that uses the mutex gets its own record.
+  Only the owner thread writes to a record, with a relaxed load and store, so
+  there are no read-modify-write atomics on the hot path. Any thread may read
+  the records and merge them.
+
+  A thread finds its record with ThreadRecords<LockCounters>. Records of
+  threads that have exited are reused.
+
+  A record is about 3.8 KB, most of it the hold time histogram. The wait time
+  histogram is another 3.7 KB, allocated on the first contended acquisition
+  of the thread. An acquisition that is not contended waits zero and is
+  counted in bucket zero from the acquisitions and contended counters.
+*/
+class LockCounters {
+ public:
+  struct WaitBuckets {
+    std::atomic<std::uint64_t> counts[LatencyHistogram::kNumBucket]{};
+  };
+
+  struct alignas(kCacheLineSize) Record {
+    Record() = default;
+
+    // Rule of 5. No copy or move.
+    Record(const Record&) = delete;
+    Record(Record&&) noexcept = delete;
+    Record& operator=(const Record&) = delete;
+    Record& operator=(Record&&) noexcept = delete;
+    ~Record() { delete wait_buckets.load(std::memory_order_relaxed); }
+
+    void acquired(std::uint64_t at, std::uint64_t wait_ns,
+                  bool was_contended) noexcept {
+      hold_start = at;
+      add(acquisitions, 1);
+      if (!was_contended) {
+        return;
+      }
+
+      add(contended, 1);
+      add(total_wait_ns, wait_ns);
+      raise(max_wait_ns, wait_ns);
+
+      WaitBuckets* buckets = wait_buckets.load(std::memory_order_relaxed);
+      if (buckets == nullptr) {
+        // Drop the sample if there is no memory, the lock is already held.
+        buckets = new (std::nothrow) WaitBuckets{};
+        if (buckets == nullptr) {
+          return;
+        }
+
+        wait_buckets.store(buckets, std::memory_order_release);
+      }
+      add(buckets->counts[LatencyHistogram::bucket_index(wait_ns)], 1);
+    }
+
+    void released(std::uint64_t at) noexcept {
+      const std::uint64_t hold_ns = at - hold_start;
+      add(total_hold_ns, hold_ns);
+      raise(max_hold_ns, hold_ns);
+      add(hold_buckets[LatencyHistogram::bucket_index(hold_ns)], 1);
+    }
+
+    std::atomic<bool> in_use{};
+    // Immutable once the record is published.
+    Record* next{};
+    // Owner thread only.
+    std::uint64_t hold_start{};
+
+    std::atomic<std::uint64_t> acquisitions{};
+    std::atomic<std::uint64_t> contended{};
+    std::atomic<std::uint64_t> total_wait_ns{};
+    std::atomic<std::uint64_t> max_wait_ns{};
+    std::atomic<std::uint64_t> total_hold_ns{};
+    std::atomic<std::uint64_t> max_hold_ns{};
+    std::atomic<std::uint64_t> hold_buckets[LatencyHistogram::kNumBucket]{};
+    // Owned. Written once by the owner thread.
+    std::atomic<WaitBuckets*> wait_buckets{};
+
+   private:
+    static void add(std::atomic<std::uint64_t>& value,
+                    std::uint64_t delta) noexcept {
+      value.store(value.load(std::memory_order_relaxed) + delta,
+                  std::memory_order_relaxed);
+    }
+
+    static void raise(std::atomic<std::uint64_t>& max,
+                      std::uint64_t value) noexcept {
+      if (value > max.load(std::memory_order_relaxed)) {
+        max.store(value, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  explicit LockCounters(std::string name);
+
+  // Rule of 5. No copy or move.
+  LockCounters(const LockCounters&) = delete;
+  LockCounters(LockCounters&&) noexcept = delete;
+  LockCounters& operator=(const LockCounters&) = delete;
+  LockCounters& operator=(LockCounters&&) noexcept = delete;
+  ~LockCounters();
+
+  /**
+    The record of the calling thread.
+  */
+  Record& local() { return Records::local(id_, slot_, records_); }
+
+  [[nodiscard]] LockStats stats() const noexcept;
+
+  [[nodiscard]] LockHistograms histograms() const noexcept;
+
+  [[nodiscard]] const std::string& name() const noexcept { return name_; }
+
+  [[nodiscard]] std::uint64_t id() const noexcept { return id_; }
+
+  /**
+    Monotonic clock in nanoseconds.
+  */
+  static std::uint64_t now() noexcept {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+
+  // The per thread records, and the live counters by id for LockRegistry.
+  // Its lock is a plain std::shared_mutex, not instrumented.
+  using Records = ThreadRecords<LockCounters>;
+
+ private:
+  friend class ThreadRecords<LockCounters>;
+
+  // Thread exit. The counts stay in the record.
+  void release_record(Record& /*record*/) noexcept {}
+
+  std::uint64_t id_;
+  std::size_t slot_;
+  std::string name_;
+  RecordList<Record> records_{};
+};
+
+}  // namespace detail
+
+/**
+  LockRegistry is the process wide list of live instrumented mutexes. Every
+  InstrumentedMutex adds itself on construction and removes itself on
+  destruction.
+*/
+class LockRegistry {
+ public:
+  struct Entry {
+    std::string name;
+    // Unique for the life of the process.
+    std::uint64_t id;
+    LockStats stats;
+    LockHistograms histograms;
+  };
+
+  [[nodiscard]] static LockRegistry& instance() {
+    static LockRegistry registry{};
+    return registry;
+  }
+
+  // Rule of 5. No copy or move.
+  LockRegistry(const LockRegistry&) = delete;
+  LockRegistry(LockRegistry&&) noexcept = delete;
+  LockRegistry& operator=(const LockRegistry&) = delete;
+  LockRegistry& operator=(LockRegistry&&) noexcept = delete;
+  ~LockRegistry() = default;
+
+  /**
+    Return the statistics of every live instrumented mutex, sorted by total
+    wait time, the most waited on first.
+  */
+  [[nodiscard]] std::vector<Entry> snapshot() const;
+
+  /**
+    Write a text table of snapshot() to out, one mutex per line.
+  */
+  void dump(std::ostream& out) const;
+
+  /**
+    Number of live instrumented mutexes.
+  */
+  [[nodiscard]] std::size_t size() const {
+    return detail::LockCounters::Records::registry().with_shared()->size();
+  }
+
+ private:
+  LockRegistry() = default;
+};
+
+/**
+  InstrumentedMutex<Mutex> meets the same Lockable or SharedLockable
+  requirements as Mutex. It records the number of acquisitions, the number
+  that were contended, the total and max wait and hold times, and histograms
+  of the wait and hold times.
+
+  The lock() method tries to lock first, an acquisition that succeeds right
+  away is not contended and reads the clock once. A contended acquisition
+  reads it twice. The unlock() method reads it again to measure the hold
+  time. Used as the Mutex of a Guarded<T>, the wait time starts when the
+  GuardedScope is constructed and the hold time ends when it is destroyed.
+
+  The SharedLock trait selects the same lock type for InstrumentedMutex<Mutex>
+  as for Mutex, so Guarded<T, InstrumentedMutex<std::shared_mutex>> readers
+  take a shared lock.
+*/
+template <typename Mutex = std::mutex>
+class InstrumentedMutex {
+ public:
+  using mutex_type = Mutex;
+
+  InstrumentedMutex() : InstrumentedMutex{std::string{}} {}
+
+  /**
+    The name identifies this mutex in the LockRegistry.
+  */
+  explicit InstrumentedMutex(std::string name) : counters_{std::move(name)} {}
+
+  /**
+    Name from a Guarded<T> constructor tag.
+  */
+  explicit InstrumentedMutex(LockName name)
+      : InstrumentedMutex{std::string{name.value}} {}
+
+  // Rule of 5. No copy or move.
+  InstrumentedMutex(const InstrumentedMutex&) = delete;
+  InstrumentedMutex(InstrumentedMutex&&) noexcept = delete;
+  InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+  InstrumentedMutex& operator=(InstrumentedMutex&&) noexcept = delete;
+  ~InstrumentedMutex() = default;
+
+  void lock() {
+    auto& record = counters_.local();
+    if (mutex_.try_lock()) {
+      record.acquired(detail::LockCounters::now(), 0, false);
+      return;
+    }
+
+    const auto start = detail::LockCounters::now();
+    mutex_.lock();
+    const auto acquired = detail::LockCounters::now();
+    record.acquired(acquired, acquired - start, true);
+  }
+
+  bool try_lock() {
+    auto& record = counters_.local();
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+
+    record.acquired(detail::LockCounters::now(), 0, false);
+    return true;
+  }
+
+  void unlock() {
+    counters_.local().released(detail::LockCounters::now());
+    mutex_.unlock();
+  }
+
+  void lock_shared() {
+    auto& record = counters_.local();
+    if (mutex_.try_lock_shared()) {
+      record.acquired(detail::LockCounters::now(), 0, false);
+      return;
+    }
+
+    const auto start = detail::LockCounters::now();
+    mutex_.lock_shared();
+    const auto acquired = detail::LockCounters::now();
+    record.acquired(acquired, acquired - start, true);
+  }
+
+  bool try_lock_shared() {
+    auto& record = counters_.local();
+    if (!mutex_.try_lock_shared()) {
+      return false;
+    }
+
+    record.acquired(detail::LockCounters::now(), 0, false);
+    return true;
+  }
+
+  void unlock_shared() {
+    counters_.local().released(detail::LockCounters::now());
+    mutex_.unlock_shared();
+  }
+
+  [[nodiscard]] LockStats stats() const noexcept { return counters_.stats(); }
+
+  [[nodiscard]] LockHistograms histograms() const noexcept {
+    return counters_.histograms();
+  }
+
+  [[nodiscard]] const std::string& name() const noexcept {
+    return counters_.name();
+  }
+
+ private:
+  Mutex mutex_{};
+  detail::LockCounters counters_;
+};
+
+template <typename Mutex>
+struct SharedLock<InstrumentedMutex<Mutex>>
+    : WrappedSharedLock<InstrumentedMutex<Mutex>> {};
+
+/**
+  Opt in alias. InstrumentedMutex<Mutex> by default, or plain Mutex if
+  LOCKABLES_DISABLE_INSTRUMENTATION is defined, so that instrumentation costs
+  nothing when it is compiled out.
+*/
+#if defined(LOCKABLES_DISABLE_INSTRUMENTATION)
+template <typename Mutex>
+using instrumented_mutex_t = Mutex;
+#else
+template <typename Mutex>
+using instrumented_mutex_t = InstrumentedMutex<Mutex>;
+#endif
+
+namespace detail {
+
+inline LockCounters::LockCounters(std::string name)
+    : id_{Records::next_id()},
+      slot_{Records::acquire_slot()},
+      name_{std::move(name)} {
+  Records::registry().with_exclusive()->emplace(id_, this);
+}
+
+inline LockCounters::~LockCounters() {
+  // Waits for exiting threads that are giving back records of this mutex.
+  Records::registry().with_exclusive()->erase(id_);
+  Records::release_slot(slot_);
+}
+
+inline LockStats LockCounters::stats() const noexcept {
+  std::uint64_t wait_ns = 0;
+  std::uint64_t wait_max_ns = 0;
+  std::uint64_t hold_ns = 0;
+  std::uint64_t hold_max_ns = 0;
+
+  LockStats result{};
+  for (const Record* record = records_.head(); record != nullptr;
+       record = record->next) {
+    result.acquisitions +=
+        record->acquisitions.load(std::memory_order_relaxed);
+    result.contended += record->contended.load(std::memory_order_relaxed);
+    wait_ns += record->total_wait_ns.load(std::memory_order_relaxed);
+    wait_max_ns = std::max(
+        wait_max_ns, record->max_wait_ns.load(std::memory_order_relaxed));
+    hold_ns += record->total_hold_ns.load(std::memory_order_relaxed);
+    hold_max_ns = std::max(
+        hold_max_ns, record->max_hold_ns.load(std::memory_order_relaxed));
+  }
+
+  using std::chrono::nanoseconds;
+  result.wait_total = nanoseconds{static_cast<nanoseconds::rep>(wait_ns)};
+  result.wait_max = nanoseconds{static_cast<nanoseconds::rep>(wait_max_ns)};
+  result.hold_total = nanoseconds{static_cast<nanoseconds::rep>(hold_ns)};
+  result.hold_max = nanoseconds{static_cast<nanoseconds::rep>(hold_max_ns)};
+  return result;
+}
+
+inline LockHistograms LockCounters::histograms() const noexcept {
+  LockHistograms result{};
+  for (const Record* record = records_.head(); record != nullptr;
+       record = record->next) {
+    // Uncontended acquisitions are in bucket zero. The counters are read
+    // while the owner may update them, do not let the difference wrap.
+    const auto acquisitions =
+        record->acquisitions.load(std::memory_order_relaxed);
+    const auto contended = record->contended.load(std::memory_order_relaxed);
+    result.wait.add_bucket(
+        0, acquisitions > contended ? acquisitions - contended : 0);
+
+    const WaitBuckets* buckets =
+        record->wait_buckets.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < LatencyHistogram::kNumBucket; ++i) {
+      if (buckets != nullptr) {
+        result.wait.add_bucket(
+            i, buckets->counts[i].load(std::memory_order_relaxed));
+      }
+      result.hold.add_bucket(
+          i, record->hold_buckets[i].load(std::memory_order_relaxed));
+    }
+  }
+
+  return result;
+}
+
+}  // namespace detail
+
+inline auto LockRegistry::snapshot() const -> std::vector<Entry> {
+  std::vector<Entry> result;
+  {
+    // Hold the lock while reading, so no mutex is destroyed under us.
+    const auto guard = detail::LockCounters::Records::registry().with_shared();
+    result.reserve(guard->size());
+    for (const auto& [id, counters] : *guard) {
+      result.push_back(Entry{counters->name(), id, counters->stats(),
+                             counters->histograms()});
+    }
+  }
+
+  std::sort(result.begin(), result.end(),
+            [](const Entry& lhs, const Entry& rhs) {
+              return lhs.stats.wait_total > rhs.stats.wait_total;
+            });
+  return result;
+}
+
+inline void LockRegistry::dump(std::ostream& out) const {
+  out << "name id acquisitions contended wait_total_ns wait_max_ns "
+         "wait_p99_ns hold_total_ns hold_max_ns hold_p99_ns\n";
+  for (const auto& entry : snapshot()) {
+    const auto& stats = entry.stats;
+    out << (entry.name.empty() ? "-" : entry.name) << ' ' << entry.id << ' '
+        << stats.acquisitions << ' ' << stats.contended << ' '
+        << stats.wait_total.count() << ' ' << stats.wait_max.count() << ' '
+        << entry.histograms.wait.percentile(99.0) << ' '
+        << stats.hold_total.count() << ' ' << stats.hold_max.count() << ' '
+        << entry.histograms.hold.percentile(99.0) << '\n';
+  }
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_INSTRUMENTED_MUTEX_HPP_
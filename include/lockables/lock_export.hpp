@@ -0,0 +1,235 @@
+//
+// lockables/lock_export.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  Render the statistics of every live instrumented mutex as JSON or in the
+  Prometheus text exposition format. Write to any std::ostream, e.g., the body
+  of a /metrics response.
+
+  Usage:
+
+  Guarded<Order, InstrumentedMutex<std::mutex>> order{LockName{"order"}};
+
+  // {"locks":[{"name":"order","id":1,"acquisitions":0,...}]}
+  write_json(std::cout);
+
+  // lockables_acquisitions_total{name="order",id="1"} 0
+  write_prometheus(std::cout);
+*/
+#ifndef LOCKABLES_LOCK_EXPORT_HPP_
+#define LOCKABLES_LOCK_EXPORT_HPP_
+
+#include <lockables/histogram.hpp>
+#include <lockables/instrumented_mutex.hpp>
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace lockables {
+
+namespace detail {
+
+inline constexpr double kExportQuantiles[] = {0.5, 0.99, 0.999};
+
+// Nanoseconds as decimal seconds, without rounding.
+inline void write_seconds(std::ostream& out, std::uint64_t ns) {
+  constexpr std::uint64_t kNanoPerSecond = 1'000'000'000;
+  const std::uint64_t fraction = ns % kNanoPerSecond;
+
+  char digits[9] = {};
+  std::uint64_t rest = fraction;
+  for (int i = 8; i >= 0; --i) {
+    digits[i] = static_cast<char>('0' + rest % 10);
+    rest /= 10;
+  }
+
+  out << ns / kNanoPerSecond << '.' << std::string_view{digits, 9};
+}
+
+inline void write_json_string(std::ostream& out, std::string_view value) {
+  constexpr char kHex[] = "0123456789abcdef";
+
+  out << '"';
+  for (const char c : value) {
+    switch (c) {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      case '\n':
+        out << "\\n";
+        break;
+      case '\r':
+        out << "\\r";
+        break;
+      case '\t':
+        out << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          const auto code = static_cast<unsigned char>(c);
+          out << "\\u00" << kHex[code >> 4] << kHex[code & 0xf];
+        } else {
+          out << c;
+        }
+    }
+  }
+  out << '"';
+}
+
+inline void write_prometheus_labels(std::ostream& out,
+                                    const LockRegistry::Entry& entry) {
+  out << "{name=\"";
+  for (const char c : entry.name) {
+    switch (c) {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      case '\n':
+        out << "\\n";
+        break;
+      default:
+        out << c;
+    }
+  }
+  out << "\",id=\"" << entry.id << '"';
+}
+
+}  // namespace detail
+
+/**
+  Write one JSON object with a "locks" array, one object per live
+  instrumented mutex, most waited on first. Times are in nanoseconds.
+*/
+inline void write_json(
+    std::ostream& out,
+    const LockRegistry& registry = LockRegistry::instance()) {
+  out << "{\"locks\":[";
+  bool first = true;
+  for (const auto& entry : registry.snapshot()) {
+    const auto& stats = entry.stats;
+    const auto& wait = entry.histograms.wait;
+    const auto& hold = entry.histograms.hold;
+
+    out << (first ? "" : ",") << "{\"name\":";
+    detail::write_json_string(out, entry.name);
+    out << ",\"id\":" << entry.id << ",\"acquisitions\":" << stats.acquisitions
+        << ",\"contended\":" << stats.contended
+        << ",\"wait_total_ns\":" << stats.wait_total.count()
+        << ",\"wait_max_ns\":" << stats.wait_max.count()
+        << ",\"wait_p50_ns\":" << wait.percentile(50.0)
+        << ",\"wait_p99_ns\":" << wait.percentile(99.0)
+        << ",\"wait_p999_ns\":" << wait.percentile(99.9)
+        << ",\"hold_total_ns\":" << stats.hold_total.count()
+        << ",\"hold_max_ns\":" << stats.hold_max.count()
+        << ",\"hold_p50_ns\":" << hold.percentile(50.0)
+        << ",\"hold_p99_ns\":" << hold.percentile(99.0)
+        << ",\"hold_p999_ns\":" << hold.percentile(99.9) << '}';
+    first = false;
+  }
+  out << "]}\n";
+}
+
+/**
+  Write the Prometheus text exposition format, version 0.0.4. Every live
+  instrumented mutex is one series per metric, labeled by name and id. Times
+  are in seconds.
+
+  lockables_acquisitions_total   counter
+  lockables_contended_total      counter
+  lockables_wait_seconds         summary, quantiles 0.5, 0.99, 0.999
+  lockables_wait_max_seconds     gauge
+  lockables_hold_seconds         summary, quantiles 0.5, 0.99, 0.999
+  lockables_hold_max_seconds     gauge
+*/
+inline void write_prometheus(
+    std::ostream& out,
+    const LockRegistry& registry = LockRegistry::instance()) {
+  const auto entries = registry.snapshot();
+
+  // One line per mutex, value(entry) writes the sample.
+  const auto series = [&out, &entries](std::string_view metric,
+                                       std::string_view type,
+                                       std::string_view help, auto value) {
+    out << "# HELP " << metric << ' ' << help << '\n';
+    out << "# TYPE " << metric << ' ' << type << '\n';
+    for (const auto& entry : entries) {
+      out << metric;
+      detail::write_prometheus_labels(out, entry);
+      out << "} ";
+      value(entry);
+      out << '\n';
+    }
+  };
+
+  // Quantiles from the histogram, then the sum and count.
+  const auto summary = [&out, &entries](std::string_view metric,
+                                        std::string_view help, auto histogram,
+                                        auto total) {
+    out << "# HELP " << metric << ' ' << help << '\n';
+    out << "# TYPE " << metric << " summary\n";
+    for (const auto& entry : entries) {
+      for (const double quantile : detail::kExportQuantiles) {
+        out << metric;
+        detail::write_prometheus_labels(out, entry);
+        out << ",quantile=\"" << quantile << "\"} ";
+        detail::write_seconds(out,
+                              histogram(entry).percentile(quantile * 100.0));
+        out << '\n';
+      }
+
+      out << metric << "_sum";
+      detail::write_prometheus_labels(out, entry);
+      out << "} ";
+      detail::write_seconds(out, static_cast<std::uint64_t>(total(entry)));
+      out << '\n';
+
+      out << metric << "_count";
+      detail::write_prometheus_labels(out, entry);
+      out << "} " << histogram(entry).count() << '\n';
+    }
+  };
+
+  using Entry = LockRegistry::Entry;
+
+  series("lockables_acquisitions_total", "counter",
+         "Number of times the lock was acquired.",
+         [&out](const Entry& entry) { out << entry.stats.acquisitions; });
+  series("lockables_contended_total", "counter",
+         "Number of acquisitions that had to wait.",
+         [&out](const Entry& entry) { out << entry.stats.contended; });
+
+  summary(
+      "lockables_wait_seconds",
+      "Time from the first attempt to lock to acquired.",
+      [](const Entry& entry) -> const auto& { return entry.histograms.wait; },
+      [](const Entry& entry) { return entry.stats.wait_total.count(); });
+  series("lockables_wait_max_seconds", "gauge", "Longest wait.",
+         [&out](const Entry& entry) {
+           detail::write_seconds(
+               out, static_cast<std::uint64_t>(entry.stats.wait_max.count()));
+         });
+
+  summary(
+      "lockables_hold_seconds", "Time from acquired to released.",
+      [](const Entry& entry) -> const auto& { return entry.histograms.hold; },
+      [](const Entry& entry) { return entry.stats.hold_total.count(); });
+  series("lockables_hold_max_seconds", "gauge", "Longest hold.",
+         [&out](const Entry& entry) {
+           detail::write_seconds(
+               out, static_cast<std::uint64_t>(entry.stats.hold_max.count()));
+         });
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_LOCK_EXPORT_HPP_
@@ -0,0 +1,583 @@
+//
+// lockables/lock_order.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  CheckedMutex<Mutex> wraps a mutex and validates the lock order at run time,
+  in the style of lockdep from the Linux kernel. A blocking lock records an
+  edge from every lock the thread already holds to the new one in a process
+  wide graph. The first acquisition that closes a cycle is reported, with the
+  call stacks of both orders, before the thread blocks. A cycle means that two
+  threads can deadlock, even if they have not yet.
+
+  CheckedMutex {
+    Mutex mutex
+    LockOrderNode {
+      uint64_t id
+    }
+  }
+
+  thread_local {
+    Held {
+      uint64_t id
+      bool blocking  // lock() or try_lock()
+    } held[]         // locks held by this thread
+    edge known[]     // edges this thread has already checked
+  }
+
+  A thread only visits the graph the first time it takes a pair of locks in a
+  new order. After that a check is a lookup in a thread local set.
+
+  Usage:
+
+  // CheckedMutex<std::mutex> in debug builds, std::mutex if NDEBUG is defined.
+  Guarded<Account, checked_mutex_t<std::mutex>> from{LockName{"from"}};
+  Guarded<Account, checked_mutex_t<std::mutex>> to{LockName{"to"}};
+
+  {
+    auto guard1 = from.with_exclusive();
+    auto guard2 = to.with_exclusive();
+  }
+
+  {
+    // Reports "to" while holding "from" and "from" while holding "to", with
+    // both call stacks.
+    auto guard2 = to.with_exclusive();
+    auto guard1 = from.with_exclusive();
+  }
+*/
+#ifndef LOCKABLES_LOCK_ORDER_HPP_
+#define LOCKABLES_LOCK_ORDER_HPP_
+
+#include <lockables/guarded.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define LOCKABLES_HAS_EXECINFO 1
+#endif
+#endif
+
+namespace lockables {
+
+/**
+  One lock order, the "to" lock was acquired while holding the "from" lock.
+*/
+struct LockOrderEdge {
+  std::string from;
+  std::string to;
+  // Call stack of the first acquisition in this order, innermost frame first.
+  // Empty if the platform has no backtrace().
+  std::vector<void*> frames;
+};
+
+/**
+  A cycle in the lock order graph. The first edge is the acquisition that
+  closes the cycle. The rest is the order that was recorded earlier, from the
+  "to" lock of the first edge back to its "from" lock.
+*/
+struct LockOrderViolation {
+  std::vector<LockOrderEdge> cycle;
+};
+
+/**
+  Write a violation as text, with symbolized call stacks if available.
+*/
+inline void write_violation(std::ostream& out,
+                            const LockOrderViolation& violation);
+
+namespace detail {
+
+class LockOrderNode;
+
+}  // namespace detail
+
+/**
+  LockOrderGraph is the process wide graph of lock orders. Every CheckedMutex
+  is a node. An edge from A to B means that some thread acquired B while
+  holding A.
+*/
+class LockOrderGraph {
+ public:
+  using Reporter = std::function<void(const LockOrderViolation&)>;
+
+  [[nodiscard]] static LockOrderGraph& instance() {
+    static LockOrderGraph graph{};
+    return graph;
+  }
+
+  // Rule of 5. No copy or move.
+  LockOrderGraph(const LockOrderGraph&) = delete;
+  LockOrderGraph(LockOrderGraph&&) noexcept = delete;
+  LockOrderGraph& operator=(const LockOrderGraph&) = delete;
+  LockOrderGraph& operator=(LockOrderGraph&&) noexcept = delete;
+  ~LockOrderGraph() = default;
+
+  /**
+    Set the function that is called once for each new violation and return
+    the previous one. The default writes to std::cerr.
+
+    The reporter runs on the thread that is about to lock, before it blocks.
+    It may throw to fail fast, the lock is not acquired.
+  */
+  Reporter set_reporter(Reporter reporter) {
+    auto state = state_.with_exclusive();
+    std::swap(state->reporter, reporter);
+    return reporter;
+  }
+
+  /**
+    Number of lock orders recorded.
+  */
+  [[nodiscard]] std::size_t size() const {
+    const auto state = state_.with_shared();
+    std::size_t result = 0;
+    for (const auto& [id, node] : state->nodes) {
+      result += node.edges.size();
+    }
+    return result;
+  }
+
+ private:
+  friend class detail::LockOrderNode;
+
+  using Frames = std::vector<void*>;
+
+  struct Node {
+    std::string name;
+    // Locks acquired while holding this one.
+    std::unordered_map<std::uint64_t, Frames> edges;
+  };
+
+  struct State {
+    std::unordered_map<std::uint64_t, Node> nodes;
+    std::set<std::pair<std::uint64_t, std::uint64_t>> reported;
+    Reporter reporter;
+  };
+
+  LockOrderGraph() {
+    state_.with_exclusive()->reporter =
+        [](const LockOrderViolation& violation) {
+          write_violation(std::cerr, violation);
+        };
+  }
+
+  static Frames capture_frames() {
+    Frames frames;
+#if defined(LOCKABLES_HAS_EXECINFO)
+    constexpr int kMaxFrames = 32;
+    frames.resize(kMaxFrames);
+    const int size = ::backtrace(frames.data(), kMaxFrames);
+    frames.resize(static_cast<std::size_t>(std::max(size, 0)));
+#endif
+    return frames;
+  }
+
+  // Ids on the shortest path from begin to end, or empty if there is none.
+  static std::vector<std::uint64_t> find_path(
+      const std::unordered_map<std::uint64_t, Node>& nodes,
+      std::uint64_t begin, std::uint64_t end);
+
+  void add_node(std::uint64_t id, std::string name);
+
+  void remove_node(std::uint64_t id);
+
+  // Record that to was acquired while holding from. Calls the reporter if
+  // the order closes a cycle that has not been reported.
+  void add_edge(std::uint64_t from, std::uint64_t to);
+
+  // Must not be checked itself.
+  Guarded<State, std::shared_mutex> state_{};
+};
+
+namespace detail {
+
+/**
+  Per instance node in the LockOrderGraph, and the thread local list of held
+  locks.
+*/
+class LockOrderNode {
+ public:
+  explicit LockOrderNode(std::string name) : id_{next_id()} {
+    LockOrderGraph::instance().add_node(id_, std::move(name));
+  }
+
+  // Rule of 5. No copy or move.
+  LockOrderNode(const LockOrderNode&) = delete;
+  LockOrderNode(LockOrderNode&&) noexcept = delete;
+  LockOrderNode& operator=(const LockOrderNode&) = delete;
+  LockOrderNode& operator=(LockOrderNode&&) noexcept = delete;
+  ~LockOrderNode() { LockOrderGraph::instance().remove_node(id_); }
+
+  /**
+    Before a blocking lock. Record an edge from every held lock to this one.
+  */
+  void check() {
+    auto& local = local_state();
+    for (const Held& held : local.held) {
+      add_edge(local, held.id);
+    }
+  }
+
+  /**
+    After this thread acquired the lock with a blocking lock.
+  */
+  void acquired() { local_state().held.push_back(Held{id_, true}); }
+
+  /**
+    After this thread acquired the lock with a try lock. Record an edge from
+    the held locks that were taken before the last blocking lock.
+
+    The deadlock avoidance of std::lock blocks on one lock and tries the
+    others. If a try fails, it releases its locks and blocks on that one, but
+    still holds the locks from before the call. Those are ordered before every
+    lock in the call. The locks taken in the call are not ordered among
+    themselves.
+  */
+  void try_acquired() {
+    auto& local = local_state();
+    auto& held = local.held;
+
+    // Index of the last blocking lock, or zero if there is none.
+    std::size_t end = held.size();
+    while (end > 0 && !held[end - 1].blocking) {
+      --end;
+    }
+    end = end > 0 ? end - 1 : 0;
+
+    for (std::size_t i = 0; i < end; ++i) {
+      add_edge(local, held[i].id);
+    }
+
+    held.push_back(Held{id_, false});
+  }
+
+  /**
+    Before this thread releases the lock. Locks may be released in any order.
+  */
+  void released() noexcept {
+    auto& held = local_state().held;
+    const auto itr =
+        std::find_if(held.rbegin(), held.rend(),
+                     [this](const Held& entry) { return entry.id == id_; });
+    if (itr != held.rend()) {
+      held.erase(std::next(itr).base());
+    }
+  }
+
+ private:
+  using Edge = std::pair<std::uint64_t, std::uint64_t>;
+
+  struct EdgeHash {
+    std::size_t operator()(const Edge& edge) const noexcept {
+      return std::hash<std::uint64_t>{}(edge.first * 0x9E3779B97F4A7C15ULL ^
+                                        edge.second);
+    }
+  };
+
+  struct Held {
+    std::uint64_t id;
+    bool blocking;
+  };
+
+  struct LocalState {
+    std::vector<Held> held{};
+    // Ids are never reused, so the edges of destroyed locks are harmless.
+    std::unordered_set<Edge, EdgeHash> known{};
+  };
+
+  static LocalState& local_state() {
+    static thread_local LocalState state{};
+    return state;
+  }
+
+  static std::uint64_t next_id() noexcept {
+    static std::atomic<std::uint64_t> id{};
+    return id.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  // Record that this lock is acquired while holding held, once per thread.
+  void add_edge(LocalState& local, std::uint64_t held) {
+    // Taking the same lock again is not an order.
+    if (held == id_) {
+      return;
+    }
+
+    const Edge edge{held, id_};
+    if (local.known.find(edge) != local.known.end()) {
+      return;
+    }
+
+    LockOrderGraph::instance().add_edge(held, id_);
+    local.known.insert(edge);
+  }
+
+  std::uint64_t id_;
+};
+
+}  // namespace detail
+
+/**
+  CheckedMutex<Mutex> meets the same Lockable or SharedLockable requirements
+  as Mutex. The lock() and lock_shared() methods check the lock order before
+  they block. The try_lock() methods cannot deadlock and a failed try is not
+  checked. A successful try orders the lock after the locks that were held
+  before the last blocking lock, but not after that one. So the deadlock
+  avoidance of std::scoped_lock in the free with_exclusive function does not
+  report false cycles between its own locks, and the locks held around the
+  call are still ordered before all of them. A lock acquired with try_lock()
+  is held, later blocking locks are ordered after it.
+
+  Shared and exclusive locks are ordered the same way. Two readers that lock
+  in opposite orders can deadlock with a writer that is waiting.
+*/
+template <typename Mutex = std::mutex>
+class CheckedMutex {
+ public:
+  using mutex_type = Mutex;
+
+  CheckedMutex() : CheckedMutex{std::string{}} {}
+
+  /**
+    The name identifies this mutex in violation reports.
+  */
+  explicit CheckedMutex(std::string name) : node_{std::move(name)} {}
+
+  /**
+    Name from a Guarded<T> constructor tag, also passed on to Mutex.
+  */
+  explicit CheckedMutex(LockName name)
+      : mutex_{detail::make_mutex<Mutex>(name)}, node_{name.value} {}
+
+  // Rule of 5. No copy or move.
+  CheckedMutex(const CheckedMutex&) = delete;
+  CheckedMutex(CheckedMutex&&) noexcept = delete;
+  CheckedMutex& operator=(const CheckedMutex&) = delete;
+  CheckedMutex& operator=(CheckedMutex&&) noexcept = delete;
+  ~CheckedMutex() = default;
+
+  void lock() {
+    node_.check();
+    mutex_.lock();
+    node_.acquired();
+  }
+
+  bool try_lock() {
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+
+    try {
+      node_.try_acquired();
+    } catch (...) {
+      // The reporter threw, do not keep the lock.
+      mutex_.unlock();
+      throw;
+    }
+
+    return true;
+  }
+
+  void unlock() {
+    node_.released();
+    mutex_.unlock();
+  }
+
+  void lock_shared() {
+    node_.check();
+    mutex_.lock_shared();
+    node_.acquired();
+  }
+
+  bool try_lock_shared() {
+    if (!mutex_.try_lock_shared()) {
+      return false;
+    }
+
+    try {
+      node_.try_acquired();
+    } catch (...) {
+      // The reporter threw, do not keep the lock.
+      mutex_.unlock_shared();
+      throw;
+    }
+
+    return true;
+  }
+
+  void unlock_shared() {
+    node_.released();
+    mutex_.unlock_shared();
+  }
+
+ private:
+  Mutex mutex_{};
+  detail::LockOrderNode node_;
+};
+
+template <typename Mutex>
+struct SharedLock<CheckedMutex<Mutex>>
+    : WrappedSharedLock<CheckedMutex<Mutex>> {};
+
+/**
+  Opt in alias. CheckedMutex<Mutex> in debug builds, or plain Mutex if NDEBUG
+  is defined. Define LOCKABLES_CHECK_LOCK_ORDER to keep the checks in a
+  release build, e.g., for load tests.
+*/
+#if defined(NDEBUG) && !defined(LOCKABLES_CHECK_LOCK_ORDER)
+template <typename Mutex>
+using checked_mutex_t = Mutex;
+#else
+template <typename Mutex>
+using checked_mutex_t = CheckedMutex<Mutex>;
+#endif
+
+inline void write_violation(std::ostream& out,
+                            const LockOrderViolation& violation) {
+  out << "lockables: lock order inversion, possible deadlock\n";
+  for (std::size_t i = 0; i < violation.cycle.size(); ++i) {
+    const auto& edge = violation.cycle[i];
+    out << (i == 0 ? "acquiring \"" : "after earlier acquiring \"") << edge.to
+        << "\" while holding \"" << edge.from << "\"\n";
+
+#if defined(LOCKABLES_HAS_EXECINFO)
+    const int size = static_cast<int>(edge.frames.size());
+    char** symbols = ::backtrace_symbols(edge.frames.data(), size);
+    for (int j = 0; j < size; ++j) {
+      out << "  #" << j << ' ';
+      if (symbols != nullptr) {
+        out << symbols[j];
+      } else {
+        out << edge.frames[static_cast<std::size_t>(j)];
+      }
+      out << '\n';
+    }
+    std::free(symbols);
+#endif
+  }
+}
+
+inline auto LockOrderGraph::find_path(
+    const std::unordered_map<std::uint64_t, Node>& nodes, std::uint64_t begin,
+    std::uint64_t end) -> std::vector<std::uint64_t> {
+  // Breadth first, parent of each visited node.
+  std::unordered_map<std::uint64_t, std::uint64_t> parent{{begin, begin}};
+  std::queue<std::uint64_t> pending{};
+  pending.push(begin);
+  while (!pending.empty()) {
+    const std::uint64_t id = pending.front();
+    pending.pop();
+    if (id == end) {
+      std::vector<std::uint64_t> path{end};
+      while (path.back() != begin) {
+        path.push_back(parent[path.back()]);
+      }
+      std::reverse(path.begin(), path.end());
+      return path;
+    }
+
+    const auto node = nodes.find(id);
+    if (node == nodes.end()) {
+      continue;
+    }
+
+    for (const auto& [next, frames] : node->second.edges) {
+      if (parent.emplace(next, id).second) {
+        pending.push(next);
+      }
+    }
+  }
+
+  return {};
+}
+
+inline void LockOrderGraph::add_node(std::uint64_t id, std::string name) {
+  if (name.empty()) {
+    name = "#" + std::to_string(id);
+  }
+
+  state_.with_exclusive()->nodes.emplace(id, Node{std::move(name), {}});
+}
+
+inline void LockOrderGraph::remove_node(std::uint64_t id) {
+  auto state = state_.with_exclusive();
+  state->nodes.erase(id);
+  for (auto& [other, node] : state->nodes) {
+    node.edges.erase(id);
+  }
+}
+
+inline void LockOrderGraph::add_edge(std::uint64_t from, std::uint64_t to) {
+  {
+    const auto state = state_.with_shared();
+    const auto node = state->nodes.find(from);
+    if (node == state->nodes.end() ||
+        node->second.edges.find(to) != node->second.edges.end()) {
+      return;
+    }
+  }
+
+  Frames frames = capture_frames();
+
+  LockOrderViolation violation{};
+  Reporter reporter{};
+  {
+    auto state = state_.with_exclusive();
+    auto& nodes = state->nodes;
+    const auto from_node = nodes.find(from);
+    const auto to_node = nodes.find(to);
+    if (from_node == nodes.end() || to_node == nodes.end() ||
+        from_node->second.edges.find(to) != from_node->second.edges.end() ||
+        state->reported.find({from, to}) != state->reported.end()) {
+      return;
+    }
+
+    const auto path = find_path(nodes, to, from);
+    if (path.empty()) {
+      from_node->second.edges.emplace(to, std::move(frames));
+      return;
+    }
+
+    // Leave the graph acyclic, report this order once.
+    state->reported.emplace(from, to);
+
+    violation.cycle.push_back(
+        {from_node->second.name, to_node->second.name, std::move(frames)});
+    for (std::size_t i = 0; i + 1 < path.size(); ++i) {
+      const Node& node = nodes.at(path[i]);
+      violation.cycle.push_back({node.name, nodes.at(path[i + 1]).name,
+                                 node.edges.at(path[i + 1])});
+    }
+
+    reporter = state->reporter;
+  }
+
+  // Call the reporter without the lock, it may take other locks or throw.
+  if (reporter) {
+    reporter(violation);
+  }
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_LOCK_ORDER_HPP_
@@ -0,0 +1,226 @@
+//
+// lockables/lock_table.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  LockTable<Mutex, N> is a fixed table of N mutexes for objects that can not
+  be wrapped in a Guarded<T>. A key hashes to one stripe, and the stripe's
+  mutex guards every object with a key that maps to it.
+
+  LockTable {
+    Stripe {
+      Mutex mutex
+    } stripes[N]  // one per cache line
+  }
+
+  Usage:
+
+  LockTable<std::shared_mutex> locks;
+  Record* records = map_arena();
+
+  // Writer. Exclusive lock on the stripe of key 7.
+  locks.with_exclusive(7, [&]() { records[7].count += 1; });
+
+  // Reader. Shared lock on the stripe of key 7.
+  int count = locks.with_shared(7, [&]() { return records[7].count; });
+
+  // Writer. Lock the stripes of both keys without deadlock.
+  locks.with_exclusive_all(std::array{7, 12}, [&]() {
+    std::swap(records[7], records[12]);
+  });
+*/
+#ifndef LOCKABLES_LOCK_TABLE_HPP_
+#define LOCKABLES_LOCK_TABLE_HPP_
+
+#include <lockables/cache_line.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/hash.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lockables {
+
+/**
+  LockTable<Mutex, N> maps keys to N stripes with std::hash and Fibonacci
+  hashing. N must be a power of two. More stripes means fewer unrelated keys
+  that share a mutex, at the cost of memory, one cache line per stripe.
+
+  The with_exclusive and with_shared methods lock one stripe and call the
+  user supplied callback. They select the lock type the same way as
+  GuardedScope<T>, readers use shared_lock_t<Mutex> from the SharedLock trait.
+
+  The with_exclusive_all and with_shared_all methods lock the stripes of a
+  range of keys. Stripes are sorted and deduplicated before they are locked,
+  so two keys that share a stripe lock it once, and every caller locks in the
+  same order which avoids deadlock.
+*/
+template <typename Mutex = std::mutex, std::size_t N = 64>
+class LockTable {
+ public:
+  using mutex_type = Mutex;
+
+  static constexpr std::size_t kNumStripe = N;
+
+  static_assert(N > 0 && (N & (N - 1)) == 0,
+                "LockTable requires a power of two number of stripes");
+
+  LockTable() = default;
+
+  // Rule of 5. No copy or move.
+  LockTable(const LockTable&) = delete;
+  LockTable(LockTable&&) noexcept = delete;
+  LockTable& operator=(const LockTable&) = delete;
+  LockTable& operator=(LockTable&&) noexcept = delete;
+  ~LockTable() = default;
+
+  /**
+    Call f() with an exclusive lock on the stripe of key.
+  */
+  template <typename Key, typename F>
+  std::invoke_result_t<F> with_exclusive(const Key& key, F&& f) {
+    std::scoped_lock<Mutex> lock{stripes_[stripe_index(key)].mutex};
+    return std::invoke(std::forward<F>(f));
+  }
+
+  /**
+    Call f() with a shared lock on the stripe of key.
+  */
+  template <typename Key, typename F>
+  std::invoke_result_t<F> with_shared(const Key& key, F&& f) const {
+    shared_lock_t<Mutex> lock{stripes_[stripe_index(key)].mutex};
+    return std::invoke(std::forward<F>(f));
+  }
+
+  /**
+    Call f() with an exclusive lock on the stripes of all of the keys.
+  */
+  template <typename Range, typename F>
+  std::invoke_result_t<F> with_exclusive_all(const Range& keys, F&& f) {
+    const MultiLock<false> lock{*this, keys};
+    return std::invoke(std::forward<F>(f));
+  }
+
+  /**
+    Call f() with a shared lock on the stripes of all of the keys.
+  */
+  template <typename Range, typename F>
+  std::invoke_result_t<F> with_shared_all(const Range& keys, F&& f) const {
+    const MultiLock<kHasSharedLock> lock{*this, keys};
+    return std::invoke(std::forward<F>(f));
+  }
+
+  /**
+    Index of the stripe that guards key.
+  */
+  template <typename Key>
+  [[nodiscard]] static std::size_t stripe_index(const Key& key) noexcept {
+    if constexpr (N == 1) {
+      return 0;
+    } else {
+      return detail::fibonacci_hash(
+          static_cast<std::uint64_t>(std::hash<Key>{}(key)), kShift);
+    }
+  }
+
+ private:
+  struct alignas(kCacheLineSize) Stripe {
+    mutable Mutex mutex{};
+  };
+
+  static constexpr unsigned log2(std::size_t value) noexcept {
+    unsigned result = 0;
+    while (value >>= 1) {
+      ++result;
+    }
+    return result;
+  }
+
+  static constexpr unsigned kShift = 64 - log2(N);
+
+  // True if shared_lock_t<Mutex> takes a shared lock, false if readers use
+  // the exclusive lock.
+  static constexpr bool kHasSharedLock =
+      !std::is_same_v<shared_lock_t<Mutex>, std::scoped_lock<Mutex>>;
+
+  /**
+    Lock the stripes of a range of keys in index order. Unlock in reverse
+    order on destruction, or if one of the locks throws.
+  */
+  template <bool Shared>
+  class MultiLock {
+   public:
+    template <typename Range>
+    MultiLock(const LockTable& table, const Range& keys) : table_{table} {
+      using std::begin;
+      using std::end;
+      for (auto itr = begin(keys); itr != end(keys); ++itr) {
+        indices_.push_back(stripe_index(*itr));
+      }
+
+      std::sort(indices_.begin(), indices_.end());
+      indices_.erase(std::unique(indices_.begin(), indices_.end()),
+                     indices_.end());
+
+      for (; num_locked_ < indices_.size(); ++num_locked_) {
+        try {
+          lock(table_.stripes_[indices_[num_locked_]].mutex);
+        } catch (...) {
+          unlock_all();
+          throw;
+        }
+      }
+    }
+
+    // Rule of 5. No copy or move.
+    MultiLock(const MultiLock&) = delete;
+    MultiLock(MultiLock&&) noexcept = delete;
+    MultiLock& operator=(const MultiLock&) = delete;
+    MultiLock& operator=(MultiLock&&) noexcept = delete;
+    ~MultiLock() { unlock_all(); }
+
+   private:
+    static void lock(Mutex& mutex) {
+      if constexpr (Shared) {
+        mutex.lock_shared();
+      } else {
+        mutex.lock();
+      }
+    }
+
+    static void unlock(Mutex& mutex) {
+      if constexpr (Shared) {
+        mutex.unlock_shared();
+      } else {
+        mutex.unlock();
+      }
+    }
+
+    void unlock_all() noexcept {
+      while (num_locked_ > 0) {
+        --num_locked_;
+        unlock(table_.stripes_[indices_[num_locked_]].mutex);
+      }
+    }
+
+    const LockTable& table_;
+    std::vector<std::size_t> indices_{};
+    std::size_t num_locked_{};
+  };
+
+  std::array<Stripe, N> stripes_{};
+};
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_LOCK_TABLE_HPP_
@@ -0,0 +1,106 @@
+//
+// lockables/lock_violation.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  The fail fast path of the checked mutex wrappers. OwnedMutex and RankedMutex
+  call one process wide handler when a thread is about to lock in a way that
+  can deadlock. The default handler throws std::system_error with
+  std::errc::resource_deadlock_would_occur.
+
+  Usage:
+
+  [[noreturn]] void log_and_abort(const LockViolation& violation) {
+    std::cerr << "lock violation " << violation.name << "\n";
+    std::abort();
+  }
+
+  set_lock_violation_handler(&log_and_abort);
+*/
+#ifndef LOCKABLES_LOCK_VIOLATION_HPP_
+#define LOCKABLES_LOCK_VIOLATION_HPP_
+
+#include <atomic>
+#include <string>
+#include <system_error>
+
+namespace lockables {
+
+/**
+  A thread tried to lock a mutex in a way that can deadlock.
+*/
+struct LockViolation {
+  enum class Kind {
+    // lock() or try_lock() while holding the exclusive lock.
+    kRecursiveExclusive,
+    // lock_shared() or try_lock_shared() while holding the exclusive lock.
+    kSharedWhileExclusive,
+    // Lock of a rank that is lower than or equal to a rank that is held.
+    kRankOrder,
+  };
+
+  Kind kind;
+  // Address of the mutex wrapper.
+  const void* mutex;
+  // From the LockName, or empty.
+  const char* name;
+};
+
+/**
+  Called on the thread that is about to lock, before it would deadlock. If
+  the handler returns, the lock call continues.
+*/
+using LockViolationHandler = void (*)(const LockViolation&);
+
+/**
+  The default handler. Throws std::system_error with
+  std::errc::resource_deadlock_would_occur, the same error that a std::mutex
+  may report for a recursive lock.
+*/
+[[noreturn]] inline void throw_lock_violation(const LockViolation& violation) {
+  std::string what;
+  switch (violation.kind) {
+    case LockViolation::Kind::kRecursiveExclusive:
+      what = "lockables: recursive lock of mutex";
+      break;
+    case LockViolation::Kind::kSharedWhileExclusive:
+      what = "lockables: shared lock while holding exclusive lock of mutex";
+      break;
+    case LockViolation::Kind::kRankOrder:
+      what = "lockables: lock rank order violation, mutex";
+      break;
+  }
+
+  if (violation.name != nullptr && *violation.name != '\0') {
+    what.append(" \"").append(violation.name).append("\"");
+  }
+
+  throw std::system_error{
+      std::make_error_code(std::errc::resource_deadlock_would_occur), what};
+}
+
+namespace detail {
+
+inline std::atomic<LockViolationHandler> lock_violation_handler{
+    &throw_lock_violation};
+
+inline void report_lock_violation(const LockViolation& violation) {
+  lock_violation_handler.load(std::memory_order_relaxed)(violation);
+}
+
+}  // namespace detail
+
+/**
+  Set the handler for all checked mutexes, e.g., to log and abort. Return the
+  previous one. A null handler restores the default.
+*/
+inline LockViolationHandler set_lock_violation_handler(
+    LockViolationHandler handler) noexcept {
+  return detail::lock_violation_handler.exchange(
+      handler != nullptr ? handler : &throw_lock_violation);
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_LOCK_VIOLATION_HPP_
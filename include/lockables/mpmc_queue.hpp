@@ -0,0 +1,417 @@
+//
+// lockables/mpmc_queue.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  MpmcQueue<T> is a bounded, multiple producer, multiple consumer queue. The
+  non-blocking operations are lock free. The blocking operations park the
+  thread on a condition variable when the queue is full or empty.
+
+  MpmcQueue {
+    Cell {
+      std::atomic<size_t> sequence
+      T value
+    } cells[capacity]
+    std::atomic<size_t> enqueue_pos
+    std::atomic<size_t> dequeue_pos
+  }
+
+  Usage:
+
+  MpmcQueue<int> queue{1024};
+
+  // Producer.
+  if (!queue.try_push(1)) {
+    // Full.
+  }
+  queue.push(2);  // Blocks while full.
+
+  // Consumer.
+  int value = 0;
+  if (queue.try_pop(value)) {
+    assert(value == 1);
+  }
+  value = queue.pop();  // Blocks while empty.
+
+  References:
+
+  Dmitry Vyukov, Bounded MPMC queue
+  https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+*/
+#ifndef LOCKABLES_MPMC_QUEUE_HPP_
+#define LOCKABLES_MPMC_QUEUE_HPP_
+
+#include <lockables/cache_line.hpp>
+#include <lockables/parking.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace lockables {
+
+/**
+  MpmcQueue<T> is a bounded queue of T with a capacity that is a power of two.
+  Each cell has a sequence number that tells producers and consumers whose
+  turn it is, so the only shared write per operation is one compare and swap
+  on the enqueue or dequeue position.
+
+  Elements are constructed in place when pushed and destroyed when popped. A
+  constructor that may throw runs before the position is claimed, on a local
+  copy that is then moved into the cell. Once a position is claimed nothing
+  may throw, or the cell would never be handed on, so T must have a non-throwing
+  move constructor, move assignment, and destructor.
+*/
+template <typename T>
+class MpmcQueue {
+  static_assert(std::is_nothrow_move_constructible_v<T>,
+                "MpmcQueue<T> requires a noexcept move constructor");
+  static_assert(std::is_nothrow_move_assignable_v<T>,
+                "MpmcQueue<T> requires a noexcept move assignment");
+  static_assert(std::is_nothrow_destructible_v<T>,
+                "MpmcQueue<T> requires a noexcept destructor");
+
+ public:
+  using value_type = T;
+
+  /**
+    Construct an empty queue with room for at least capacity elements.
+  */
+  explicit MpmcQueue(std::size_t capacity);
+
+  // Rule of 5. No copy or move.
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue(MpmcQueue&&) noexcept = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(MpmcQueue&&) noexcept = delete;
+  ~MpmcQueue();
+
+  /**
+    Construct an element at the back of the queue. Return false if full.
+  */
+  template <typename... Args>
+  bool try_emplace(Args&&... args);
+
+  bool try_push(const T& value) { return try_emplace(value); }
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  /**
+    Move the element at the front of the queue into value. Return false if
+    empty.
+  */
+  bool try_pop(T& value);
+
+  /**
+    Push, blocking while the queue is full.
+  */
+  void push(const T& value);
+  void push(T&& value);
+
+  /**
+    Pop, blocking while the queue is empty.
+  */
+  void pop(T& value);
+  [[nodiscard]] T pop();
+
+  /**
+    Push up to count elements from first. Return the number pushed. Wakes
+    blocked consumers once for the whole batch.
+  */
+  template <typename InputIt>
+  std::size_t try_push_n(InputIt first, std::size_t count);
+
+  /**
+    Pop up to count elements into out. Return the number popped. Wakes blocked
+    producers once for the whole batch.
+  */
+  template <typename OutputIt>
+  std::size_t try_pop_n(OutputIt out, std::size_t count);
+
+  /**
+    Push all count elements from first, blocking while the queue is full.
+  */
+  template <typename InputIt>
+  void push_n(InputIt first, std::size_t count);
+
+  /**
+    Block until at least one element is available, then pop up to count
+    elements into out. Return the number popped.
+  */
+  template <typename OutputIt>
+  std::size_t pop_n(OutputIt out, std::size_t count);
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask_ + 1; }
+
+  /**
+    Approximate number of elements. May be stale if there are concurrent
+    producers or consumers.
+  */
+  [[nodiscard]] std::size_t size_approx() const noexcept;
+
+ private:
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T* value() noexcept {
+      return std::launder(reinterpret_cast<T*>(storage));
+    }
+  };
+
+  template <typename... Args>
+  bool try_emplace_no_notify(Args&&... args);
+
+  // Claim the next position and construct the element in it. Must not throw.
+  template <typename... Args>
+  bool try_claim_emplace(Args&&... args) noexcept;
+
+  bool try_pop_no_notify(T& value);
+
+  [[nodiscard]] bool empty_approx() const noexcept {
+    return size_approx() == 0;
+  }
+
+  [[nodiscard]] bool full_approx() const noexcept {
+    return size_approx() >= capacity();
+  }
+
+  std::size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+
+  // Producers and consumers write different positions. Keep each on its own
+  // cache line.
+  alignas(kCacheLineSize) std::atomic<std::size_t> enqueue_pos_{};
+  alignas(kCacheLineSize) std::atomic<std::size_t> dequeue_pos_{};
+
+  alignas(kCacheLineSize) detail::Parking not_empty_{};
+  alignas(kCacheLineSize) detail::Parking not_full_{};
+};
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue(std::size_t capacity) : mask_{0} {
+  std::size_t size = 1;
+  while (size < capacity) {
+    size *= 2;
+  }
+
+  mask_ = size - 1;
+  cells_ = std::make_unique<Cell[]>(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+MpmcQueue<T>::~MpmcQueue() {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    const auto first = dequeue_pos_.load(std::memory_order_relaxed);
+    const auto last = enqueue_pos_.load(std::memory_order_relaxed);
+    for (auto pos = first; pos != last; ++pos) {
+      std::destroy_at(cells_[pos & mask_].value());
+    }
+  }
+}
+
+template <typename T>
+template <typename... Args>
+bool MpmcQueue<T>::try_emplace_no_notify(Args&&... args) {
+  if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+    return try_claim_emplace(std::forward<Args>(args)...);
+  } else {
+    // Construct before the claim. If the constructor throws, the queue is
+    // untouched.
+    T value(std::forward<Args>(args)...);
+    return try_claim_emplace(std::move(value));
+  }
+}
+
+template <typename T>
+template <typename... Args>
+bool MpmcQueue<T>::try_claim_emplace(Args&&... args) noexcept {
+  static_assert(std::is_nothrow_constructible_v<T, Args&&...>);
+
+  auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell& cell = cells_[pos & mask_];
+    const auto sequence = cell.sequence.load(std::memory_order_acquire);
+    const auto diff =
+        static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+    if (diff == 0) {
+      // Cell is free for this position. Claim it.
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        ::new (static_cast<void*>(cell.storage))
+            T(std::forward<Args>(args)...);
+        cell.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // Cell still holds the element from one lap ago. Full.
+      return false;
+    } else {
+      // Another producer claimed this position.
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+bool MpmcQueue<T>::try_pop_no_notify(T& value) {
+  auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell& cell = cells_[pos & mask_];
+    const auto sequence = cell.sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<std::intptr_t>(sequence) -
+                      static_cast<std::intptr_t>(pos + 1);
+    if (diff == 0) {
+      // Cell holds the element for this position. Claim it.
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        T* ptr = cell.value();
+        value = std::move(*ptr);
+        std::destroy_at(ptr);
+        // Free the cell for the producer one lap ahead.
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // Empty.
+      return false;
+    } else {
+      // Another consumer claimed this position.
+      pos = dequeue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+template <typename... Args>
+bool MpmcQueue<T>::try_emplace(Args&&... args) {
+  if (!try_emplace_no_notify(std::forward<Args>(args)...)) {
+    return false;
+  }
+
+  not_empty_.notify_one();
+  return true;
+}
+
+template <typename T>
+bool MpmcQueue<T>::try_pop(T& value) {
+  if (!try_pop_no_notify(value)) {
+    return false;
+  }
+
+  not_full_.notify_one();
+  return true;
+}
+
+template <typename T>
+void MpmcQueue<T>::push(const T& value) {
+  while (!try_emplace(value)) {
+    not_full_.wait([this]() { return !full_approx(); });
+  }
+}
+
+template <typename T>
+void MpmcQueue<T>::push(T&& value) {
+  // The element is only moved from if the push succeeds.
+  while (!try_emplace(std::move(value))) {
+    not_full_.wait([this]() { return !full_approx(); });
+  }
+}
+
+template <typename T>
+void MpmcQueue<T>::pop(T& value) {
+  while (!try_pop(value)) {
+    not_empty_.wait([this]() { return !empty_approx(); });
+  }
+}
+
+template <typename T>
+T MpmcQueue<T>::pop() {
+  T value{};
+  pop(value);
+  return value;
+}
+
+template <typename T>
+template <typename InputIt>
+std::size_t MpmcQueue<T>::try_push_n(InputIt first, std::size_t count) {
+  std::size_t num_pushed = 0;
+  for (; num_pushed < count; ++num_pushed, ++first) {
+    if (!try_emplace_no_notify(*first)) {
+      break;
+    }
+  }
+
+  if (num_pushed > 0) {
+    not_empty_.notify_all();
+  }
+
+  return num_pushed;
+}
+
+template <typename T>
+template <typename OutputIt>
+std::size_t MpmcQueue<T>::try_pop_n(OutputIt out, std::size_t count) {
+  std::size_t num_popped = 0;
+  for (; num_popped < count; ++num_popped, ++out) {
+    if (!try_pop_no_notify(*out)) {
+      break;
+    }
+  }
+
+  if (num_popped > 0) {
+    not_full_.notify_all();
+  }
+
+  return num_popped;
+}
+
+template <typename T>
+template <typename InputIt>
+void MpmcQueue<T>::push_n(InputIt first, std::size_t count) {
+  while (count > 0) {
+    const auto num_pushed = try_push_n(first, count);
+    std::advance(first, num_pushed);
+    count -= num_pushed;
+    if (count > 0) {
+      not_full_.wait([this]() { return !full_approx(); });
+    }
+  }
+}
+
+template <typename T>
+template <typename OutputIt>
+std::size_t MpmcQueue<T>::pop_n(OutputIt out, std::size_t count) {
+  if (count == 0) {
+    return 0;
+  }
+
+  for (;;) {
+    const auto num_popped = try_pop_n(out, count);
+    if (num_popped > 0) {
+      return num_popped;
+    }
+
+    not_empty_.wait([this]() { return !empty_approx(); });
+  }
+}
+
+template <typename T>
+std::size_t MpmcQueue<T>::size_approx() const noexcept {
+  // Load the consumer position first so the difference is never negative.
+  const auto dequeue_pos = dequeue_pos_.load(std::memory_order_acquire);
+  const auto enqueue_pos = enqueue_pos_.load(std::memory_order_acquire);
+  return enqueue_pos >= dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_MPMC_QUEUE_HPP_
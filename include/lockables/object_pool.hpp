@@ -0,0 +1,299 @@
+//
+// lockables/object_pool.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  ObjectPool<T> recycles Guarded<T> objects. A released object keeps its value
+  and its mutex, so the next acquire does not call the allocator or construct
+  a new mutex.
+
+  ObjectPool {
+    ConcurrentVector<Guarded<T>> objects
+    ConcurrentVector<Batch> batches
+    std::atomic<uint64_t> full   // {tag, index} of the first full batch
+    std::atomic<uint64_t> empty  // {tag, index} of the first empty batch
+    RecordList<Record> records   // one cache of free objects per thread
+  }
+
+  Usage:
+
+  ObjectPool<std::vector<char>> pool;
+  {
+    auto buffer = pool.acquire();
+    auto guard = buffer->with_exclusive();
+
+    // The value may be left over from an earlier use.
+    guard->clear();
+    guard->resize(4096);
+  }
+  // The buffer and its capacity go back to the pool here.
+*/
+#ifndef LOCKABLES_OBJECT_POOL_HPP_
+#define LOCKABLES_OBJECT_POOL_HPP_
+
+#include <lockables/cache_line.hpp>
+#include <lockables/concurrent_vector.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/thread_records.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace lockables {
+
+/**
+  ObjectPool<T, Mutex> hands out Guarded<T, Mutex> objects and takes them
+  back when the handle goes out of scope.
+
+  Each thread keeps a small cache of free objects per pool, found with
+  ThreadRecords<ObjectPool>, so acquire and release usually touch only thread
+  local data. When a thread cache is full it moves a batch of kBatchSize
+  objects to the global free list. When it is empty it takes a whole batch
+  back. The global free list is a lock free stack of batches. The head packs a
+  batch index with a tag that is incremented on every update, which prevents
+  the ABA problem without a double width compare and swap.
+
+  Objects are created on demand and are only destroyed with the pool. A
+  recycled object keeps whatever value it had when it was released. Clear it
+  if needed, e.g., std::vector::clear keeps the capacity.
+
+  All handles must be released before the pool is destroyed. When a thread
+  exits, its cached objects go back to the global free list of each pool that
+  still exists. If that fails for lack of memory, the objects are not reused
+  but are still destroyed with the pool.
+*/
+template <typename T, typename Mutex = std::mutex>
+class ObjectPool {
+ public:
+  using value_type = Guarded<T, Mutex>;
+
+  class Deleter {
+   public:
+    Deleter() = default;
+    explicit Deleter(ObjectPool* pool) noexcept : pool_{pool} {}
+
+    void operator()(value_type* object) const noexcept {
+      pool_->release(object);
+    }
+
+   private:
+    ObjectPool* pool_{};
+  };
+
+  using Handle = std::unique_ptr<value_type, Deleter>;
+
+  static constexpr std::size_t kBatchSize = 32;
+
+  ObjectPool();
+
+  // Rule of 5. No copy or move.
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool(ObjectPool&&) noexcept = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+  ObjectPool& operator=(ObjectPool&&) noexcept = delete;
+  ~ObjectPool();
+
+  /**
+    Return a free object, or a new default constructed one if there are none.
+    The object goes back to the pool when the handle is destroyed.
+  */
+  [[nodiscard]] Handle acquire();
+
+  /**
+    Number of objects created by the pool, free or in use.
+  */
+  [[nodiscard]] std::size_t size() const noexcept { return objects_.size(); }
+
+ private:
+  struct Batch {
+    // Index + 1 of the next batch on the same stack, zero at the bottom.
+    std::atomic<std::uint32_t> next{};
+    std::size_t size{};
+    value_type* objects[kBatchSize] = {};
+  };
+
+  friend class detail::ThreadRecords<ObjectPool>;
+
+  // The cache of free objects of one thread.
+  struct Record {
+    std::atomic<bool> in_use{};
+    Record* next{};
+    std::vector<value_type*> objects{};
+  };
+
+  using Records = detail::ThreadRecords<ObjectPool>;
+
+  // Called from the Handle destructor, never throws.
+  void release(value_type* object) noexcept;
+
+  // The calling thread's cache for this pool.
+  std::vector<value_type*>& local() {
+    return Records::local(id_, slot_, records_).objects;
+  }
+
+  // Thread exit. Return the cached objects to the global free list.
+  void release_record(Record& record) noexcept;
+
+  // Move up to kBatchSize objects from the back of cache to the global list.
+  void spill(std::vector<value_type*>& cache);
+
+  // Move one batch from the global list to cache. Returns false if the global
+  // list is empty.
+  bool refill(std::vector<value_type*>& cache);
+
+  void push(std::atomic<std::uint64_t>& head, std::size_t index) noexcept;
+  std::optional<std::size_t> pop(std::atomic<std::uint64_t>& head) noexcept;
+
+  std::uint64_t id_;
+  std::size_t slot_;
+  ConcurrentVector<value_type> objects_{};
+  ConcurrentVector<Batch> batches_{};
+  detail::RecordList<Record> records_{};
+
+  // Stacks of batch indices. Full batches hold free objects, empty batches
+  // are recycled batch descriptors.
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> full_{};
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> empty_{};
+};
+
+template <typename T, typename Mutex>
+ObjectPool<T, Mutex>::ObjectPool()
+    : id_{Records::next_id()}, slot_{Records::acquire_slot()} {
+  Records::registry().with_exclusive()->emplace(id_, this);
+}
+
+template <typename T, typename Mutex>
+ObjectPool<T, Mutex>::~ObjectPool() {
+  // Wait for exiting threads that are returning objects to this pool.
+  Records::registry().with_exclusive()->erase(id_);
+  Records::release_slot(slot_);
+}
+
+template <typename T, typename Mutex>
+void ObjectPool<T, Mutex>::release_record(Record& record) noexcept {
+  // Thread exit must not throw. If there is no memory for another batch, the
+  // rest of the objects are not reused. The pool still owns them and destroys
+  // them with the others.
+  try {
+    while (!record.objects.empty()) {
+      spill(record.objects);
+    }
+  } catch (...) {
+    record.objects.clear();
+  }
+}
+
+template <typename T, typename Mutex>
+auto ObjectPool<T, Mutex>::acquire() -> Handle {
+  auto& cache = local();
+  if (cache.empty() && !refill(cache)) {
+    const auto index = objects_.emplace_back();
+    return Handle{&objects_[index], Deleter{this}};
+  }
+
+  value_type* object = cache.back();
+  cache.pop_back();
+  return Handle{object, Deleter{this}};
+}
+
+template <typename T, typename Mutex>
+void ObjectPool<T, Mutex>::release(value_type* object) noexcept {
+  try {
+    auto& cache = local();
+    cache.push_back(object);
+    if (cache.size() >= 2 * kBatchSize) {
+      spill(cache);
+    }
+  } catch (...) {
+    // Out of memory. The object is not reused, the pool still owns it and
+    // destroys it with the others.
+  }
+}
+
+template <typename T, typename Mutex>
+void ObjectPool<T, Mutex>::spill(std::vector<value_type*>& cache) {
+  std::size_t index = 0;
+  if (const auto empty = pop(empty_)) {
+    index = *empty;
+  } else {
+    index = batches_.emplace_back();
+    if (index >= std::numeric_limits<std::uint32_t>::max()) {
+      throw std::length_error{"ObjectPool has too many batches"};
+    }
+  }
+
+  Batch& batch = batches_[index];
+  batch.size = std::min(cache.size(), kBatchSize);
+  const auto first = cache.end() - static_cast<std::ptrdiff_t>(batch.size);
+  std::copy(first, cache.end(), batch.objects);
+  cache.erase(first, cache.end());
+
+  push(full_, index);
+}
+
+template <typename T, typename Mutex>
+bool ObjectPool<T, Mutex>::refill(std::vector<value_type*>& cache) {
+  const auto index = pop(full_);
+  if (!index) {
+    return false;
+  }
+
+  const Batch& batch = batches_[*index];
+  cache.insert(cache.end(), batch.objects, batch.objects + batch.size);
+
+  push(empty_, *index);
+  return true;
+}
+
+template <typename T, typename Mutex>
+void ObjectPool<T, Mutex>::push(std::atomic<std::uint64_t>& head,
+                                std::size_t index) noexcept {
+  Batch& batch = batches_[index];
+  auto old_head = head.load(std::memory_order_relaxed);
+  std::uint64_t new_head = 0;
+  do {
+    batch.next.store(static_cast<std::uint32_t>(old_head),
+                     std::memory_order_relaxed);
+    new_head = (((old_head >> 32) + 1) << 32) | (index + 1);
+    // Release the batch contents to the thread that pops it.
+  } while (!head.compare_exchange_weak(old_head, new_head,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed));
+}
+
+template <typename T, typename Mutex>
+auto ObjectPool<T, Mutex>::pop(std::atomic<std::uint64_t>& head) noexcept
+    -> std::optional<std::size_t> {
+  auto old_head = head.load(std::memory_order_acquire);
+  for (;;) {
+    const auto top = static_cast<std::uint32_t>(old_head);
+    if (top == 0) {
+      return std::nullopt;
+    }
+
+    // The batch may be popped and pushed again by another thread before the
+    // compare and swap. The tag changes on every update, so a stale next is
+    // never installed.
+    const Batch& batch = batches_[top - 1];
+    const std::uint64_t new_head = (((old_head >> 32) + 1) << 32) |
+                                   batch.next.load(std::memory_order_relaxed);
+    if (head.compare_exchange_weak(old_head, new_head,
+                                   std::memory_order_acquire,
+                                   std::memory_order_acquire)) {
+      return top - 1;
+    }
+  }
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_OBJECT_POOL_HPP_
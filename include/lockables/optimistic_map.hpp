@@ -0,0 +1,416 @@
+//
+// lockables/optimistic_map.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  OptimisticMap<Key, Value> is a fixed capacity, open addressing hash map for
+  lookup dominated workloads. Each bucket has a version word. Readers probe
+  and validate the version without writing to shared memory. Writers lock one
+  bucket at a time.
+
+  OptimisticMap {
+    Bucket {
+      std::atomic<uint64_t> version
+      std::atomic<uint8_t> state
+      std::atomic<Key> key
+      std::atomic<Value> value
+    } buckets[capacity]
+    std::mutex insert_mutex
+  }
+
+  Usage:
+
+  OptimisticMap<int64_t, int64_t> map{1024};
+
+  // Writer locks the bucket for key 1. Inserts Value{} if the key is missing.
+  map.with_exclusive(1, [](int64_t& value) { value += 10; });
+
+  // Reader does not lock.
+  int64_t copy = 0;
+  const bool found = map.with_shared(1, [&copy](const int64_t& value) {
+    copy = value;
+  });
+
+  assert(found && copy == 10);
+*/
+#ifndef LOCKABLES_OPTIMISTIC_MAP_HPP_
+#define LOCKABLES_OPTIMISTIC_MAP_HPP_
+
+#include <lockables/hash.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace lockables {
+
+/**
+  OptimisticMap<Key, Value> stores keys and values in a flat array of buckets
+  with linear probing. The capacity is fixed at construction and rounded up to
+  a power of two. Keep the load factor well below one, probe sequences get long
+  as the table fills up.
+
+  Each bucket is a sequence lock. A reader loads the version, copies the
+  bucket, and loads the version again. If the version is odd (a writer holds
+  the bucket) or changed, the reader retries. Readers never write so lookups
+  scale with the number of cores.
+
+  Key and Value must be trivially copyable and small enough that std::atomic
+  is lock free for them, usually 8 bytes or less. Keys are never moved once
+  they are placed in a bucket. An erased key leaves a tombstone.
+
+  A writer to a key that has a bucket, live or a tombstone, only locks that
+  bucket. A writer that adds a new key also holds a map wide insert lock. It
+  probes again to confirm that the key is missing and takes the first
+  tombstone or empty bucket on the way. Tombstones are reused, so a map with
+  key churn does not fill up. Buckets never go back to empty, so a churned
+  table probes further on a miss.
+
+  The callbacks receive a reference to a copy of the value. For writers the
+  copy is stored back before the bucket is unlocked.
+*/
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class OptimisticMap {
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+
+  static_assert(std::is_trivially_copyable_v<Key> &&
+                    std::is_trivially_copyable_v<Value>,
+                "OptimisticMap requires trivially copyable Key and Value");
+  static_assert(std::atomic<Key>::is_always_lock_free &&
+                    std::atomic<Value>::is_always_lock_free,
+                "OptimisticMap requires lock free std::atomic<Key> and "
+                "std::atomic<Value>");
+  static_assert(std::is_default_constructible_v<Value>,
+                "OptimisticMap requires default constructible Value");
+
+  /**
+    Construct an empty map with room for at least capacity keys.
+  */
+  explicit OptimisticMap(std::size_t capacity);
+
+  /**
+    Reader access. If key is found, call f(const Value&) with a consistent
+    copy of the value. Return true if the key was found. Never locks.
+  */
+  template <typename F>
+  bool with_shared(const Key& key, F&& f) const;
+
+  /**
+    Writer access. Lock the bucket for key, inserting Value{} if the key is
+    missing, and return the result of f(Value&).
+
+    Throws std::length_error if the key is missing and the table is full.
+  */
+  template <typename F>
+  std::invoke_result_t<F, Value&> with_exclusive(const Key& key, F&& f);
+
+  /**
+    Return a copy of the value for key, if found. Never locks.
+  */
+  [[nodiscard]] std::optional<Value> find(const Key& key) const;
+
+  /**
+    Remove key. Return true if it was found.
+  */
+  bool erase(const Key& key);
+
+  /**
+    Number of keys. May be stale if there are concurrent writers.
+  */
+  [[nodiscard]] std::size_t size() const noexcept {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask_ + 1; }
+
+ private:
+  enum State : std::uint8_t { kEmpty, kFull, kDeleted };
+
+  struct Bucket {
+    // Even if unlocked, odd if a writer holds the bucket.
+    std::atomic<std::uint64_t> version{};
+    std::atomic<std::uint8_t> state{kEmpty};
+    std::atomic<Key> key{};
+    std::atomic<Value> value{};
+  };
+
+  struct Snapshot {
+    std::uint8_t state;
+    Key key;
+    Value value;
+  };
+
+  // RAII writer lock on one bucket. Bumps the version to odd on lock and back
+  // to even on unlock.
+  class BucketLock {
+   public:
+    explicit BucketLock(Bucket& bucket);
+
+    // Rule of 5. No copy or move.
+    BucketLock(const BucketLock&) = delete;
+    BucketLock(BucketLock&&) noexcept = delete;
+    BucketLock& operator=(const BucketLock&) = delete;
+    BucketLock& operator=(BucketLock&&) noexcept = delete;
+    ~BucketLock();
+
+   private:
+    Bucket& bucket_;
+    std::uint64_t version_;
+  };
+
+  [[nodiscard]] std::size_t home(const Key& key) const;
+
+  // Return the bucket of key, live or a tombstone, or null. If free is not
+  // null, also find the first tombstone or empty bucket on the way.
+  [[nodiscard]] Bucket* probe(const Key& key, Bucket** free) const;
+
+  [[nodiscard]] static Snapshot read(const Bucket& bucket);
+
+  std::size_t mask_;
+  unsigned shift_;
+  std::unique_ptr<Bucket[]> buckets_;
+  std::atomic<std::size_t> size_{};
+  std::mutex insert_mutex_{};
+  Hash hash_{};
+  KeyEqual equal_{};
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+OptimisticMap<Key, Value, Hash, KeyEqual>::OptimisticMap(std::size_t capacity)
+    : mask_{0}, shift_{64} {
+  std::size_t size = 1;
+  while (size < capacity) {
+    size *= 2;
+    --shift_;
+  }
+
+  mask_ = size - 1;
+  buckets_ = std::make_unique<Bucket[]>(size);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+OptimisticMap<Key, Value, Hash, KeyEqual>::BucketLock::BucketLock(
+    Bucket& bucket)
+    : bucket_{bucket},
+      version_{bucket.version.load(std::memory_order_relaxed)} {
+  for (int spin = 0;; ++spin) {
+    if ((version_ & 1) == 0 &&
+        bucket_.version.compare_exchange_weak(version_, version_ + 1,
+                                              std::memory_order_acquire,
+                                              std::memory_order_relaxed)) {
+      break;
+    }
+
+    if (spin > 64) {
+      std::this_thread::yield();
+    }
+    version_ = bucket_.version.load(std::memory_order_relaxed);
+  }
+
+  // Order the odd version before the writes to the bucket. Pairs with the
+  // acquire fence in read().
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+OptimisticMap<Key, Value, Hash, KeyEqual>::BucketLock::~BucketLock() {
+  bucket_.version.store(version_ + 2, std::memory_order_release);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::size_t OptimisticMap<Key, Value, Hash, KeyEqual>::home(
+    const Key& key) const {
+  return detail::fibonacci_hash(static_cast<std::uint64_t>(hash_(key)),
+                                shift_) &
+         mask_;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+auto OptimisticMap<Key, Value, Hash, KeyEqual>::read(const Bucket& bucket)
+    -> Snapshot {
+  for (int spin = 0;; ++spin) {
+    const auto before = bucket.version.load(std::memory_order_acquire);
+    if ((before & 1) == 0) {
+      Snapshot snapshot{bucket.state.load(std::memory_order_relaxed),
+                        bucket.key.load(std::memory_order_relaxed),
+                        bucket.value.load(std::memory_order_relaxed)};
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (bucket.version.load(std::memory_order_relaxed) == before) {
+        return snapshot;
+      }
+    }
+
+    if (spin > 64) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename F>
+bool OptimisticMap<Key, Value, Hash, KeyEqual>::with_shared(const Key& key,
+                                                            F&& f) const {
+  // Keys are unique along a probe sequence, and the sequence ends at the
+  // first empty bucket.
+  const std::size_t first = home(key);
+  for (std::size_t i = 0; i <= mask_; ++i) {
+    const Snapshot snapshot = read(buckets_[(first + i) & mask_]);
+    if (snapshot.state == kEmpty) {
+      return false;
+    }
+
+    if (equal_(snapshot.key, key)) {
+      if (snapshot.state != kFull) {
+        return false;
+      }
+
+      const Value& value = snapshot.value;
+      std::invoke(std::forward<F>(f), value);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+auto OptimisticMap<Key, Value, Hash, KeyEqual>::probe(const Key& key,
+                                                      Bucket** free) const
+    -> Bucket* {
+  const std::size_t first = home(key);
+  for (std::size_t i = 0; i <= mask_; ++i) {
+    Bucket& bucket = buckets_[(first + i) & mask_];
+    const Snapshot snapshot = read(bucket);
+    if (snapshot.state == kEmpty) {
+      if (free != nullptr && *free == nullptr) {
+        *free = &bucket;
+      }
+      return nullptr;
+    }
+
+    if (equal_(snapshot.key, key)) {
+      return &bucket;
+    }
+
+    if (snapshot.state == kDeleted && free != nullptr && *free == nullptr) {
+      *free = &bucket;
+    }
+  }
+
+  return nullptr;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename F>
+auto OptimisticMap<Key, Value, Hash, KeyEqual>::with_exclusive(const Key& key,
+                                                               F&& f)
+    -> std::invoke_result_t<F, Value&> {
+  for (;;) {
+    std::unique_lock<std::mutex> insert_lock;
+
+    Bucket* bucket = probe(key, nullptr);
+    if (bucket == nullptr) {
+      // New key. Only one writer at a time may place a key, so two writers
+      // can not place the same key in two buckets.
+      insert_lock = std::unique_lock<std::mutex>{insert_mutex_};
+
+      Bucket* free = nullptr;
+      bucket = probe(key, &free);
+      if (bucket == nullptr) {
+        if (free == nullptr) {
+          throw std::length_error{"OptimisticMap is full"};
+        }
+        bucket = free;
+      }
+    }
+
+    BucketLock lock{*bucket};
+
+    const auto state = bucket->state.load(std::memory_order_relaxed);
+    if (state == kEmpty ||
+        !equal_(bucket->key.load(std::memory_order_relaxed), key)) {
+      if (!insert_lock.owns_lock() || state == kFull) {
+        // A tombstone was reused or revived first. Probe again.
+        continue;
+      }
+
+      // Claim the empty bucket or the tombstone of another key.
+      bucket->key.store(key, std::memory_order_relaxed);
+    }
+
+    if (state != kFull) {
+      bucket->value.store(Value{}, std::memory_order_relaxed);
+      bucket->state.store(kFull, std::memory_order_relaxed);
+      size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (insert_lock.owns_lock()) {
+      insert_lock.unlock();
+    }
+
+    Value value = bucket->value.load(std::memory_order_relaxed);
+    if constexpr (std::is_void_v<std::invoke_result_t<F, Value&>>) {
+      std::invoke(std::forward<F>(f), value);
+      bucket->value.store(value, std::memory_order_relaxed);
+      return;
+    } else {
+      auto result = std::invoke(std::forward<F>(f), value);
+      bucket->value.store(value, std::memory_order_relaxed);
+      return result;
+    }
+  }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+auto OptimisticMap<Key, Value, Hash, KeyEqual>::find(const Key& key) const
+    -> std::optional<Value> {
+  std::optional<Value> result;
+  with_shared(key, [&result](const Value& value) { result = value; });
+  return result;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+bool OptimisticMap<Key, Value, Hash, KeyEqual>::erase(const Key& key) {
+  const std::size_t first = home(key);
+  for (std::size_t i = 0; i <= mask_; ++i) {
+    Bucket& bucket = buckets_[(first + i) & mask_];
+    const Snapshot snapshot = read(bucket);
+    if (snapshot.state == kEmpty) {
+      return false;
+    }
+
+    if (!equal_(snapshot.key, key)) {
+      continue;
+    }
+
+    // Leave the key in place as a tombstone. The next new key along the probe
+    // sequence may reuse it.
+    BucketLock lock{bucket};
+    if (bucket.state.load(std::memory_order_relaxed) != kFull) {
+      return false;
+    }
+
+    bucket.state.store(kDeleted, std::memory_order_relaxed);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_OPTIMISTIC_MAP_HPP_
@@ -0,0 +1,161 @@
+//
+// lockables/owned_mutex.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  OwnedMutex<Mutex> wraps a mutex and records the thread that holds the
+  exclusive lock. A thread that tries to lock a mutex it already owns fails
+  fast instead of deadlocking. The default handler from
+  lockables/lock_violation.hpp throws std::system_error with
+  std::errc::resource_deadlock_would_occur.
+
+  OwnedMutex {
+    Mutex mutex
+    std::atomic<uintptr_t> owner  // thread with the exclusive lock, or 0
+    const char* name
+  }
+
+  The check costs a relaxed load and a relaxed store per lock, cheap enough to
+  leave on in production.
+
+  Usage:
+
+  Guarded<int, owned_mutex_t<std::mutex>> value{LockName{"value"}};
+
+  {
+    auto guard = value.with_exclusive();
+
+    // Throws std::system_error instead of a deadlock.
+    auto recursive = value.with_exclusive();
+  }
+*/
+#ifndef LOCKABLES_OWNED_MUTEX_HPP_
+#define LOCKABLES_OWNED_MUTEX_HPP_
+
+#include <lockables/guarded.hpp>
+#include <lockables/lock_violation.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+
+namespace lockables {
+
+namespace detail {
+
+// Unique for each live thread.
+inline std::uintptr_t this_thread_tag() noexcept {
+  static thread_local const char tag{};
+  return reinterpret_cast<std::uintptr_t>(&tag);
+}
+
+}  // namespace detail
+
+/**
+  OwnedMutex<Mutex> meets the same Lockable or SharedLockable requirements as
+  Mutex. The lock(), try_lock(), lock_shared(), and try_lock_shared() methods
+  call the handler if the calling thread holds the exclusive lock.
+
+  Only the exclusive owner is recorded. A thread that takes a second shared
+  lock, or an exclusive lock while it holds a shared lock, is not detected.
+
+  The owner is only ever equal to the calling thread if that thread stored
+  it, so relaxed loads and stores are enough.
+*/
+template <typename Mutex = std::mutex>
+class OwnedMutex {
+ public:
+  static_assert(!std::is_same_v<Mutex, std::recursive_mutex> &&
+                    !std::is_same_v<Mutex, std::recursive_timed_mutex>,
+                "A recursive mutex may be locked by its owner");
+
+  using mutex_type = Mutex;
+
+  OwnedMutex() = default;
+
+  /**
+    Name from a Guarded<T> constructor tag, also passed on to Mutex.
+  */
+  explicit OwnedMutex(LockName name)
+      : mutex_{detail::make_mutex<Mutex>(name)}, name_{name.value} {}
+
+  // Rule of 5. No copy or move.
+  OwnedMutex(const OwnedMutex&) = delete;
+  OwnedMutex(OwnedMutex&&) noexcept = delete;
+  OwnedMutex& operator=(const OwnedMutex&) = delete;
+  OwnedMutex& operator=(OwnedMutex&&) noexcept = delete;
+  ~OwnedMutex() = default;
+
+  void lock() {
+    check(LockViolation::Kind::kRecursiveExclusive);
+    mutex_.lock();
+    owner_.store(detail::this_thread_tag(), std::memory_order_relaxed);
+  }
+
+  bool try_lock() {
+    check(LockViolation::Kind::kRecursiveExclusive);
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+
+    owner_.store(detail::this_thread_tag(), std::memory_order_relaxed);
+    return true;
+  }
+
+  void unlock() {
+    owner_.store(0, std::memory_order_relaxed);
+    mutex_.unlock();
+  }
+
+  void lock_shared() {
+    check(LockViolation::Kind::kSharedWhileExclusive);
+    mutex_.lock_shared();
+  }
+
+  bool try_lock_shared() {
+    check(LockViolation::Kind::kSharedWhileExclusive);
+    return mutex_.try_lock_shared();
+  }
+
+  void unlock_shared() { mutex_.unlock_shared(); }
+
+  /**
+    True if the calling thread holds the exclusive lock.
+  */
+  [[nodiscard]] bool owned_by_this_thread() const noexcept {
+    return owner_.load(std::memory_order_relaxed) == detail::this_thread_tag();
+  }
+
+ private:
+  void check(LockViolation::Kind kind) const {
+    if (owned_by_this_thread()) {
+      detail::report_lock_violation(LockViolation{kind, this, name_});
+    }
+  }
+
+  Mutex mutex_{};
+  std::atomic<std::uintptr_t> owner_{};
+  const char* name_{};
+};
+
+template <typename Mutex>
+struct SharedLock<OwnedMutex<Mutex>> : WrappedSharedLock<OwnedMutex<Mutex>> {};
+
+/**
+  Opt out alias. OwnedMutex<Mutex> by default, or plain Mutex if
+  LOCKABLES_DISABLE_OWNER_CHECK is defined.
+*/
+#if defined(LOCKABLES_DISABLE_OWNER_CHECK)
+template <typename Mutex>
+using owned_mutex_t = Mutex;
+#else
+template <typename Mutex>
+using owned_mutex_t = OwnedMutex<Mutex>;
+#endif
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_OWNED_MUTEX_HPP_
@@ -0,0 +1,80 @@
+//
+// lockables/parking.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  Park threads on a condition variable until some lock free state changes.
+  Used by the blocking operations of the lock free containers.
+
+  Usage:
+
+  detail::Parking not_empty;
+
+  // Consumer.
+  not_empty.wait([&]() { return !queue.empty(); });
+
+  // Producer, after the push is visible.
+  not_empty.notify_one();
+*/
+#ifndef LOCKABLES_PARKING_HPP_
+#define LOCKABLES_PARKING_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace lockables {
+
+namespace detail {
+
+/**
+  Park threads that wait for a condition. The notify side only touches the
+  mutex if a thread is actually waiting.
+*/
+class Parking {
+ public:
+  /**
+    Block until ready() returns true. The ready() predicate is checked again
+    after the waiter is registered so no wakeup is lost.
+  */
+  template <typename Predicate>
+  void wait(Predicate ready) {
+    std::unique_lock lock{mutex_};
+    waiters_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cv_.wait(lock, ready);
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  /**
+    Call after the state that ready() depends on was published.
+  */
+  void notify_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) != 0) {
+      // Lock so we can not notify between the predicate check and the wait.
+      { std::scoped_lock lock{mutex_}; }
+      cv_.notify_one();
+    }
+  }
+
+  void notify_all() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) != 0) {
+      { std::scoped_lock lock{mutex_}; }
+      cv_.notify_all();
+    }
+  }
+
+ private:
+  std::mutex mutex_{};
+  std::condition_variable cv_{};
+  std::atomic<int> waiters_{};
+};
+
+}  // namespace detail
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_PARKING_HPP_
@@ -0,0 +1,286 @@
+//
+// lockables/ranked_mutex.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  RankedMutex<Rank, Mutex> places a mutex in a lock hierarchy. Locks are
+  always acquired in ascending rank order, so there can be no cycle and no
+  deadlock.
+
+  The free with_exclusive function locks values with ranked mutexes in rank
+  order, sorted at compile time. It does not need the try and back off
+  deadlock avoidance of std::scoped_lock. Checked builds also track the ranks
+  held by each thread and fail fast on a nested lock of a lower or equal rank.
+
+  RankedMutex {
+    Mutex mutex
+    const char* name
+  }
+
+  thread_local {
+    unsigned held[]  // ranks held by this thread, ascending, checked builds
+  }
+
+  Usage:
+
+  // Lower ranks are locked first.
+  Guarded<Accounts, RankedMutex<1>> accounts;
+  Guarded<Ledger, RankedMutex<2>> ledger;
+
+  // Locks accounts and then ledger, in any argument order.
+  with_exclusive([](Ledger& x, Accounts& y) {}, ledger, accounts);
+
+  {
+    auto guard = ledger.with_exclusive();
+
+    // Checked builds throw std::system_error, rank 1 after rank 2.
+    auto nested = accounts.with_exclusive();
+  }
+*/
+#ifndef LOCKABLES_RANKED_MUTEX_HPP_
+#define LOCKABLES_RANKED_MUTEX_HPP_
+
+#include <lockables/guarded.hpp>
+#include <lockables/lock_violation.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace lockables {
+
+/**
+  Default of the Checked parameter of RankedMutex. True in debug builds, or
+  if LOCKABLES_CHECK_LOCK_ORDER is defined.
+*/
+#if !defined(NDEBUG) || defined(LOCKABLES_CHECK_LOCK_ORDER)
+inline constexpr bool kCheckLockRank = true;
+#else
+inline constexpr bool kCheckLockRank = false;
+#endif
+
+namespace detail {
+
+// Ranks held by this thread, in ascending order.
+inline std::vector<unsigned>& held_ranks() {
+  static thread_local std::vector<unsigned> ranks{};
+  return ranks;
+}
+
+// Indices of ranks in ascending rank order. Insertion sort, there are only a
+// few mutexes in one call.
+template <std::size_t N>
+constexpr std::array<std::size_t, N> rank_order(
+    const std::array<unsigned, N>& ranks) {
+  std::array<std::size_t, N> order{};
+  for (std::size_t i = 0; i < N; ++i) {
+    order[i] = i;
+  }
+
+  for (std::size_t i = 1; i < N; ++i) {
+    for (std::size_t j = i; j > 0 && ranks[order[j - 1]] > ranks[order[j]];
+         --j) {
+      const std::size_t tmp = order[j];
+      order[j] = order[j - 1];
+      order[j - 1] = tmp;
+    }
+  }
+
+  return order;
+}
+
+}  // namespace detail
+
+/**
+  RankedMutex<Rank, Mutex, Checked> meets the same Lockable or SharedLockable
+  requirements as Mutex.
+
+  If Checked is true, the lock() and lock_shared() methods call the lock
+  violation handler if this thread holds a lock of a rank that is greater than
+  or equal to Rank. The default handler throws std::system_error. The
+  try_lock() methods cannot deadlock and are not checked. Checks cost a
+  thread local lookup per lock. If Checked is false there is no overhead.
+*/
+template <unsigned Rank, typename Mutex = std::mutex,
+          bool Checked = kCheckLockRank>
+class RankedMutex {
+ public:
+  using mutex_type = Mutex;
+
+  static constexpr unsigned rank = Rank;
+
+  RankedMutex() = default;
+
+  /**
+    Name from a Guarded<T> constructor tag, also passed on to Mutex.
+  */
+  explicit RankedMutex(LockName name)
+      : mutex_{detail::make_mutex<Mutex>(name)}, name_{name.value} {}
+
+  // Rule of 5. No copy or move.
+  RankedMutex(const RankedMutex&) = delete;
+  RankedMutex(RankedMutex&&) noexcept = delete;
+  RankedMutex& operator=(const RankedMutex&) = delete;
+  RankedMutex& operator=(RankedMutex&&) noexcept = delete;
+  ~RankedMutex() = default;
+
+  void lock() {
+    check();
+    mutex_.lock();
+    acquired();
+  }
+
+  bool try_lock() {
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+
+    acquired();
+    return true;
+  }
+
+  void unlock() {
+    released();
+    mutex_.unlock();
+  }
+
+  void lock_shared() {
+    check();
+    mutex_.lock_shared();
+    acquired();
+  }
+
+  bool try_lock_shared() {
+    if (!mutex_.try_lock_shared()) {
+      return false;
+    }
+
+    acquired();
+    return true;
+  }
+
+  void unlock_shared() {
+    released();
+    mutex_.unlock_shared();
+  }
+
+ private:
+  void check() const {
+    if constexpr (Checked) {
+      const auto& held = detail::held_ranks();
+      if (!held.empty() && held.back() >= Rank) {
+        detail::report_lock_violation(
+            LockViolation{LockViolation::Kind::kRankOrder, this, name_});
+      }
+    }
+  }
+
+  void acquired() {
+    if constexpr (Checked) {
+      // Sorted, a try_lock may take a lower rank.
+      auto& held = detail::held_ranks();
+      held.insert(std::upper_bound(held.begin(), held.end(), Rank), Rank);
+    }
+  }
+
+  void released() noexcept {
+    if constexpr (Checked) {
+      auto& held = detail::held_ranks();
+      const auto itr = std::lower_bound(held.begin(), held.end(), Rank);
+      if (itr != held.end() && *itr == Rank) {
+        held.erase(itr);
+      }
+    }
+  }
+
+  Mutex mutex_{};
+  const char* name_{};
+};
+
+/**
+  RankedLock<MutexTypes...> locks ranked mutexes in ascending rank order and
+  unlocks them in reverse. The order is sorted at compile time. Two mutexes
+  of the same rank have no order and do not compile.
+
+  The with_exclusive function uses RankedLock if every value has a
+  RankedMutex.
+*/
+template <typename... MutexTypes>
+class RankedLock {
+ public:
+  explicit RankedLock(MutexTypes&... mutexes) : mutexes_{mutexes...} {
+    lock(std::make_index_sequence<kNumMutex>{});
+  }
+
+  // Rule of 5. No copy or move.
+  RankedLock(const RankedLock&) = delete;
+  RankedLock(RankedLock&&) noexcept = delete;
+  RankedLock& operator=(const RankedLock&) = delete;
+  RankedLock& operator=(RankedLock&&) noexcept = delete;
+  ~RankedLock() { unlock(kNumMutex, std::make_index_sequence<kNumMutex>{}); }
+
+ private:
+  static constexpr std::size_t kNumMutex = sizeof...(MutexTypes);
+  static constexpr std::array<unsigned, kNumMutex> kRanks{MutexTypes::rank...};
+  static constexpr std::array<std::size_t, kNumMutex> kOrder =
+      detail::rank_order<kNumMutex>(kRanks);
+
+  static constexpr bool is_strict_order() {
+    for (std::size_t i = 1; i < kNumMutex; ++i) {
+      if (kRanks[kOrder[i - 1]] == kRanks[kOrder[i]]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static_assert(is_strict_order(), "Mutexes of equal rank have no lock order");
+
+  // Lock position P of the sorted order.
+  template <std::size_t... P>
+  void lock(std::index_sequence<P...>) {
+    if constexpr (kNumMutex > 0) {
+      std::size_t count = 0;
+      try {
+        ((std::get<kOrder[P]>(mutexes_).lock(), ++count), ...);
+      } catch (...) {
+        unlock(count, std::index_sequence<P...>{});
+        throw;
+      }
+    }
+  }
+
+  // Unlock the first count positions of the sorted order, last first.
+  template <std::size_t... P>
+  void unlock(std::size_t count, std::index_sequence<P...>) noexcept {
+    ((kNumMutex - 1 - P < count
+          ? std::get<kOrder[kNumMutex - 1 - P]>(mutexes_).unlock()
+          : void()),
+     ...);
+  }
+
+  std::tuple<MutexTypes&...> mutexes_;
+};
+
+/**
+  The with_exclusive function locks values with ranked mutexes in rank order,
+  without the deadlock avoidance of std::scoped_lock.
+*/
+template <unsigned... Ranks, typename... Mutexes, bool... Checked>
+struct ExclusiveLock<RankedMutex<Ranks, Mutexes, Checked>...> {
+  using type = RankedLock<RankedMutex<Ranks, Mutexes, Checked>...>;
+};
+
+template <unsigned Rank, typename Mutex, bool Checked>
+struct SharedLock<RankedMutex<Rank, Mutex, Checked>>
+    : WrappedSharedLock<RankedMutex<Rank, Mutex, Checked>> {};
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_RANKED_MUTEX_HPP_
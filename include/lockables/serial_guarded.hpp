@@ -0,0 +1,229 @@
+//
+// lockables/serial_guarded.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  SerialGuarded<T> is a class template that stores a strand together with the
+  value it guards. The value is only accessed from callbacks that run on the
+  strand, so lock acquisition becomes queueing and callers never block.
+
+  SerialGuarded {
+    T value
+    Strand<ThreadPool> strand
+  }
+
+  Usage:
+
+  ThreadPool pool;
+  SerialGuarded<int> value{pool, 9};
+
+  std::future<int> result = async_with_exclusive(
+      [](int& x) {
+        // Runs on a pool thread with exclusive access to value.
+        x += 10;
+        return x;
+      },
+      value);
+
+  assert(result.get() == 19);
+*/
+#ifndef LOCKABLES_SERIAL_GUARDED_HPP_
+#define LOCKABLES_SERIAL_GUARDED_HPP_
+
+#include <lockables/thread_pool.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace lockables {
+
+/**
+  SerialGuarded<T> is a class template that stores a Strand<Executor> together
+  with the value it guards. There are no public accessors. Use the
+  async_with_exclusive function to run a callback with access to one or more
+  SerialGuarded<T> values.
+
+  The SerialGuarded<T> value must outlive all of the pending callbacks.
+*/
+template <typename T, typename Executor = ThreadPool>
+class SerialGuarded {
+ public:
+  /**
+    Construct a guarded value of type T. All arguments in the parameter pack
+    Args are forwarded to the constructor of T.
+   */
+  template <typename... Args>
+  explicit SerialGuarded(Executor& executor, Args&&... args);
+
+ private:
+  T value_{};
+  Strand<Executor> strand_;
+
+  // The async_with_exclusive function needs access to the internals to queue
+  // on multiple SerialGuarded<T> values at once.
+  template <typename F, typename Ex, typename... ValueTypes>
+  friend std::future<std::invoke_result_t<F, ValueTypes&...>>
+  async_with_exclusive(F&& f, SerialGuarded<ValueTypes, Ex>&... values);
+};
+
+template <typename T, typename Executor>
+template <typename... Args>
+SerialGuarded<T, Executor>::SerialGuarded(Executor& executor, Args&&... args)
+    : value_{std::forward<Args>(args)...}, strand_{executor} {}
+
+namespace detail {
+
+/**
+  State of one async_with_exclusive call. Shared by the chain of strand
+  callbacks that acquire each strand in turn.
+*/
+template <typename Executor, typename F, typename... ValueTypes>
+class AsyncExclusiveOp {
+ public:
+  using result_type = std::invoke_result_t<F, ValueTypes&...>;
+  using strand_type = Strand<Executor>;
+
+  static_assert(!std::is_rvalue_reference_v<result_type>,
+                "async_with_exclusive callback must not return an rvalue "
+                "reference");
+
+  template <typename Fn>
+  AsyncExclusiveOp(Fn&& f, std::array<strand_type*, sizeof...(ValueTypes)>
+                               strands,
+                   ValueTypes&... values)
+      : f_{std::forward<Fn>(f)}, strands_{strands}, values_{values...} {}
+
+  std::future<result_type> get_future() { return promise_.get_future(); }
+
+  // Acquire strands in order, then run the user callback.
+  static void acquire(const std::shared_ptr<AsyncExclusiveOp>& op,
+                      std::size_t index) {
+    if (index == op->strands_.size()) {
+      op->run();
+      return;
+    }
+
+    op->strands_[index]->acquire([op, index]() { acquire(op, index + 1); });
+  }
+
+ private:
+  void run() {
+    // Hold the result until the strands are released. References are stored
+    // as pointers.
+    using storage_type = std::conditional_t<
+        std::is_void_v<result_type>, std::nullptr_t,
+        std::conditional_t<std::is_lvalue_reference_v<result_type>,
+                           std::remove_reference_t<result_type>*,
+                           result_type>>;
+
+    std::exception_ptr error;
+    [[maybe_unused]] std::optional<storage_type> result;
+    try {
+      if constexpr (std::is_void_v<result_type>) {
+        std::apply(f_, values_);
+      } else if constexpr (std::is_lvalue_reference_v<result_type>) {
+        result.emplace(&std::apply(f_, values_));
+      } else {
+        result.emplace(std::apply(f_, values_));
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    // Release before the future is ready. The caller may destroy the values as
+    // soon as it observes the result.
+    for (auto itr = strands_.rbegin(); itr != strands_.rend(); ++itr) {
+      (*itr)->release();
+    }
+
+    if (error) {
+      promise_.set_exception(error);
+    } else if constexpr (std::is_void_v<result_type>) {
+      promise_.set_value();
+    } else if constexpr (std::is_lvalue_reference_v<result_type>) {
+      promise_.set_value(**result);
+    } else {
+      promise_.set_value(std::move(*result));
+    }
+  }
+
+  std::decay_t<F> f_;
+  std::array<strand_type*, sizeof...(ValueTypes)> strands_;
+  std::tuple<ValueTypes&...> values_;
+  std::promise<result_type> promise_{};
+};
+
+}  // namespace detail
+
+/**
+  The async_with_exclusive function queues a user supplied callback with
+  exclusive access to one or more SerialGuarded<T> objects. Returns a
+  std::future for the result of the callback. Never blocks the caller.
+
+  Callbacks on the same SerialGuarded<T> value run one at a time in the order
+  they were queued. With multiple values, the strands are acquired one after
+  the other in a global order (by address) so there is no deadlock. No thread
+  is blocked while waiting for a strand.
+
+  Basic usage:
+
+  ThreadPool pool;
+  SerialGuarded<int> value{pool};
+
+  auto future = async_with_exclusive(
+      [](int& x) {
+        // Writer with exclusive access to value.
+        x += 10;
+      },
+      value);
+
+  future.wait();
+
+  Usage:
+
+  SerialGuarded<int> value1{pool, 1};
+  SerialGuarded<int> value2{pool, 2};
+
+  auto future = async_with_exclusive(
+      [](int& x, int& y) {
+        // Writer with exclusive access to value1 and value2.
+        x += y;
+        y /= 2;
+        return x;
+      },
+      value1, value2);
+
+  assert(future.get() == 3);
+
+  A value must not appear more than once in the argument list.
+*/
+template <typename F, typename Executor, typename... ValueTypes>
+std::future<std::invoke_result_t<F, ValueTypes&...>> async_with_exclusive(
+    F&& f, SerialGuarded<ValueTypes, Executor>&... values) {
+  using op_type = detail::AsyncExclusiveOp<Executor, F, ValueTypes...>;
+
+  std::array<Strand<Executor>*, sizeof...(ValueTypes)> strands{
+      &values.strand_...};
+  std::sort(strands.begin(), strands.end(), std::less<>{});
+
+  auto op = std::make_shared<op_type>(std::forward<F>(f), strands,
+                                      values.value_...);
+  auto future = op->get_future();
+  op_type::acquire(op, 0);
+
+  return future;
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_SERIAL_GUARDED_HPP_
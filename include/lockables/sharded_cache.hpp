@@ -0,0 +1,368 @@
+//
+// lockables/sharded_cache.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  ShardedCache<Key, Value> is a fixed capacity cache split into independently
+  guarded shards. Eviction uses the CLOCK approximation of LRU, so a cache hit
+  only needs a shared lock and one relaxed atomic store to record that the
+  entry was used.
+
+  ShardedCache {
+    Guarded<Shard, std::shared_mutex> shards[N]
+  }
+
+  Shard {
+    std::unordered_map<Key, size_t> index
+    Entry {
+      std::pair<Key, Value> item
+      std::atomic<bool> referenced
+    } entries[capacity / N]
+    size_t hand
+  }
+
+  Usage:
+
+  ShardedCache<std::string, Image> cache{1024};
+
+  // Concurrent misses for the same key call load_image once. The other
+  // callers wait for the result.
+  Image image = cache.get_or_compute("logo.png", [](const std::string& path) {
+    return load_image(path);
+  });
+
+  // Lookup only.
+  std::optional<Image> copy = cache.get("logo.png");
+*/
+#ifndef LOCKABLES_SHARDED_CACHE_HPP_
+#define LOCKABLES_SHARDED_CACHE_HPP_
+
+#include <lockables/cache_line.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/hash.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace lockables {
+
+/**
+  ShardedCache<Key, Value> stores up to capacity entries spread over a power of
+  two number of shards. Each key belongs to one shard, and each shard is a
+  Guarded<T, std::shared_mutex>.
+
+  Hits take a shared lock on one shard and set the reference bit of the entry.
+  Readers of the same shard do not block each other. Inserts take an exclusive
+  lock and, if the shard is full, advance the clock hand: entries with the
+  reference bit set get a second chance, the first entry without it is
+  evicted. New entries start with the bit clear so keys that are only used
+  once are evicted first.
+
+  The get_or_compute method deduplicates concurrent misses. The first caller
+  computes the value without holding any lock. Other callers for the same key
+  wait on a std::shared_future for that result.
+
+  All accessors return copies, so Value must be copy constructible.
+*/
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class ShardedCache {
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+
+  static constexpr std::size_t kDefaultNumShard = 16;
+
+  /**
+    Construct an empty cache with room for at least capacity entries. The
+    number of shards is rounded up to a power of two. Each shard holds at least
+    one entry.
+  */
+  explicit ShardedCache(std::size_t capacity,
+                        std::size_t num_shard = kDefaultNumShard);
+
+  /**
+    Return a copy of the value for key, if cached. Takes a shared lock on one
+    shard.
+  */
+  [[nodiscard]] std::optional<Value> get(const Key& key) const;
+
+  /**
+    Insert or replace the value for key. May evict another entry from the same
+    shard.
+  */
+  void put(const Key& key, Value value);
+
+  /**
+    Remove key. Return true if it was cached.
+  */
+  bool erase(const Key& key);
+
+  /**
+    Return the cached value for key. On a miss, call compute(const Key&) and
+    cache the result. If another thread is already computing the value for key,
+    wait for its result instead.
+
+    If compute throws, nothing is cached and the exception is rethrown to the
+    caller and to all of the waiters.
+  */
+  template <typename F>
+  Value get_or_compute(const Key& key, F&& compute);
+
+  /**
+    Number of cached entries. Locks all shards, one at a time.
+  */
+  [[nodiscard]] std::size_t size() const;
+
+  [[nodiscard]] std::size_t capacity() const noexcept {
+    return shard_capacity_ * num_shard_;
+  }
+
+  [[nodiscard]] std::size_t num_shard() const noexcept { return num_shard_; }
+
+ private:
+  struct Entry {
+    std::optional<std::pair<Key, Value>> item{};
+    // Set by readers holding a shared lock.
+    mutable std::atomic<bool> referenced{};
+  };
+
+  struct ShardData {
+    std::unordered_map<Key, std::size_t, Hash, KeyEqual> index{};
+    std::unique_ptr<Entry[]> entries{};
+    std::size_t size{};
+    std::size_t hand{};
+    std::unordered_map<Key, std::shared_future<Value>, Hash, KeyEqual>
+        pending{};
+  };
+
+  // Pad each shard to its own cache line(s).
+  struct alignas(kCacheLineSize) Shard {
+    Guarded<ShardData, std::shared_mutex> value{};
+  };
+
+  [[nodiscard]] std::size_t shard_index(const Key& key) const;
+
+  // Call with the shard locked for writing.
+  void insert_locked(ShardData& shard, const Key& key, Value value);
+
+  // Call with the shard locked for reading. Records the hit.
+  [[nodiscard]] static const Entry* find_locked(const ShardData& shard,
+                                                const Key& key);
+
+  std::size_t num_shard_;
+  std::size_t shard_capacity_;
+  unsigned shift_;
+  std::unique_ptr<Shard[]> shards_;
+  Hash hash_{};
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+ShardedCache<Key, Value, Hash, KeyEqual>::ShardedCache(std::size_t capacity,
+                                                       std::size_t num_shard)
+    : num_shard_{1}, shard_capacity_{1}, shift_{64} {
+  while (num_shard_ < num_shard) {
+    num_shard_ *= 2;
+    --shift_;
+  }
+
+  shard_capacity_ = std::max<std::size_t>(
+      (capacity + num_shard_ - 1) / num_shard_, 1);
+
+  shards_ = std::make_unique<Shard[]>(num_shard_);
+  for (std::size_t i = 0; i < num_shard_; ++i) {
+    auto guard = shards_[i].value.with_exclusive();
+    guard->index.reserve(shard_capacity_);
+    guard->entries = std::make_unique<Entry[]>(shard_capacity_);
+  }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::size_t ShardedCache<Key, Value, Hash, KeyEqual>::shard_index(
+    const Key& key) const {
+  if (num_shard_ == 1) {
+    return 0;
+  }
+
+  return detail::fibonacci_hash(static_cast<std::uint64_t>(hash_(key)), shift_);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+auto ShardedCache<Key, Value, Hash, KeyEqual>::find_locked(
+    const ShardData& shard, const Key& key) -> const Entry* {
+  const auto itr = shard.index.find(key);
+  if (itr == shard.index.end()) {
+    return nullptr;
+  }
+
+  const Entry& entry = shard.entries[itr->second];
+  // Skip the store if the bit is already set so hot entries do not bounce
+  // their cache line between readers.
+  if (!entry.referenced.load(std::memory_order_relaxed)) {
+    entry.referenced.store(true, std::memory_order_relaxed);
+  }
+
+  return &entry;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+void ShardedCache<Key, Value, Hash, KeyEqual>::insert_locked(
+    ShardData& shard, const Key& key, Value value) {
+  if (const auto itr = shard.index.find(key); itr != shard.index.end()) {
+    Entry& entry = shard.entries[itr->second];
+    entry.item->second = std::move(value);
+    entry.referenced.store(true, std::memory_order_relaxed);
+    return;
+  }
+
+  std::size_t slot = shard.size;
+  if (shard.size < shard_capacity_) {
+    ++shard.size;
+  } else {
+    // CLOCK. Clear reference bits until the hand finds an entry without one.
+    for (;;) {
+      Entry& entry = shard.entries[shard.hand];
+      slot = shard.hand;
+      shard.hand = (shard.hand + 1) % shard_capacity_;
+      if (!entry.referenced.exchange(false, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+
+    shard.index.erase(shard.entries[slot].item->first);
+  }
+
+  Entry& entry = shard.entries[slot];
+  entry.item.emplace(key, std::move(value));
+  entry.referenced.store(false, std::memory_order_relaxed);
+  shard.index.emplace(key, slot);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+auto ShardedCache<Key, Value, Hash, KeyEqual>::get(const Key& key) const
+    -> std::optional<Value> {
+  const auto guard = shards_[shard_index(key)].value.with_shared();
+  if (const Entry* entry = find_locked(*guard, key)) {
+    return entry->item->second;
+  }
+
+  return std::nullopt;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+void ShardedCache<Key, Value, Hash, KeyEqual>::put(const Key& key,
+                                                   Value value) {
+  auto guard = shards_[shard_index(key)].value.with_exclusive();
+  insert_locked(*guard, key, std::move(value));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+bool ShardedCache<Key, Value, Hash, KeyEqual>::erase(const Key& key) {
+  auto guard = shards_[shard_index(key)].value.with_exclusive();
+  const auto itr = guard->index.find(key);
+  if (itr == guard->index.end()) {
+    return false;
+  }
+
+  // Fill the hole with the last entry so that entries [0, size) stay in use.
+  const std::size_t slot = itr->second;
+  const std::size_t last = guard->size - 1;
+  guard->index.erase(itr);
+  if (slot != last) {
+    Entry& entry = guard->entries[slot];
+    Entry& moved = guard->entries[last];
+    entry.item = std::move(moved.item);
+    entry.referenced.store(moved.referenced.load(std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+    guard->index[entry.item->first] = slot;
+  }
+
+  guard->entries[last].item.reset();
+  guard->size = last;
+  if (guard->hand >= guard->size) {
+    guard->hand = 0;
+  }
+
+  return true;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename F>
+Value ShardedCache<Key, Value, Hash, KeyEqual>::get_or_compute(const Key& key,
+                                                               F&& compute) {
+  auto& shard = shards_[shard_index(key)].value;
+  {
+    const auto guard = shard.with_shared();
+    if (const Entry* entry = find_locked(*guard, key)) {
+      return entry->item->second;
+    }
+  }
+
+  std::promise<Value> promise;
+  std::shared_future<Value> future;
+  {
+    auto guard = shard.with_exclusive();
+    if (const Entry* entry = find_locked(*guard, key)) {
+      return entry->item->second;
+    }
+
+    if (const auto itr = guard->pending.find(key);
+        itr != guard->pending.end()) {
+      future = itr->second;
+    } else {
+      guard->pending.emplace(key, promise.get_future().share());
+    }
+  }
+
+  if (future.valid()) {
+    // Another thread is computing the value.
+    return future.get();
+  }
+
+  try {
+    Value value = std::invoke(std::forward<F>(compute), key);
+    {
+      auto guard = shard.with_exclusive();
+      insert_locked(*guard, key, value);
+      guard->pending.erase(key);
+    }
+
+    promise.set_value(value);
+    return value;
+  } catch (...) {
+    {
+      auto guard = shard.with_exclusive();
+      guard->pending.erase(key);
+    }
+
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::size_t ShardedCache<Key, Value, Hash, KeyEqual>::size() const {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < num_shard_; ++i) {
+    const auto guard = shards_[i].value.with_shared();
+    count += guard->size;
+  }
+
+  return count;
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_SHARDED_CACHE_HPP_
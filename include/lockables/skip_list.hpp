@@ -0,0 +1,465 @@
+//
+// lockables/skip_list.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  SkipList<Key, Value> is a concurrent ordered map. Readers traverse the list
+  without locks. Writers lock only the nodes next to the key they insert or
+  erase, so range scans never block writers and writers to different parts of
+  the key space do not block each other.
+
+  SkipList {
+    Node {
+      std::pair<const Key, const Value> item
+      std::atomic<Node*> next[level]
+      std::mutex mutex
+      std::atomic<bool> marked, fully_linked
+    } head
+  }
+
+  Usage:
+
+  SkipList<int, std::string> map;
+
+  map.insert(1, "one");
+  map.insert(3, "three");
+
+  assert(map.find(1) == "one");
+
+  // Visit the keys in [1, 3) in order.
+  map.for_each(1, 3, [](const int& key, const std::string& value) {
+    // ...
+  });
+
+  map.erase(1);
+
+  References:
+
+  Maurice Herlihy, Yossi Lev, Victor Luchangco, Nir Shavit, A Simple Optimistic
+  Skiplist Algorithm, SIROCCO 2007.
+*/
+#ifndef LOCKABLES_SKIP_LIST_HPP_
+#define LOCKABLES_SKIP_LIST_HPP_
+
+#include <lockables/epoch.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace lockables {
+
+/**
+  SkipList<Key, Value> is the lazy skip list. Each node has a lock, a marked
+  flag (logically deleted), and a fully linked flag (logically inserted).
+  Writers find the predecessors of a key without locks, lock them, validate
+  that they are still adjacent, and then link or unlink the node. Readers
+  never lock and never retry.
+
+  Values are immutable once inserted. To update a key, erase it and insert it
+  again. All of the accessors return copies, or pass const references to a
+  callback, so Key and Value must be copy constructible.
+
+  Nodes that are erased are retired to an EpochDomain and freed once no
+  operation that may have seen them is still running.
+*/
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+class SkipList {
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<const Key, const Value>;
+
+  static constexpr int kMaxLevel = 24;
+
+  SkipList() = default;
+
+  // Rule of 5. No copy or move.
+  SkipList(const SkipList&) = delete;
+  SkipList(SkipList&&) noexcept = delete;
+  SkipList& operator=(const SkipList&) = delete;
+  SkipList& operator=(SkipList&&) noexcept = delete;
+  ~SkipList();
+
+  /**
+    Insert key with value. Return false if the key is already present, in which
+    case the map is not modified.
+  */
+  template <typename V>
+  bool insert(const Key& key, V&& value);
+
+  /**
+    Remove key. Return true if it was found.
+  */
+  bool erase(const Key& key);
+
+  /**
+    Return a copy of the value for key, if found. Never locks.
+  */
+  [[nodiscard]] std::optional<Value> find(const Key& key) const;
+
+  [[nodiscard]] bool contains(const Key& key) const;
+
+  /**
+    Return a copy of the first item with a key that is not less than key, if
+    any. Never locks.
+  */
+  [[nodiscard]] std::optional<std::pair<Key, Value>> lower_bound(
+      const Key& key) const;
+
+  /**
+    Call f(const Key&, const Value&) for each item with a key in [first, last),
+    in order. Never locks. Items inserted or erased during the scan may or may
+    not be visited.
+  */
+  template <typename F>
+  void for_each(const Key& first, const Key& last, F&& f) const;
+
+  /**
+    Call f(const Key&, const Value&) for every item, in order. Never locks.
+  */
+  template <typename F>
+  void for_each(F&& f) const;
+
+  /**
+    Number of items. May be stale if there are concurrent writers.
+  */
+  [[nodiscard]] std::size_t size() const noexcept {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+ private:
+  struct Node {
+    // Head node. Has no item and links at every level.
+    Node()
+        : top_level{kMaxLevel - 1}, next{new std::atomic<Node*>[kMaxLevel]} {
+      for (int level = 0; level < kMaxLevel; ++level) {
+        link(level).store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    template <typename V>
+    Node(int level, const Key& key, V&& value)
+        : item{std::in_place, key, std::forward<V>(value)},
+          top_level{level},
+          next{new std::atomic<Node*>[static_cast<std::size_t>(level) + 1]} {}
+
+    [[nodiscard]] const Key& key() const noexcept { return item->first; }
+
+    [[nodiscard]] std::atomic<Node*>& link(int level) const noexcept {
+      return next[static_cast<std::size_t>(level)];
+    }
+
+    std::optional<value_type> item{};
+    int top_level;
+    std::unique_ptr<std::atomic<Node*>[]> next;
+    std::mutex mutex{};
+    std::atomic<bool> marked{};
+    std::atomic<bool> fully_linked{};
+  };
+
+  using Path = Node*[kMaxLevel];
+
+  static void delete_node(void* ptr) { delete static_cast<Node*>(ptr); }
+
+  static int random_level() noexcept;
+
+  // True if node is before key. The end of the list is after every key.
+  [[nodiscard]] bool before(const Node* node, const Key& key) const {
+    return node != nullptr && less_(node->key(), key);
+  }
+
+  // Fill in the predecessor and successor of key at every level. Return the
+  // highest level where the successor has key, or -1.
+  int find_path(const Key& key, Path& preds, Path& succs) const;
+
+  // First node at level 0 with a key that is not less than key.
+  [[nodiscard]] Node* find_lower_bound(const Key& key) const;
+
+  [[nodiscard]] static bool is_live(const Node* node) noexcept {
+    return node->fully_linked.load(std::memory_order_acquire) &&
+           !node->marked.load(std::memory_order_acquire);
+  }
+
+  mutable Node head_{};
+  std::atomic<std::size_t> size_{};
+  Compare less_{};
+  mutable EpochDomain domain_{};
+};
+
+template <typename Key, typename Value, typename Compare>
+SkipList<Key, Value, Compare>::~SkipList() {
+  Node* node = head_.link(0).load(std::memory_order_relaxed);
+  while (node != nullptr) {
+    Node* next = node->link(0).load(std::memory_order_relaxed);
+    delete node;
+    node = next;
+  }
+}
+
+template <typename Key, typename Value, typename Compare>
+int SkipList<Key, Value, Compare>::random_level() noexcept {
+  // Geometric distribution with p = 1/2. Use the trailing one bits of a
+  // per thread xorshift generator.
+  static thread_local std::uint64_t state =
+      std::hash<std::thread::id>{}(std::this_thread::get_id()) |
+      std::uint64_t{1};
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+
+  int level = 0;
+  for (auto bits = state; (bits & 1) != 0 && level < kMaxLevel - 1;
+       bits >>= 1) {
+    ++level;
+  }
+
+  return level;
+}
+
+template <typename Key, typename Value, typename Compare>
+int SkipList<Key, Value, Compare>::find_path(const Key& key, Path& preds,
+                                             Path& succs) const {
+  int found = -1;
+  Node* pred = &head_;
+  for (int level = kMaxLevel - 1; level >= 0; --level) {
+    Node* curr = pred->link(level).load(std::memory_order_acquire);
+    while (before(curr, key)) {
+      pred = curr;
+      curr = pred->link(level).load(std::memory_order_acquire);
+    }
+
+    if (found == -1 && curr != nullptr && !less_(key, curr->key())) {
+      found = level;
+    }
+
+    preds[level] = pred;
+    succs[level] = curr;
+  }
+
+  return found;
+}
+
+template <typename Key, typename Value, typename Compare>
+auto SkipList<Key, Value, Compare>::find_lower_bound(const Key& key) const
+    -> Node* {
+  Node* pred = &head_;
+  Node* curr = nullptr;
+  for (int level = kMaxLevel - 1; level >= 0; --level) {
+    curr = pred->link(level).load(std::memory_order_acquire);
+    while (before(curr, key)) {
+      pred = curr;
+      curr = pred->link(level).load(std::memory_order_acquire);
+    }
+  }
+
+  return curr;
+}
+
+template <typename Key, typename Value, typename Compare>
+template <typename V>
+bool SkipList<Key, Value, Compare>::insert(const Key& key, V&& value) {
+  const int top_level = random_level();
+  Path preds;
+  Path succs;
+
+  const auto pin = domain_.pin();
+  for (;;) {
+    const int found = find_path(key, preds, succs);
+    if (found != -1) {
+      const Node* node = succs[found];
+      if (!node->marked.load(std::memory_order_acquire)) {
+        // Present, or about to be. Wait so that a false return means the key
+        // is visible to the caller.
+        while (!node->fully_linked.load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+        return false;
+      }
+
+      // Being erased. Try again once it is unlinked.
+      continue;
+    }
+
+    // Lock the predecessors bottom up. Skip repeats, the same node is often
+    // the predecessor at several levels.
+    std::unique_lock<std::mutex> locks[kMaxLevel];
+    const Node* locked = nullptr;
+    bool valid = true;
+    for (int level = 0; valid && level <= top_level; ++level) {
+      Node* pred = preds[level];
+      const Node* succ = succs[level];
+      if (pred != locked) {
+        locks[level] = std::unique_lock{pred->mutex};
+        locked = pred;
+      }
+
+      valid = !pred->marked.load(std::memory_order_acquire) &&
+              (succ == nullptr ||
+               !succ->marked.load(std::memory_order_acquire)) &&
+              pred->link(level).load(std::memory_order_acquire) == succ;
+    }
+
+    if (!valid) {
+      continue;
+    }
+
+    auto* node = new Node{top_level, key, std::forward<V>(value)};
+    for (int level = 0; level <= top_level; ++level) {
+      node->link(level).store(succs[level], std::memory_order_relaxed);
+    }
+    for (int level = 0; level <= top_level; ++level) {
+      preds[level]->link(level).store(node, std::memory_order_release);
+    }
+
+    node->fully_linked.store(true, std::memory_order_release);
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+}
+
+template <typename Key, typename Value, typename Compare>
+bool SkipList<Key, Value, Compare>::erase(const Key& key) {
+  Node* victim = nullptr;
+  std::unique_lock<std::mutex> victim_lock;
+  Path preds;
+  Path succs;
+
+  const auto pin = domain_.pin();
+  for (;;) {
+    const int found = find_path(key, preds, succs);
+
+    if (!victim_lock) {
+      // Only erase a node that is fully linked, and found at its top level so
+      // that find_path saw all of its predecessors.
+      if (found == -1) {
+        return false;
+      }
+
+      victim = succs[found];
+      if (!victim->fully_linked.load(std::memory_order_acquire) ||
+          victim->top_level != found ||
+          victim->marked.load(std::memory_order_acquire)) {
+        return false;
+      }
+
+      victim_lock = std::unique_lock{victim->mutex};
+      if (victim->marked.load(std::memory_order_relaxed)) {
+        // Another writer erased it first.
+        return false;
+      }
+
+      // Logically deleted. Readers skip it from now on.
+      victim->marked.store(true, std::memory_order_release);
+    }
+
+    std::unique_lock<std::mutex> locks[kMaxLevel];
+    const Node* locked = nullptr;
+    bool valid = true;
+    for (int level = 0; valid && level <= victim->top_level; ++level) {
+      Node* pred = preds[level];
+      if (pred != locked) {
+        locks[level] = std::unique_lock{pred->mutex};
+        locked = pred;
+      }
+
+      valid = !pred->marked.load(std::memory_order_acquire) &&
+              pred->link(level).load(std::memory_order_acquire) == victim;
+    }
+
+    if (!valid) {
+      continue;
+    }
+
+    // Unlink top down so the node never appears at a level above one where it
+    // is missing.
+    for (int level = victim->top_level; level >= 0; --level) {
+      preds[level]->link(level).store(
+          victim->link(level).load(std::memory_order_relaxed),
+          std::memory_order_release);
+    }
+
+    victim_lock.unlock();
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    domain_.retire(victim, &delete_node);
+    return true;
+  }
+}
+
+template <typename Key, typename Value, typename Compare>
+auto SkipList<Key, Value, Compare>::find(const Key& key) const
+    -> std::optional<Value> {
+  const auto pin = domain_.pin();
+
+  const Node* node = find_lower_bound(key);
+  if (node == nullptr || less_(key, node->key()) || !is_live(node)) {
+    return std::nullopt;
+  }
+
+  return node->item->second;
+}
+
+template <typename Key, typename Value, typename Compare>
+bool SkipList<Key, Value, Compare>::contains(const Key& key) const {
+  const auto pin = domain_.pin();
+
+  const Node* node = find_lower_bound(key);
+  return node != nullptr && !less_(key, node->key()) && is_live(node);
+}
+
+template <typename Key, typename Value, typename Compare>
+auto SkipList<Key, Value, Compare>::lower_bound(const Key& key) const
+    -> std::optional<std::pair<Key, Value>> {
+  const auto pin = domain_.pin();
+
+  // Marked nodes keep their next pointers, so keep walking past them.
+  for (const Node* node = find_lower_bound(key); node != nullptr;
+       node = node->link(0).load(std::memory_order_acquire)) {
+    if (is_live(node)) {
+      return std::pair<Key, Value>{node->item->first, node->item->second};
+    }
+  }
+
+  return std::nullopt;
+}
+
+template <typename Key, typename Value, typename Compare>
+template <typename F>
+void SkipList<Key, Value, Compare>::for_each(const Key& first,
+                                             const Key& last, F&& f) const {
+  const auto pin = domain_.pin();
+
+  for (const Node* node = find_lower_bound(first);
+       node != nullptr && less_(node->key(), last);
+       node = node->link(0).load(std::memory_order_acquire)) {
+    if (is_live(node)) {
+      std::invoke(f, node->item->first, node->item->second);
+    }
+  }
+}
+
+template <typename Key, typename Value, typename Compare>
+template <typename F>
+void SkipList<Key, Value, Compare>::for_each(F&& f) const {
+  const auto pin = domain_.pin();
+
+  for (const Node* node = head_.link(0).load(std::memory_order_acquire);
+       node != nullptr; node = node->link(0).load(std::memory_order_acquire)) {
+    if (is_live(node)) {
+      std::invoke(f, node->item->first, node->item->second);
+    }
+  }
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_SKIP_LIST_HPP_
@@ -0,0 +1,195 @@
+//
+// lockables/snapshot.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  Snapshot<T> stores an immutable value that readers access without a lock.
+  Writers copy the current value, modify the copy, and publish it. Readers
+  that still hold the old value keep using it until they are done.
+
+  Snapshot {
+    std::atomic<T*> current
+    HazardDomain domain
+    std::mutex mutex  // writers only
+  }
+
+  Readers access the value using the pointer like SnapshotScope<T> object.
+
+  SnapshotScope {
+    HazardPointer hazard
+    const T* non_owning
+  }
+
+  Usage:
+
+  Snapshot<Config> config;
+
+  {
+    // Reader. Never blocks, the value does not change while guard is alive.
+    auto guard = config.with_shared();
+
+    connect(guard->host, guard->port);
+  }
+
+  // Writer. Modify a copy of the current value.
+  config.update([](Config& copy) { copy.port = 8080; });
+*/
+#ifndef LOCKABLES_SNAPSHOT_HPP_
+#define LOCKABLES_SNAPSHOT_HPP_
+
+#include <lockables/hazard_pointer.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace lockables {
+
+/**
+  Pointer like object that keeps one version of a Snapshot<T> value alive.
+*/
+template <typename T>
+class SnapshotScope;
+
+/**
+  Snapshot<T, Mutex> is a copy on write value. Readers load the current
+  version and protect it with a hazard pointer, they never lock and never
+  wait for writers. Writers are serialized by the mutex and replace the whole
+  value. The old version is retired to the hazard pointer domain and freed
+  once no reader holds it.
+
+  Use it for values that are read often and written rarely, where a reader
+  that stalls must not hold back reclamation of more than the one version
+  that it is reading.
+*/
+template <typename T, typename Mutex = std::mutex>
+class Snapshot {
+ public:
+  using value_type = T;
+
+  /**
+    Construct the first version of the value with arguments. Uses brace
+    initialization, same as Guarded<T>.
+  */
+  template <typename... Args>
+  explicit Snapshot(Args&&... args);
+
+  // Rule of 5. No copy or move.
+  Snapshot(const Snapshot&) = delete;
+  Snapshot(Snapshot&&) noexcept = delete;
+  Snapshot& operator=(const Snapshot&) = delete;
+  Snapshot& operator=(Snapshot&&) noexcept = delete;
+  ~Snapshot();
+
+  /**
+    Reader access to the current version. Lock free.
+  */
+  [[nodiscard]] SnapshotScope<T> with_shared() const;
+
+  /**
+    Return a copy of the current version.
+  */
+  [[nodiscard]] T load() const;
+
+  /**
+    Writer. Call f(T&) with a copy of the current version and publish the
+    copy. Returns the result of f. If f throws, nothing is published.
+  */
+  template <typename F>
+  auto update(F&& f) -> std::invoke_result_t<F, T&>;
+
+  /**
+    Writer. Replace the value.
+  */
+  void store(T value);
+
+ private:
+  void publish(std::unique_ptr<T> value);
+
+  mutable HazardDomain domain_{};
+  std::atomic<T*> current_;
+  Mutex mutex_{};
+};
+
+template <typename T>
+class SnapshotScope {
+ public:
+  using element_type = const T;
+  using pointer = const T*;
+  using reference = const T&;
+
+  SnapshotScope(HazardDomain& domain, const std::atomic<T*>& src)
+      : hazard_{domain}, non_owning_{hazard_.protect(src)} {}
+
+  // Rule of 5. No copy or move.
+  SnapshotScope(const SnapshotScope&) = delete;
+  SnapshotScope(SnapshotScope&&) noexcept = delete;
+  SnapshotScope& operator=(const SnapshotScope&) = delete;
+  SnapshotScope& operator=(SnapshotScope&&) noexcept = delete;
+  ~SnapshotScope() = default;
+
+  [[nodiscard]] pointer get() const noexcept { return non_owning_; }
+  [[nodiscard]] reference operator*() const noexcept { return *non_owning_; }
+  [[nodiscard]] pointer operator->() const noexcept { return non_owning_; }
+
+ private:
+  HazardPointer hazard_;
+  pointer non_owning_;
+};
+
+template <typename T, typename Mutex>
+template <typename... Args>
+Snapshot<T, Mutex>::Snapshot(Args&&... args)
+    : current_{new T{std::forward<Args>(args)...}} {}
+
+template <typename T, typename Mutex>
+Snapshot<T, Mutex>::~Snapshot() {
+  delete current_.load(std::memory_order_relaxed);
+}
+
+template <typename T, typename Mutex>
+SnapshotScope<T> Snapshot<T, Mutex>::with_shared() const {
+  return SnapshotScope<T>{domain_, current_};
+}
+
+template <typename T, typename Mutex>
+T Snapshot<T, Mutex>::load() const {
+  const auto guard = with_shared();
+  return *guard;
+}
+
+template <typename T, typename Mutex>
+template <typename F>
+auto Snapshot<T, Mutex>::update(F&& f) -> std::invoke_result_t<F, T&> {
+  std::scoped_lock lock{mutex_};
+  auto copy = std::make_unique<T>(*current_.load(std::memory_order_relaxed));
+  if constexpr (std::is_void_v<std::invoke_result_t<F, T&>>) {
+    std::invoke(std::forward<F>(f), *copy);
+    publish(std::move(copy));
+  } else {
+    auto result = std::invoke(std::forward<F>(f), *copy);
+    publish(std::move(copy));
+    return result;
+  }
+}
+
+template <typename T, typename Mutex>
+void Snapshot<T, Mutex>::store(T value) {
+  auto copy = std::make_unique<T>(std::move(value));
+  std::scoped_lock lock{mutex_};
+  publish(std::move(copy));
+}
+
+template <typename T, typename Mutex>
+void Snapshot<T, Mutex>::publish(std::unique_ptr<T> value) {
+  T* old = current_.exchange(value.release(), std::memory_order_acq_rel);
+  domain_.retire(old);
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_SNAPSHOT_HPP_
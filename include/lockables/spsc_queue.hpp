@@ -0,0 +1,288 @@
+//
+// lockables/spsc_queue.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  SpscQueue<T> is a bounded, single producer, single consumer queue. Every
+  operation is wait free. The producer and consumer each own one index and
+  keep a cached copy of the other, so they only share a cache line when the
+  queue looks full or empty.
+
+  SpscQueue {
+    T slots[capacity]
+    std::atomic<size_t> tail, size_t head_cache  // Producer
+    std::atomic<size_t> head, size_t tail_cache  // Consumer
+  }
+
+  Usage:
+
+  SpscQueue<Message> queue{1024};
+
+  // Producer thread. Fill in the next slot in place.
+  if (Message* slot = queue.reserve()) {
+    slot->id = 1;
+    queue.commit();
+  }
+
+  // Consumer thread. Read the front slot in place.
+  if (const Message* front = queue.peek()) {
+    assert(front->id == 1);
+    queue.release();
+  }
+*/
+#ifndef LOCKABLES_SPSC_QUEUE_HPP_
+#define LOCKABLES_SPSC_QUEUE_HPP_
+
+#include <lockables/cache_line.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace lockables {
+
+/**
+  SpscQueue<T> is a ring of capacity default constructed T slots, where the
+  capacity is a power of two. Slots are reused, not destroyed, so the zero copy
+  reserve() and peek() methods hand out pointers to live objects. The producer
+  overwrites a slot in place and the consumer reads it in place.
+
+  Exactly one thread may call the producer methods (reserve, commit, try_push,
+  try_push_n) and exactly one thread may call the consumer methods (peek,
+  release, try_pop, try_pop_n) at a time.
+*/
+template <typename T>
+class SpscQueue {
+ public:
+  using value_type = T;
+
+  static_assert(std::is_default_constructible_v<T>,
+                "SpscQueue requires default constructible T");
+
+  /**
+    Construct an empty queue with room for at least capacity elements.
+  */
+  explicit SpscQueue(std::size_t capacity);
+
+  // Rule of 5. No copy or move.
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue(SpscQueue&&) noexcept = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+  SpscQueue& operator=(SpscQueue&&) noexcept = delete;
+  ~SpscQueue() = default;
+
+  /**
+    Producer. Return a pointer to the next free slot, or nullptr if full. The
+    slot holds whatever element was there one lap ago. Call commit() to publish
+    it to the consumer.
+  */
+  [[nodiscard]] T* reserve() noexcept;
+
+  /**
+    Producer. Publish the slot returned by the last call to reserve().
+  */
+  void commit() noexcept;
+
+  /**
+    Consumer. Return a pointer to the front element, or nullptr if empty. Call
+    release() to hand the slot back to the producer.
+  */
+  [[nodiscard]] T* peek() noexcept;
+
+  /**
+    Consumer. Remove the element returned by the last call to peek().
+  */
+  void release() noexcept;
+
+  /**
+    Producer. Assign value to the next slot. Return false if full.
+  */
+  template <typename U>
+  bool try_push(U&& value);
+
+  /**
+    Consumer. Move the front element into value. Return false if empty.
+  */
+  bool try_pop(T& value);
+
+  /**
+    Producer. Assign up to count elements from first. Return the number pushed.
+    Publishes the whole batch with one store.
+  */
+  template <typename InputIt>
+  std::size_t try_push_n(InputIt first, std::size_t count);
+
+  /**
+    Consumer. Move up to count elements into out. Return the number popped.
+    Releases the whole batch with one store.
+  */
+  template <typename OutputIt>
+  std::size_t try_pop_n(OutputIt out, std::size_t count);
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask_ + 1; }
+
+  /**
+    Approximate number of elements. Exact if called from the producer or
+    consumer thread while the other side is idle.
+  */
+  [[nodiscard]] std::size_t size_approx() const noexcept;
+
+ private:
+  // Producer. Number of free slots, refresh the cached head if needed.
+  std::size_t free_slots(std::size_t want) noexcept;
+
+  // Consumer. Number of full slots, refresh the cached tail if needed.
+  std::size_t full_slots(std::size_t want) noexcept;
+
+  std::size_t mask_;
+  std::unique_ptr<T[]> slots_;
+
+  // Written by the producer.
+  alignas(kCacheLineSize) std::atomic<std::size_t> tail_{};
+  std::size_t head_cache_{};
+
+  // Written by the consumer.
+  alignas(kCacheLineSize) std::atomic<std::size_t> head_{};
+  std::size_t tail_cache_{};
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(std::size_t capacity) : mask_{0} {
+  std::size_t size = 1;
+  while (size < capacity) {
+    size *= 2;
+  }
+
+  mask_ = size - 1;
+  slots_ = std::make_unique<T[]>(size);
+}
+
+template <typename T>
+std::size_t SpscQueue<T>::free_slots(std::size_t want) noexcept {
+  const auto tail = tail_.load(std::memory_order_relaxed);
+  auto free = capacity() - (tail - head_cache_);
+  if (free < want) {
+    // Only touch the consumer cache line when the cached copy says full.
+    head_cache_ = head_.load(std::memory_order_acquire);
+    free = capacity() - (tail - head_cache_);
+  }
+
+  return free;
+}
+
+template <typename T>
+std::size_t SpscQueue<T>::full_slots(std::size_t want) noexcept {
+  const auto head = head_.load(std::memory_order_relaxed);
+  auto full = tail_cache_ - head;
+  if (full < want) {
+    // Only touch the producer cache line when the cached copy says empty.
+    tail_cache_ = tail_.load(std::memory_order_acquire);
+    full = tail_cache_ - head;
+  }
+
+  return full;
+}
+
+template <typename T>
+T* SpscQueue<T>::reserve() noexcept {
+  if (free_slots(1) == 0) {
+    return nullptr;
+  }
+
+  return &slots_[tail_.load(std::memory_order_relaxed) & mask_];
+}
+
+template <typename T>
+void SpscQueue<T>::commit() noexcept {
+  tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+              std::memory_order_release);
+}
+
+template <typename T>
+T* SpscQueue<T>::peek() noexcept {
+  if (full_slots(1) == 0) {
+    return nullptr;
+  }
+
+  return &slots_[head_.load(std::memory_order_relaxed) & mask_];
+}
+
+template <typename T>
+void SpscQueue<T>::release() noexcept {
+  head_.store(head_.load(std::memory_order_relaxed) + 1,
+              std::memory_order_release);
+}
+
+template <typename T>
+template <typename U>
+bool SpscQueue<T>::try_push(U&& value) {
+  T* slot = reserve();
+  if (slot == nullptr) {
+    return false;
+  }
+
+  *slot = std::forward<U>(value);
+  commit();
+  return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::try_pop(T& value) {
+  T* front = peek();
+  if (front == nullptr) {
+    return false;
+  }
+
+  value = std::move(*front);
+  release();
+  return true;
+}
+
+template <typename T>
+template <typename InputIt>
+std::size_t SpscQueue<T>::try_push_n(InputIt first, std::size_t count) {
+  count = std::min(count, free_slots(count));
+
+  const auto tail = tail_.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < count; ++i, ++first) {
+    slots_[(tail + i) & mask_] = *first;
+  }
+
+  if (count > 0) {
+    tail_.store(tail + count, std::memory_order_release);
+  }
+
+  return count;
+}
+
+template <typename T>
+template <typename OutputIt>
+std::size_t SpscQueue<T>::try_pop_n(OutputIt out, std::size_t count) {
+  count = std::min(count, full_slots(count));
+
+  const auto head = head_.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < count; ++i, ++out) {
+    *out = std::move(slots_[(head + i) & mask_]);
+  }
+
+  if (count > 0) {
+    head_.store(head + count, std::memory_order_release);
+  }
+
+  return count;
+}
+
+template <typename T>
+std::size_t SpscQueue<T>::size_approx() const noexcept {
+  const auto head = head_.load(std::memory_order_acquire);
+  const auto tail = tail_.load(std::memory_order_acquire);
+  return tail >= head ? tail - head : 0;
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_SPSC_QUEUE_HPP_
@@ -0,0 +1,83 @@
+//
+// lockables/thread_annotations.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  Macros for the Clang Thread Safety Analysis. Build with -Wthread-safety to
+  check at compile time that data is only accessed while holding the mutex
+  that guards it. The macros expand to nothing on other compilers.
+
+  Usage:
+
+  AnnotatedMutex<std::mutex> mutex;
+  int balance LOCKABLES_GUARDED_BY(mutex) = 0;
+
+  void deposit(int amount) LOCKABLES_REQUIRES(mutex) { balance += amount; }
+
+  void withdraw(int amount) {
+    // warning: writing variable 'balance' requires holding mutex 'mutex'
+    balance -= amount;
+  }
+
+  References:
+
+  Clang Thread Safety Analysis
+  https://clang.llvm.org/docs/ThreadSafetyAnalysis.html
+*/
+#ifndef LOCKABLES_THREAD_ANNOTATIONS_HPP_
+#define LOCKABLES_THREAD_ANNOTATIONS_HPP_
+
+#if defined(__clang__)
+#define LOCKABLES_THREAD_ANNOTATION(x) __attribute__((x))
+#else
+#define LOCKABLES_THREAD_ANNOTATION(x)
+#endif
+
+// A class that is a capability, e.g., a mutex.
+#define LOCKABLES_CAPABILITY(x) LOCKABLES_THREAD_ANNOTATION(capability(x))
+
+// An RAII class that acquires a capability in its constructor and releases it
+// in its destructor.
+#define LOCKABLES_SCOPED_CAPABILITY LOCKABLES_THREAD_ANNOTATION(scoped_lockable)
+
+// Data members and globals that require a capability to read or write.
+#define LOCKABLES_GUARDED_BY(x) LOCKABLES_THREAD_ANNOTATION(guarded_by(x))
+#define LOCKABLES_PT_GUARDED_BY(x) LOCKABLES_THREAD_ANNOTATION(pt_guarded_by(x))
+
+// Functions that the caller must call while holding a capability.
+#define LOCKABLES_REQUIRES(...) \
+  LOCKABLES_THREAD_ANNOTATION(requires_capability(__VA_ARGS__))
+#define LOCKABLES_REQUIRES_SHARED(...) \
+  LOCKABLES_THREAD_ANNOTATION(requires_shared_capability(__VA_ARGS__))
+
+// Functions that the caller must not call while holding a capability.
+#define LOCKABLES_EXCLUDES(...) \
+  LOCKABLES_THREAD_ANNOTATION(locks_excluded(__VA_ARGS__))
+
+// Functions that acquire or release a capability.
+#define LOCKABLES_ACQUIRE(...) \
+  LOCKABLES_THREAD_ANNOTATION(acquire_capability(__VA_ARGS__))
+#define LOCKABLES_ACQUIRE_SHARED(...) \
+  LOCKABLES_THREAD_ANNOTATION(acquire_shared_capability(__VA_ARGS__))
+#define LOCKABLES_RELEASE(...) \
+  LOCKABLES_THREAD_ANNOTATION(release_capability(__VA_ARGS__))
+#define LOCKABLES_RELEASE_SHARED(...) \
+  LOCKABLES_THREAD_ANNOTATION(release_shared_capability(__VA_ARGS__))
+
+// Functions that try to acquire a capability and return a bool.
+#define LOCKABLES_TRY_ACQUIRE(...) \
+  LOCKABLES_THREAD_ANNOTATION(try_acquire_capability(__VA_ARGS__))
+#define LOCKABLES_TRY_ACQUIRE_SHARED(...) \
+  LOCKABLES_THREAD_ANNOTATION(try_acquire_shared_capability(__VA_ARGS__))
+
+// Functions that return a reference to a capability.
+#define LOCKABLES_RETURN_CAPABILITY(x) \
+  LOCKABLES_THREAD_ANNOTATION(lock_returned(x))
+
+// Turn off the analysis in the body of a function. Its annotations are still
+// checked at call sites.
+#define LOCKABLES_NO_THREAD_SAFETY_ANALYSIS \
+  LOCKABLES_THREAD_ANNOTATION(no_thread_safety_analysis)
+
+#endif  // LOCKABLES_THREAD_ANNOTATIONS_HPP_
@@ -0,0 +1,224 @@
+//
+// lockables/thread_pool.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  ThreadPool is a fixed size pool of worker threads that run tasks from one
+  shared queue. Strand<Executor> runs tasks posted to it one at a time, in
+  order, on top of an executor like the ThreadPool.
+
+  ThreadPool {
+    std::deque<std::function<void()>> queue
+    std::vector<std::thread> workers
+  }
+
+  Usage:
+
+  ThreadPool pool{4};
+
+  pool.post([]() {
+    // Runs on one of the 4 worker threads.
+  });
+
+  Strand<ThreadPool> strand{pool};
+
+  strand.post([]() {
+    // Runs on a worker thread. Never at the same time as other tasks posted
+    // to this strand.
+  });
+*/
+#ifndef LOCKABLES_THREAD_POOL_HPP_
+#define LOCKABLES_THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lockables {
+
+/**
+  ThreadPool runs posted tasks on a fixed number of worker threads. The
+  destructor runs all of the queued tasks, including the tasks they post, and
+  then joins the workers.
+
+  Tasks must not throw.
+*/
+class ThreadPool {
+ public:
+  /**
+    Start num_thread workers. Defaults to the number of hardware threads.
+  */
+  explicit ThreadPool(std::size_t num_thread = default_num_thread());
+
+  // Rule of 5. No copy or move.
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) noexcept = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+  ~ThreadPool();
+
+  /**
+    Queue a task to run on one of the worker threads. Never blocks on the task.
+  */
+  void post(std::function<void()> task);
+
+  [[nodiscard]] std::size_t size() const noexcept { return workers_.size(); }
+
+  [[nodiscard]] static std::size_t default_num_thread() noexcept {
+    return std::max(std::thread::hardware_concurrency(), 1U);
+  }
+
+ private:
+  void run();
+
+  std::mutex mutex_{};
+  std::condition_variable cv_{};
+  std::deque<std::function<void()>> queue_{};
+  bool stop_{};
+  std::vector<std::thread> workers_{};
+};
+
+inline ThreadPool::ThreadPool(std::size_t num_thread) {
+  workers_.reserve(num_thread);
+  for (std::size_t i = 0; i < num_thread; ++i) {
+    workers_.emplace_back([this]() { run(); });
+  }
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::scoped_lock lock{mutex_};
+    stop_ = true;
+  }
+  cv_.notify_all();
+
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+inline void ThreadPool::post(std::function<void()> task) {
+  {
+    std::scoped_lock lock{mutex_};
+    queue_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+inline void ThreadPool::run() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock{mutex_};
+      cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+
+      task = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    task();
+  }
+}
+
+/**
+  Strand<Executor> is a serial executor. Tasks run one at a time, in the order
+  they were queued, on the threads of the underlying Executor. The Executor
+  must have a post(std::function<void()>) method.
+
+  A strand acts like an asynchronous mutex. The acquire() method queues a
+  callback that is posted to the executor when the strand is free. The strand
+  stays busy until the owner calls release(). Nobody blocks a thread while
+  waiting for a strand.
+
+  The strand must outlive all of the tasks posted to it, including the call to
+  release() that follows each task.
+*/
+template <typename Executor = ThreadPool>
+class Strand {
+ public:
+  explicit Strand(Executor& executor) : executor_{executor} {}
+
+  // Rule of 5. No copy or move.
+  Strand(const Strand&) = delete;
+  Strand(Strand&&) noexcept = delete;
+  Strand& operator=(const Strand&) = delete;
+  Strand& operator=(Strand&&) noexcept = delete;
+  ~Strand() = default;
+
+  /**
+    Run task on the executor after all of the previously queued tasks on this
+    strand have completed.
+  */
+  void post(std::function<void()> task);
+
+  /**
+    Post on_acquired to the executor once this strand is free. The strand is
+    owned by the callback until release() is called.
+  */
+  void acquire(std::function<void()> on_acquired);
+
+  /**
+    Hand the strand over to the next queued callback, if any.
+  */
+  void release();
+
+ private:
+  Executor& executor_;
+  std::mutex mutex_{};
+  std::deque<std::function<void()>> queue_{};
+  bool busy_{};
+};
+
+template <typename Executor>
+void Strand<Executor>::post(std::function<void()> task) {
+  acquire([this, task = std::move(task)]() {
+    task();
+    release();
+  });
+}
+
+template <typename Executor>
+void Strand<Executor>::acquire(std::function<void()> on_acquired) {
+  {
+    std::scoped_lock lock{mutex_};
+    if (busy_) {
+      queue_.push_back(std::move(on_acquired));
+      return;
+    }
+
+    busy_ = true;
+  }
+
+  executor_.post(std::move(on_acquired));
+}
+
+template <typename Executor>
+void Strand<Executor>::release() {
+  std::function<void()> next;
+  {
+    std::scoped_lock lock{mutex_};
+    if (queue_.empty()) {
+      busy_ = false;
+      return;
+    }
+
+    next = std::move(queue_.front());
+    queue_.pop_front();
+  }
+
+  executor_.post(std::move(next));
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_THREAD_POOL_HPP_
@@ -0,0 +1,299 @@
+//
+// lockables/thread_records.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  Per thread records shared by the InstrumentedMutex counters, the
+  EpochDomain, and the ObjectPool. Each thread that uses an owner object gets
+  its own record in it, so the hot path only writes to memory that no other
+  thread writes.
+
+  ThreadRecords<Owner> {
+    Guarded<unordered_map<uint64_t, Owner*>> registry  // live owners by id
+    Guarded<vector<size_t>> free_slots  // slots of destroyed owners
+    thread_local {
+      vector<pair<uint64_t, Record*>> records  // indexed by owner slot
+    }
+  }
+
+  RecordList<Record> {
+    Record* head  // lock free list, records are never removed
+  }
+
+  Usage:
+
+  class Owner {
+   public:
+    struct Record {
+      std::atomic<bool> in_use{};
+      Record* next{};
+      // ...
+    };
+
+    Owner()
+        : id_{ThreadRecords<Owner>::next_id()},
+          slot_{ThreadRecords<Owner>::acquire_slot()} {
+      ThreadRecords<Owner>::registry().with_exclusive()->emplace(id_, this);
+    }
+
+    ~Owner() {
+      ThreadRecords<Owner>::registry().with_exclusive()->erase(id_);
+      ThreadRecords<Owner>::release_slot(slot_);
+    }
+
+    Record& local() {
+      return ThreadRecords<Owner>::local(id_, slot_, records_);
+    }
+
+   private:
+    friend class ThreadRecords<Owner>;
+
+    // Called on thread exit, before the record is handed back.
+    void release_record(Record& record);
+
+    std::uint64_t id_;
+    std::size_t slot_;
+    RecordList<Record> records_{};
+  };
+*/
+#ifndef LOCKABLES_THREAD_RECORDS_HPP_
+#define LOCKABLES_THREAD_RECORDS_HPP_
+
+#include <lockables/guarded.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lockables {
+
+namespace detail {
+
+/**
+  Lock free list of the records of one owner. A Record has an
+  std::atomic<bool> in_use flag and a Record* next member. Records are only
+  added, a record that a thread hands back on exit is reused by the next
+  thread that needs one. The destructor deletes all of them.
+*/
+template <typename Record>
+class RecordList {
+ public:
+  RecordList() = default;
+
+  // Rule of 5. No copy or move.
+  RecordList(const RecordList&) = delete;
+  RecordList(RecordList&&) noexcept = delete;
+  RecordList& operator=(const RecordList&) = delete;
+  RecordList& operator=(RecordList&&) noexcept = delete;
+  ~RecordList();
+
+  [[nodiscard]] Record* head() const noexcept {
+    return head_.load(std::memory_order_acquire);
+  }
+
+  /**
+    A record that no thread uses. Take over the record of a thread that has
+    exited, or add a new one.
+  */
+  Record& acquire();
+
+ private:
+  std::atomic<Record*> head_{};
+};
+
+/**
+  ThreadRecords<Owner> finds the record of the calling thread in an Owner
+  object. Each live owner has a dense slot index, and a thread keeps a thread
+  local array of its records indexed by slot, so the lookup is one load and
+  one compare. A slot is reused by a later owner, so each entry also stores
+  the unique id of the owner it belongs to. An entry with another id is stale
+  and is replaced on first use.
+
+  On thread exit, the records of the owners that are still alive are handed
+  back. The registry lock is held while an exiting thread calls
+  Owner::release_record(), so an owner that erases itself from the registry
+  first waits for those threads. Release the slot after that.
+*/
+template <typename Owner>
+class ThreadRecords {
+ public:
+  using record_type = typename Owner::Record;
+  using Registry =
+      Guarded<std::unordered_map<std::uint64_t, Owner*>, std::shared_mutex>;
+
+  ThreadRecords() = delete;
+
+  /**
+    Owners that are still alive, by id. Never destroyed, an owner with static
+    storage duration may outlive it otherwise.
+  */
+  static Registry& registry() {
+    static auto& registry = *new Registry{};
+    return registry;
+  }
+
+  /**
+    Unique id for a new owner.
+  */
+  static std::uint64_t next_id() noexcept {
+    static std::atomic<std::uint64_t> id{};
+    return id.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  /**
+    Slot index for a new owner. Slots of destroyed owners are reused, so the
+    largest slot is about the largest number of owners alive at once.
+  */
+  static std::size_t acquire_slot();
+
+  /**
+    Give back the slot of an owner that is no longer in the registry.
+  */
+  static void release_slot(std::size_t slot) noexcept;
+
+  /**
+    The record of the calling thread in the owner with id and slot. Acquire
+    one from records on first use.
+  */
+  static record_type& local(std::uint64_t id, std::size_t slot,
+                            RecordList<record_type>& records) {
+    auto& entries = local_records().records;
+    if (slot < entries.size() && entries[slot].first == id) {
+      return *entries[slot].second;
+    }
+
+    return add_local(id, slot, records);
+  }
+
+ private:
+  struct Slots {
+    std::vector<std::size_t> free{};
+    std::size_t next{};
+  };
+
+  struct LocalRecords {
+    // Indexed by slot. The id is zero for an unused entry.
+    std::vector<std::pair<std::uint64_t, record_type*>> records{};
+
+    // Rule of 5. No copy or move.
+    LocalRecords() = default;
+    LocalRecords(const LocalRecords&) = delete;
+    LocalRecords(LocalRecords&&) noexcept = delete;
+    LocalRecords& operator=(const LocalRecords&) = delete;
+    LocalRecords& operator=(LocalRecords&&) noexcept = delete;
+    ~LocalRecords();
+  };
+
+  static LocalRecords& local_records() {
+    static thread_local LocalRecords records{};
+    return records;
+  }
+
+  // Never destroyed, same as the registry.
+  static Guarded<Slots, std::mutex>& slots() {
+    static auto& slots = *new Guarded<Slots, std::mutex>{};
+    return slots;
+  }
+
+  // First use of the owner in slot on this thread.
+  static record_type& add_local(std::uint64_t id, std::size_t slot,
+                                RecordList<record_type>& records);
+};
+
+template <typename Record>
+RecordList<Record>::~RecordList() {
+  Record* record = head_.load(std::memory_order_acquire);
+  while (record != nullptr) {
+    Record* next = record->next;
+    delete record;
+    record = next;
+  }
+}
+
+template <typename Record>
+Record& RecordList<Record>::acquire() {
+  for (Record* record = head_.load(std::memory_order_acquire);
+       record != nullptr; record = record->next) {
+    if (!record->in_use.load(std::memory_order_relaxed) &&
+        !record->in_use.exchange(true, std::memory_order_acquire)) {
+      return *record;
+    }
+  }
+
+  auto* record = new Record{};
+  record->in_use.store(true, std::memory_order_relaxed);
+
+  Record* head = head_.load(std::memory_order_relaxed);
+  do {
+    record->next = head;
+  } while (!head_.compare_exchange_weak(
+      head, record, std::memory_order_release, std::memory_order_relaxed));
+
+  return *record;
+}
+
+template <typename Owner>
+ThreadRecords<Owner>::LocalRecords::~LocalRecords() {
+  const auto guard = registry().with_shared();
+  for (const auto& [id, record] : records) {
+    if (record == nullptr) {
+      continue;
+    }
+
+    const auto itr = guard->find(id);
+    if (itr == guard->end()) {
+      continue;
+    }
+
+    itr->second->release_record(*record);
+    record->in_use.store(false, std::memory_order_release);
+  }
+}
+
+template <typename Owner>
+std::size_t ThreadRecords<Owner>::acquire_slot() {
+  auto guard = slots().with_exclusive();
+  if (guard->free.empty()) {
+    return guard->next++;
+  }
+
+  const std::size_t slot = guard->free.back();
+  guard->free.pop_back();
+  return slot;
+}
+
+template <typename Owner>
+void ThreadRecords<Owner>::release_slot(std::size_t slot) noexcept {
+  // If there is no memory to keep the slot for reuse, leave a gap.
+  try {
+    slots().with_exclusive()->free.push_back(slot);
+  } catch (...) {
+  }
+}
+
+template <typename Owner>
+auto ThreadRecords<Owner>::add_local(std::uint64_t id, std::size_t slot,
+                                     RecordList<record_type>& records)
+    -> record_type& {
+  auto& entries = local_records().records;
+  if (slot >= entries.size()) {
+    entries.resize(slot + 1);
+  }
+
+  // A stale entry belongs to an owner that is gone, its record with it.
+  record_type& record = records.acquire();
+  entries[slot] = {id, &record};
+  return record;
+}
+
+}  // namespace detail
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_THREAD_RECORDS_HPP_
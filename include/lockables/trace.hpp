@@ -0,0 +1,107 @@
+//
+// lockables/trace.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  Optional Linux USDT probes on the lock path of GuardedScope<T>. Trace lock
+  wait and hold times in production with bpftrace or perf, no rebuild needed.
+
+  Define LOCKABLES_ENABLE_USDT to build the probes. Requires <sys/sdt.h>, a
+  header only part of SystemTap, e.g., the systemtap-sdt-dev package. A probe
+  is a single nop until a tracer attaches to it. Without the macro, or without
+  the header, there is no code at all.
+
+  Provider "lockables", probes and arguments:
+
+  lock_begin     (const void* value, const char* name, int shared)
+  lock_acquired  (const void* value, const char* name, int shared)
+  lock_release   (const void* value, int shared)
+
+  The value is the address of the guarded value, the first member of its
+  Guarded<T>. The name is from the name() method of the mutex, e.g., an
+  InstrumentedMutex with a LockName, or null. The shared flag is 1 for a
+  reader scope.
+
+  Usage:
+
+  # Build with the probes.
+  c++ -DLOCKABLES_ENABLE_USDT -o app app.cpp
+
+  # List the probes.
+  bpftrace -l 'usdt:./app:lockables:*'
+
+  # Wait and hold time histograms, see benchmarks/lock_wait.bt.
+  bpftrace benchmarks/lock_wait.bt -c ./app
+*/
+#ifndef LOCKABLES_TRACE_HPP_
+#define LOCKABLES_TRACE_HPP_
+
+#if defined(LOCKABLES_ENABLE_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define LOCKABLES_HAS_USDT 1
+#endif
+#endif
+
+#include <type_traits>
+#include <utility>
+
+namespace lockables {
+
+namespace detail {
+
+template <typename Mutex, typename = void>
+struct HasName : std::false_type {};
+
+template <typename Mutex>
+struct HasName<Mutex,
+               std::void_t<decltype(std::declval<const Mutex&>().name())>>
+    : std::true_type {};
+
+// Name of the mutex for the probes, or null.
+template <typename Mutex>
+const char* trace_name([[maybe_unused]] const Mutex& mutex) noexcept {
+  if constexpr (!HasName<Mutex>::value) {
+    return nullptr;
+  } else if constexpr (std::is_convertible_v<decltype(mutex.name()),
+                                             const char*>) {
+    return mutex.name();
+  } else {
+    return mutex.name().c_str();
+  }
+}
+
+// Fire lock_begin and return ptr, so a member initializer can call it before
+// the lock is constructed.
+template <typename T, typename Mutex>
+T* trace_lock_begin(T* ptr, [[maybe_unused]] const Mutex& mutex) noexcept {
+#if defined(LOCKABLES_HAS_USDT)
+  DTRACE_PROBE3(lockables, lock_begin, static_cast<const void*>(ptr),
+                trace_name(mutex), std::is_const_v<T> ? 1 : 0);
+#endif
+  return ptr;
+}
+
+template <typename T, typename Mutex>
+void trace_lock_acquired([[maybe_unused]] T* ptr,
+                         [[maybe_unused]] const Mutex& mutex) noexcept {
+#if defined(LOCKABLES_HAS_USDT)
+  DTRACE_PROBE3(lockables, lock_acquired, static_cast<const void*>(ptr),
+                trace_name(mutex), std::is_const_v<T> ? 1 : 0);
+#endif
+}
+
+template <typename T>
+void trace_lock_release([[maybe_unused]] T* ptr) noexcept {
+#if defined(LOCKABLES_HAS_USDT)
+  DTRACE_PROBE2(lockables, lock_release, static_cast<const void*>(ptr),
+                std::is_const_v<T> ? 1 : 0);
+#endif
+}
+
+}  // namespace detail
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_TRACE_HPP_
@@ -0,0 +1,177 @@
+//
+// lockables/triple_buffer.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  TripleBuffer<T> hands the latest value from one writer thread to one reader
+  thread. Neither side ever blocks or waits for the other. The writer fills
+  the back buffer and publishes it. The reader takes the freshest published
+  buffer. Intermediate values that the reader never saw are dropped.
+
+  TripleBuffer {
+    T buffers[3]                 // one per cache line
+    std::atomic<uint8_t> middle  // index | fresh bit
+    uint8_t back                 // Writer
+    uint8_t front                // Reader
+  }
+
+  Readers access the value using the pointer like TripleBufferScope<T> object.
+
+  TripleBufferScope {
+    const T* non_owning
+  }
+
+  Usage:
+
+  TripleBuffer<Frame> frames;
+
+  // Writer thread. Fill in the back buffer, then publish it.
+  frames.write([&](Frame& frame) { capture(frame); });
+  frames.publish();
+
+  // Reader thread. The freshest complete frame.
+  {
+    auto frame = frames.read();
+    render(*frame);
+  }
+*/
+#ifndef LOCKABLES_TRIPLE_BUFFER_HPP_
+#define LOCKABLES_TRIPLE_BUFFER_HPP_
+
+#include <lockables/cache_line.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace lockables {
+
+/**
+  Pointer like object for the front buffer of a TripleBuffer<T>.
+*/
+template <typename T>
+class TripleBufferScope;
+
+/**
+  TripleBuffer<T> owns three values of T. At any time the writer owns one,
+  the back buffer, and the reader owns one, the front buffer. The third, the
+  middle buffer, is the most recently published value. An atomic byte holds
+  the index of the middle buffer and a bit that is set if the reader has not
+  taken it yet.
+
+  The publish() method swaps the back buffer with the middle buffer and sets
+  the fresh bit, one atomic exchange. The read() method swaps the front buffer
+  with the middle buffer if the fresh bit is set, one atomic load and at most
+  one exchange. Both are wait free.
+
+  The back buffer is not a copy of the last published value. After publish()
+  it holds an older value, or the value the reader just released. The writer
+  should overwrite the whole value in every write().
+
+  Exactly one thread may call the writer methods (write, publish) and exactly
+  one thread may call the reader method (read) at a time.
+*/
+template <typename T>
+class TripleBuffer {
+ public:
+  using value_type = T;
+
+  /**
+    Construct all three buffers with arguments. Uses brace initialization,
+    same as Guarded<T>.
+  */
+  template <typename... Args>
+  explicit TripleBuffer(const Args&... args)
+      : buffers_{Buffer{T{args...}}, Buffer{T{args...}}, Buffer{T{args...}}} {}
+
+  // Rule of 5. No copy or move.
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer(TripleBuffer&&) noexcept = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(TripleBuffer&&) noexcept = delete;
+  ~TripleBuffer() = default;
+
+  /**
+    Writer. Call f(T&) with the back buffer. Returns the result of f. The
+    reader does not see the changes until publish().
+  */
+  template <typename F>
+  auto write(F&& f) -> std::invoke_result_t<F, T&> {
+    return std::invoke(std::forward<F>(f), buffers_[back_].value);
+  }
+
+  /**
+    Writer. Make the back buffer the latest value. Wait free.
+  */
+  void publish() noexcept {
+    const auto previous = middle_.exchange(
+        static_cast<std::uint8_t>(back_ | kFresh), std::memory_order_acq_rel);
+    back_ = static_cast<std::uint8_t>(previous & kIndexMask);
+  }
+
+  /**
+    Reader. Return the latest published value, or the same value as the last
+    call if nothing new was published. Wait free. The value is valid until
+    the next call to read().
+  */
+  [[nodiscard]] TripleBufferScope<T> read() noexcept {
+    if ((middle_.load(std::memory_order_relaxed) & kFresh) != 0) {
+      const auto previous =
+          middle_.exchange(front_, std::memory_order_acq_rel);
+      front_ = static_cast<std::uint8_t>(previous & kIndexMask);
+    }
+
+    return TripleBufferScope<T>{buffers_[front_].value};
+  }
+
+  /**
+    Reader. Return true if a value was published since the last read().
+  */
+  [[nodiscard]] bool has_fresh() const noexcept {
+    return (middle_.load(std::memory_order_relaxed) & kFresh) != 0;
+  }
+
+ private:
+  static constexpr std::uint8_t kIndexMask = 0x3;
+  static constexpr std::uint8_t kFresh = 0x4;
+
+  struct alignas(kCacheLineSize) Buffer {
+    T value;
+  };
+
+  Buffer buffers_[3];
+  alignas(kCacheLineSize) std::atomic<std::uint8_t> middle_{1};
+  alignas(kCacheLineSize) std::uint8_t back_{2};
+  alignas(kCacheLineSize) std::uint8_t front_{0};
+};
+
+template <typename T>
+class TripleBufferScope {
+ public:
+  using element_type = const T;
+  using pointer = const T*;
+  using reference = const T&;
+
+  explicit TripleBufferScope(const T& value) : non_owning_{&value} {}
+
+  // Rule of 5. No copy or move.
+  TripleBufferScope(const TripleBufferScope&) = delete;
+  TripleBufferScope(TripleBufferScope&&) noexcept = delete;
+  TripleBufferScope& operator=(const TripleBufferScope&) = delete;
+  TripleBufferScope& operator=(TripleBufferScope&&) noexcept = delete;
+  ~TripleBufferScope() = default;
+
+  [[nodiscard]] pointer get() const noexcept { return non_owning_; }
+  [[nodiscard]] reference operator*() const noexcept { return *non_owning_; }
+  [[nodiscard]] pointer operator->() const noexcept { return non_owning_; }
+
+ private:
+  pointer non_owning_;
+};
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_TRIPLE_BUFFER_HPP_
@@ -0,0 +1,248 @@
+//
+// lockables/work_stealing_deque.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  WorkStealingDeque<T> is the Chase-Lev deque. The owner thread pushes and pops
+  at the bottom like a stack. Any other thread may steal from the top. The
+  owner never contends with thieves unless the deque holds one element.
+
+  WorkStealingDeque {
+    std::atomic<int64_t> top
+    std::atomic<int64_t> bottom
+    std::atomic<Array*> array
+  }
+
+  Usage:
+
+  WorkStealingDeque<Task*> deque;
+
+  // Owner thread.
+  deque.push(task);
+  if (auto task = deque.pop()) {
+    (*task)->run();
+  }
+
+  // Any other thread.
+  if (auto task = deque.steal()) {
+    (*task)->run();
+  }
+
+  References:
+
+  Nhat Minh Le, Antoniu Pop, Albert Cohen, Francesco Zappa Nardelli, Correct
+  and Efficient Work-Stealing for Weak Memory Models, PPoPP 2013.
+*/
+#ifndef LOCKABLES_WORK_STEALING_DEQUE_HPP_
+#define LOCKABLES_WORK_STEALING_DEQUE_HPP_
+
+#include <lockables/cache_line.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lockables {
+
+/**
+  WorkStealingDeque<T> is an unbounded deque of T. The circular array doubles
+  when it is full. The owner keeps the old arrays until the deque is destroyed
+  since a thief may still be reading from one.
+
+  T must be trivially copyable and lock free as a std::atomic<T>, usually a
+  pointer to the task.
+
+  Only the owner thread may call push() and pop(). Any thread may call
+  steal().
+*/
+template <typename T>
+class WorkStealingDeque {
+ public:
+  using value_type = T;
+
+  static_assert(std::is_trivially_copyable_v<T> &&
+                    std::atomic<T>::is_always_lock_free,
+                "WorkStealingDeque requires trivially copyable T with a lock "
+                "free std::atomic<T>");
+
+  static constexpr std::size_t kDefaultCapacity = 64;
+
+  /**
+    Construct an empty deque. The initial capacity is rounded up to a power of
+    two.
+  */
+  explicit WorkStealingDeque(std::size_t capacity = kDefaultCapacity);
+
+  // Rule of 5. No copy or move.
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque(WorkStealingDeque&&) noexcept = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(WorkStealingDeque&&) noexcept = delete;
+  ~WorkStealingDeque() = default;
+
+  /**
+    Owner. Push value onto the bottom.
+  */
+  void push(T value);
+
+  /**
+    Owner. Pop the most recently pushed value from the bottom.
+  */
+  [[nodiscard]] std::optional<T> pop();
+
+  /**
+    Thief. Steal the least recently pushed value from the top. May return
+    empty if another thread won the race for the last value.
+  */
+  [[nodiscard]] std::optional<T> steal();
+
+  /**
+    Approximate number of values. May be stale if there are concurrent calls.
+  */
+  [[nodiscard]] std::size_t size_approx() const noexcept;
+
+  [[nodiscard]] bool empty_approx() const noexcept {
+    return size_approx() == 0;
+  }
+
+ private:
+  class Array {
+   public:
+    explicit Array(std::size_t capacity)
+        : mask_{capacity - 1},
+          values_{std::make_unique<std::atomic<T>[]>(capacity)} {}
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    [[nodiscard]] T get(std::int64_t index) const noexcept {
+      return values_[static_cast<std::size_t>(index) & mask_].load(
+          std::memory_order_relaxed);
+    }
+
+    void put(std::int64_t index, T value) noexcept {
+      values_[static_cast<std::size_t>(index) & mask_].store(
+          value, std::memory_order_relaxed);
+    }
+
+   private:
+    std::size_t mask_;
+    std::unique_ptr<std::atomic<T>[]> values_;
+  };
+
+  Array* grow(Array* array, std::int64_t top, std::int64_t bottom);
+
+  // Thieves write top, the owner writes bottom.
+  alignas(kCacheLineSize) std::atomic<std::int64_t> top_{};
+  alignas(kCacheLineSize) std::atomic<std::int64_t> bottom_{};
+  std::atomic<Array*> array_{};
+
+  // Owned by the owner thread. All arrays, the current one is at the back.
+  std::vector<std::unique_ptr<Array>> arrays_{};
+};
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(std::size_t capacity) {
+  std::size_t size = 1;
+  while (size < capacity) {
+    size *= 2;
+  }
+
+  arrays_.push_back(std::make_unique<Array>(size));
+  array_.store(arrays_.back().get(), std::memory_order_relaxed);
+}
+
+template <typename T>
+auto WorkStealingDeque<T>::grow(Array* array, std::int64_t top,
+                                std::int64_t bottom) -> Array* {
+  arrays_.push_back(std::make_unique<Array>(array->capacity() * 2));
+  Array* larger = arrays_.back().get();
+  for (auto i = top; i != bottom; ++i) {
+    larger->put(i, array->get(i));
+  }
+
+  // Thieves load the array after they read top and bottom. Publish the copied
+  // values with the pointer.
+  array_.store(larger, std::memory_order_release);
+  return larger;
+}
+
+template <typename T>
+void WorkStealingDeque<T>::push(T value) {
+  const auto bottom = bottom_.load(std::memory_order_relaxed);
+  const auto top = top_.load(std::memory_order_acquire);
+  Array* array = array_.load(std::memory_order_relaxed);
+  if (bottom - top > static_cast<std::int64_t>(array->capacity()) - 1) {
+    array = grow(array, top, bottom);
+  }
+
+  array->put(bottom, value);
+  std::atomic_thread_fence(std::memory_order_release);
+  bottom_.store(bottom + 1, std::memory_order_relaxed);
+}
+
+template <typename T>
+std::optional<T> WorkStealingDeque<T>::pop() {
+  const auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+  Array* array = array_.load(std::memory_order_relaxed);
+  bottom_.store(bottom, std::memory_order_relaxed);
+  // Order the claim on bottom before the read of top. Pairs with the fence in
+  // steal().
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto top = top_.load(std::memory_order_relaxed);
+
+  std::optional<T> result;
+  if (top <= bottom) {
+    result = array->get(bottom);
+    if (top == bottom) {
+      // Last value. Race the thieves for it.
+      if (!top_.compare_exchange_strong(top, top + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        result.reset();
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+  } else {
+    // Empty.
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  return result;
+}
+
+template <typename T>
+std::optional<T> WorkStealingDeque<T>::steal() {
+  auto top = top_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const auto bottom = bottom_.load(std::memory_order_acquire);
+  if (top >= bottom) {
+    return std::nullopt;
+  }
+
+  // The original uses consume. Acquire is what compilers generate anyway.
+  const Array* array = array_.load(std::memory_order_acquire);
+  T value = array->get(top);
+  if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                    std::memory_order_relaxed)) {
+    return std::nullopt;
+  }
+
+  return value;
+}
+
+template <typename T>
+std::size_t WorkStealingDeque<T>::size_approx() const noexcept {
+  const auto top = top_.load(std::memory_order_acquire);
+  const auto bottom = bottom_.load(std::memory_order_acquire);
+  return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_WORK_STEALING_DEQUE_HPP_
@@ -0,0 +1,347 @@
+//
+// lockables/work_stealing_pool.hpp
+//
+// Copyright 2023 Luke Tokheim
+//
+/**
+  WorkStealingPool is a fixed size pool of worker threads. Each worker owns a
+  WorkStealingDeque of tasks and steals from the other workers when it runs
+  out. Tasks posted from a worker go to the bottom of its own deque, so there
+  is no central queue for the workers to contend on.
+
+  WorkStealingPool {
+    WorkStealingDeque<Task*> deques[num_thread]
+    Guarded<std::deque<Task*>> injected
+    std::vector<std::thread> workers
+  }
+
+  Usage:
+
+  std::vector<Guarded<int>> values(1000);
+  WorkStealingPool pool;
+
+  // Update every value in parallel. Each value is locked by exactly one
+  // worker. Blocks until all of the callbacks have returned.
+  parallel_for_each_exclusive(pool, values, [](int& x) { x += 10; });
+*/
+#ifndef LOCKABLES_WORK_STEALING_POOL_HPP_
+#define LOCKABLES_WORK_STEALING_POOL_HPP_
+
+#include <lockables/cache_line.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/parking.hpp>
+#include <lockables/work_stealing_deque.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lockables {
+
+/**
+  WorkStealingPool runs posted tasks on a fixed number of worker threads. A
+  task posted from outside of the pool goes on a shared injection queue. A
+  task posted from one of the workers goes on that worker's own deque. Idle
+  workers steal from the top of the other deques, and sleep when there is
+  nothing left to steal.
+
+  The destructor runs all of the queued tasks, including the tasks they post,
+  and then joins the workers.
+
+  Tasks must not throw.
+*/
+class WorkStealingPool {
+ public:
+  using Task = std::function<void()>;
+
+  /**
+    Start num_thread workers. Defaults to the number of hardware threads.
+  */
+  explicit WorkStealingPool(std::size_t num_thread = default_num_thread());
+
+  // Rule of 5. No copy or move.
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool(WorkStealingPool&&) noexcept = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(WorkStealingPool&&) noexcept = delete;
+  ~WorkStealingPool();
+
+  /**
+    Queue a task to run on one of the worker threads. Never blocks on the task.
+  */
+  void post(Task task);
+
+  [[nodiscard]] std::size_t size() const noexcept { return threads_.size(); }
+
+  [[nodiscard]] static std::size_t default_num_thread() noexcept {
+    return std::max(std::thread::hardware_concurrency(), 1U);
+  }
+
+ private:
+  // Keep each deque on its own cache lines.
+  struct alignas(kCacheLineSize) Worker {
+    WorkStealingDeque<Task*> deque{};
+  };
+
+  // The pool and worker index of the calling thread, if it is a worker.
+  struct CurrentWorker {
+    const WorkStealingPool* pool;
+    std::size_t index;
+  };
+
+  static CurrentWorker& current() noexcept {
+    static thread_local CurrentWorker worker{};
+    return worker;
+  }
+
+  void run(std::size_t index);
+  Task* find_task(std::size_t index);
+  Task* pop_injected();
+  [[nodiscard]] bool has_task() const noexcept;
+
+  std::size_t num_worker_;
+  std::unique_ptr<Worker[]> workers_;
+  Guarded<std::deque<Task*>> injected_{};
+  std::atomic<std::size_t> num_injected_{};
+  std::atomic<bool> stop_{};
+  detail::Parking parking_{};
+  std::vector<std::thread> threads_{};
+};
+
+inline WorkStealingPool::WorkStealingPool(std::size_t num_thread)
+    : num_worker_{std::max<std::size_t>(num_thread, 1)},
+      workers_{std::make_unique<Worker[]>(num_worker_)} {
+  threads_.reserve(num_worker_);
+  for (std::size_t i = 0; i < num_worker_; ++i) {
+    threads_.emplace_back([this, i]() { run(i); });
+  }
+}
+
+inline WorkStealingPool::~WorkStealingPool() {
+  stop_.store(true, std::memory_order_release);
+  parking_.notify_all();
+
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+inline void WorkStealingPool::post(Task task) {
+  auto owned = std::make_unique<Task>(std::move(task));
+
+  const CurrentWorker& worker = current();
+  if (worker.pool == this) {
+    workers_[worker.index].deque.push(owned.release());
+  } else {
+    auto guard = injected_.with_exclusive();
+    guard->push_back(owned.get());
+    owned.release();
+    num_injected_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  parking_.notify_one();
+}
+
+inline void WorkStealingPool::run(std::size_t index) {
+  current() = CurrentWorker{this, index};
+
+  for (;;) {
+    if (Task* task = find_task(index)) {
+      std::unique_ptr<Task> owned{task};
+      (*owned)();
+      continue;
+    }
+
+    if (stop_.load(std::memory_order_acquire) && !has_task()) {
+      break;
+    }
+
+    parking_.wait([this]() {
+      return stop_.load(std::memory_order_relaxed) || has_task();
+    });
+  }
+
+  current() = CurrentWorker{};
+}
+
+inline auto WorkStealingPool::find_task(std::size_t index) -> Task* {
+  // Newest local task first, it is most likely to be in cache.
+  if (auto task = workers_[index].deque.pop()) {
+    return *task;
+  }
+
+  if (Task* task = pop_injected()) {
+    return task;
+  }
+
+  // Oldest task from the other workers. Start with the next worker so that
+  // thieves spread out.
+  for (std::size_t i = 1; i < num_worker_; ++i) {
+    auto& victim = workers_[(index + i) % num_worker_];
+    if (auto task = victim.deque.steal()) {
+      return *task;
+    }
+  }
+
+  return nullptr;
+}
+
+inline auto WorkStealingPool::pop_injected() -> Task* {
+  if (num_injected_.load(std::memory_order_relaxed) == 0) {
+    return nullptr;
+  }
+
+  auto guard = injected_.with_exclusive();
+  if (guard->empty()) {
+    return nullptr;
+  }
+
+  Task* task = guard->front();
+  guard->pop_front();
+  num_injected_.fetch_sub(1, std::memory_order_relaxed);
+  return task;
+}
+
+inline bool WorkStealingPool::has_task() const noexcept {
+  if (num_injected_.load(std::memory_order_relaxed) != 0) {
+    return true;
+  }
+
+  for (std::size_t i = 0; i < num_worker_; ++i) {
+    if (!workers_[i].deque.empty_approx()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+namespace detail {
+
+/**
+  State of one parallel_for_each_exclusive call. Splits the index range in
+  half, posts the upper half to the pool, and keeps the lower half, until the
+  piece is no larger than the grain size. Idle workers steal the large upper
+  halves first.
+*/
+template <typename Iterator, typename F>
+class ParallelForEachExclusive {
+ public:
+  ParallelForEachExclusive(WorkStealingPool& pool, Iterator first,
+                           std::size_t count, std::size_t grain, F& f)
+      : pool_{pool}, first_{first}, remaining_{count}, grain_{grain}, f_{f} {}
+
+  void run(std::size_t lo, std::size_t hi) {
+    while (hi - lo > grain_) {
+      const std::size_t mid = lo + (hi - lo) / 2;
+      pool_.post([this, mid, hi]() { run(mid, hi); });
+      hi = mid;
+    }
+
+    auto itr = std::next(first_, static_cast<difference_type>(lo));
+    for (std::size_t i = lo; i < hi; ++i, ++itr) {
+      try {
+        with_exclusive(f_, *itr);
+      } catch (...) {
+        std::scoped_lock lock{mutex_};
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+    }
+
+    const std::size_t num_done = hi - lo;
+    if (remaining_.fetch_sub(num_done, std::memory_order_acq_rel) == num_done) {
+      std::scoped_lock lock{mutex_};
+      done_ = true;
+      cv_.notify_all();
+    }
+  }
+
+  void wait() {
+    std::unique_lock lock{mutex_};
+    cv_.wait(lock, [this]() { return done_; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+ private:
+  using difference_type =
+      typename std::iterator_traits<Iterator>::difference_type;
+
+  WorkStealingPool& pool_;
+  Iterator first_;
+  std::atomic<std::size_t> remaining_;
+  std::size_t grain_;
+  F& f_;
+
+  std::mutex mutex_{};
+  std::condition_variable cv_{};
+  bool done_{};
+  std::exception_ptr error_{};
+};
+
+}  // namespace detail
+
+/**
+  The parallel_for_each_exclusive function calls f(T&) once for every
+  Guarded<T> in range, with exclusive access to that value, on the workers of
+  pool. Blocks until all of the callbacks have returned.
+
+  Each value is visited by exactly one task, so no two workers ever contend
+  for the same mutex. Contention only comes from other threads that lock the
+  same values.
+
+  The grain is the largest number of values that one task visits in a row.
+  Defaults to a size that makes about eight tasks per worker.
+
+  If a callback throws, the remaining values are still visited and the first
+  exception is rethrown to the caller.
+
+  Must not be called from a task running on the same pool.
+
+  Usage:
+
+  std::vector<Guarded<int>> values(1000);
+  WorkStealingPool pool;
+
+  parallel_for_each_exclusive(pool, values, [](int& x) { x += 10; });
+*/
+template <typename Range, typename F>
+void parallel_for_each_exclusive(WorkStealingPool& pool, Range& range, F&& f,
+                                 std::size_t grain = 0) {
+  using std::begin;
+  using std::end;
+  using iterator_type = decltype(begin(range));
+
+  const auto first = begin(range);
+  const auto count = static_cast<std::size_t>(std::distance(first, end(range)));
+  if (count == 0) {
+    return;
+  }
+
+  if (grain == 0) {
+    grain = std::max<std::size_t>(count / (pool.size() * 8), 1);
+  }
+
+  detail::ParallelForEachExclusive<iterator_type, std::remove_reference_t<F>>
+      op{pool, first, count, grain, f};
+  pool.post([&op, count]() { op.run(0, count); });
+  op.wait();
+}
+
+}  // namespace lockables
+
+#endif  // LOCKABLES_WORK_STEALING_POOL_HPP_
@@ -0,0 +1,96 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/annotated_mutex.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/owned_mutex.hpp>
+
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+
+namespace {
+
+class Account {
+ public:
+  void deposit(int amount) {
+    lockables::AnnotatedLock lock{mutex_};
+    balance_ += amount;
+  }
+
+  [[nodiscard]] int balance() const {
+    lockables::AnnotatedSharedLock lock{mutex_};
+    return balance_;
+  }
+
+ private:
+  mutable lockables::AnnotatedMutex<std::shared_mutex> mutex_;
+  int balance_ LOCKABLES_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace
+
+TEST_CASE("AnnotatedMutex example", "[lockables][AnnotatedMutex]") {
+  lockables::Guarded<int, lockables::AnnotatedMutex<std::mutex>> value{1};
+
+  {
+    auto guard = value.with_exclusive();
+    *guard += 10;
+  }
+
+  {
+    const auto guard = value.with_shared();
+    CHECK(*guard == 11);
+  }
+
+  Account account;
+  account.deposit(5);
+  account.deposit(10);
+  CHECK(account.balance() == 15);
+}
+
+TEST_CASE("AnnotatedMutex shared lock", "[lockables][AnnotatedMutex]") {
+  using Mutex = lockables::AnnotatedMutex<std::shared_mutex>;
+  using Exclusive = lockables::AnnotatedMutex<std::mutex>;
+
+  STATIC_REQUIRE(std::is_same_v<lockables::shared_lock_t<Mutex>,
+                                std::shared_lock<Mutex>>);
+  STATIC_REQUIRE(std::is_same_v<lockables::shared_lock_t<Exclusive>,
+                                std::scoped_lock<Exclusive>>);
+
+  lockables::Guarded<int, Mutex> value{2};
+
+  // Two readers at once.
+  const auto guard = value.with_shared();
+  const int copy = std::async(std::launch::async, [&value]() {
+                     return *value.with_shared();
+                   }).get();
+  CHECK(copy == *guard);
+}
+
+TEST_CASE("AnnotatedMutex try_lock", "[lockables][AnnotatedMutex]") {
+  lockables::AnnotatedMutex<std::shared_mutex> mutex;
+
+  REQUIRE(mutex.try_lock());
+  const bool locked = std::async(std::launch::async, [&mutex]() {
+                        return mutex.try_lock_shared();
+                      }).get();
+  CHECK(!locked);
+  mutex.unlock();
+
+  REQUIRE(mutex.try_lock_shared());
+  CHECK(!mutex.try_lock());
+  mutex.unlock_shared();
+}
+
+TEST_CASE("AnnotatedMutex wraps other mutex types",
+          "[lockables][AnnotatedMutex]") {
+  using lockables::LockName;
+  using Mutex = lockables::AnnotatedMutex<lockables::OwnedMutex<std::mutex>>;
+
+  lockables::Guarded<int, Mutex> value{LockName{"value"}, 3};
+
+  lockables::Guarded<int, Mutex> other{4};
+  lockables::with_exclusive([](int& x, int& y) { x += y; }, value, other);
+
+  CHECK(*value.with_shared() == 7);
+}
@@ -81,7 +81,9 @@ TEST_CASE("Anti-pattern: Deadlock with recursive guards",
 
   // Solution: A calling thread must not own the mutex prior to calling any of
   // the locking functions. To lock multiple values, use the with_exclusive
-  // function which always locks in the same order.
+  // function which always locks in the same order. Use OwnedMutex from
+  // lockables/owned_mutex.hpp to fail fast with std::system_error instead of a
+  // deadlock.
 }
 
 TEST_CASE("Anti-pattern: Deadlock with multiple guards",
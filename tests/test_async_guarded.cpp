@@ -0,0 +1,202 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/async_guarded.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Run the loop on multiple threads until all of the tasks are done.
+void run_threads(lockables::RunLoop& loop, std::size_t num_thread) {
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < num_thread; ++i) {
+    threads.emplace_back([&loop]() { loop.run(); });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+lockables::DetachedTask writer(lockables::RunLoop& loop,
+                               lockables::AsyncGuarded<int>& value,
+                               int num_iteration, std::atomic<int>& remaining) {
+  co_await loop.schedule();
+
+  for (int i = 0; i < num_iteration; ++i) {
+    auto guard = co_await value.async_exclusive(loop);
+    *guard += 1;
+  }
+
+  if (remaining.fetch_sub(1) == 1) {
+    loop.stop();
+  }
+}
+
+lockables::DetachedTask reader(lockables::RunLoop& loop,
+                               const lockables::AsyncGuarded<int>& value,
+                               std::atomic<int>& max_seen,
+                               std::atomic<int>& remaining) {
+  co_await loop.schedule();
+
+  {
+    const auto guard = co_await value.async_shared(loop);
+    int copy = max_seen.load();
+    while (copy < *guard && !max_seen.compare_exchange_weak(copy, *guard)) {
+    }
+  }
+
+  if (remaining.fetch_sub(1) == 1) {
+    loop.stop();
+  }
+}
+
+}  // namespace
+
+TEST_CASE("AsyncGuarded example", "[lockables][AsyncGuarded]") {
+  lockables::RunLoop loop;
+  lockables::AsyncGuarded<std::vector<int>> value{1, 2, 3, 4, 5};
+
+  // Lambda coroutines refer to their captures through the lambda object, so
+  // keep it alive until the coroutine is done.
+  int copy = 0;
+  const auto task = [&]() -> lockables::DetachedTask {
+    co_await loop.schedule();
+
+    // Reader with shared lock.
+    {
+      const auto guard = co_await value.async_shared();
+      if (!guard->empty()) {
+        copy = guard->back();
+      }
+    }
+
+    // Writer with exclusive lock.
+    {
+      auto guard = co_await value.async_exclusive();
+      guard->push_back(100);
+    }
+
+    loop.stop();
+  };
+
+  task();
+  loop.run();
+
+  CHECK(copy == 5);
+
+  const auto check = [&]() -> lockables::DetachedTask {
+    const auto guard = co_await value.async_shared();
+    copy = guard->back();
+  };
+
+  check();
+
+  CHECK(copy == 100);
+}
+
+TEST_CASE("AsyncSharedMutex", "[lockables][AsyncGuarded]") {
+  lockables::AsyncSharedMutex mutex;
+
+  // Multiple readers or one writer.
+  REQUIRE(mutex.try_lock_shared());
+  REQUIRE(mutex.try_lock_shared());
+  CHECK(!mutex.try_lock());
+  mutex.unlock_shared();
+  mutex.unlock_shared();
+
+  REQUIRE(mutex.try_lock());
+  CHECK(!mutex.try_lock());
+  CHECK(!mutex.try_lock_shared());
+  mutex.unlock();
+
+  CHECK(mutex.try_lock());
+  mutex.unlock();
+}
+
+TEST_CASE("AsyncGuarded suspends instead of blocking",
+          "[lockables][AsyncGuarded]") {
+  lockables::AsyncGuarded<int> value{0};
+
+  bool reader_done = false;
+  bool writer_done = false;
+
+  const auto reader_task = [&]() -> lockables::DetachedTask {
+    const auto guard = co_await value.async_shared();
+    CHECK(*guard == 2);
+    reader_done = true;
+  };
+
+  const auto writer_task = [&]() -> lockables::DetachedTask {
+    auto guard = co_await value.async_exclusive();
+    *guard += 1;
+    writer_done = true;
+  };
+
+  const auto outer_task = [&]() -> lockables::DetachedTask {
+    auto guard = co_await value.async_exclusive();
+
+    // Both coroutines suspend on the lock and return control to us.
+    reader_task();
+    writer_task();
+
+    CHECK(!reader_done);
+    CHECK(!writer_done);
+
+    *guard = 2;
+  };
+
+  // The unlock at the end of outer_task resumes the reader inline, then the
+  // reader unlock resumes the writer.
+  outer_task();
+
+  CHECK(reader_done);
+  CHECK(writer_done);
+
+  int copy = 0;
+  const auto check = [&]() -> lockables::DetachedTask {
+    const auto guard = co_await value.async_shared();
+    copy = *guard;
+  };
+
+  check();
+
+  CHECK(copy == 3);
+}
+
+TEST_CASE("AsyncGuarded many coroutines, multiple threads",
+          "[lockables][AsyncGuarded]") {
+  constexpr int kNumWriter = 500;
+  constexpr int kNumReader = 500;
+  constexpr int kNumIteration = 20;
+  const std::size_t num_thread =
+      std::clamp(std::thread::hardware_concurrency(), 2U, 8U);
+
+  lockables::RunLoop loop;
+  lockables::AsyncGuarded<int> value;
+  std::atomic<int> max_seen{0};
+  std::atomic<int> remaining{kNumWriter + kNumReader};
+
+  for (int i = 0; i < kNumWriter; ++i) {
+    writer(loop, value, kNumIteration, remaining);
+  }
+
+  for (int i = 0; i < kNumReader; ++i) {
+    reader(loop, value, max_seen, remaining);
+  }
+
+  run_threads(loop, num_thread);
+
+  int copy = 0;
+  const auto check = [&]() -> lockables::DetachedTask {
+    const auto guard = co_await value.async_shared();
+    copy = *guard;
+  };
+
+  check();
+
+  CHECK(copy == kNumWriter * kNumIteration);
+  CHECK(max_seen.load() <= copy);
+}
@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/concurrent_bitmap.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <optional>
+#include <vector>
+
+TEST_CASE("ConcurrentBitmap example", "[lockables][ConcurrentBitmap]") {
+  lockables::ConcurrentBitmap slots{1024};
+
+  // Find a clear bit and set it.
+  if (std::optional<std::size_t> slot = slots.allocate()) {
+    CHECK(slots.test(*slot));
+    CHECK(slots.count() == 1);
+
+    slots.reset(*slot);
+  }
+
+  CHECK(slots.count() == 0);
+}
+
+TEST_CASE("ConcurrentBitmap allocate until full",
+          "[lockables][ConcurrentBitmap]") {
+  // Not a multiple of the word size, and more than one summary word.
+  constexpr std::size_t kSize = 64 * 64 + 100;
+  lockables::ConcurrentBitmap bitmap{kSize};
+  CHECK(bitmap.size() == kSize);
+
+  std::vector<bool> seen(kSize);
+  for (std::size_t i = 0; i < kSize; ++i) {
+    const auto index = bitmap.allocate();
+    REQUIRE(index);
+    REQUIRE(*index < kSize);
+    CHECK(!seen[*index]);
+    seen[*index] = true;
+  }
+
+  CHECK(!bitmap.allocate());
+  CHECK(bitmap.count() == kSize);
+  CHECK(bitmap.find_first_zero() == lockables::ConcurrentBitmap::npos);
+
+  // Free one bit in a full word, it is the only one left.
+  CHECK(bitmap.reset(4000));
+  CHECK(!bitmap.reset(4000));
+  CHECK(bitmap.find_first_zero() == 4000);
+  CHECK(bitmap.allocate() == 4000);
+  CHECK(!bitmap.allocate());
+}
+
+TEST_CASE("ConcurrentBitmap ranges", "[lockables][ConcurrentBitmap]") {
+  lockables::ConcurrentBitmap bitmap{300};
+  CHECK(bitmap.set(3));
+  CHECK(!bitmap.set(3));
+  CHECK(bitmap.set(70));
+  CHECK(bitmap.set(299));
+
+  CHECK(bitmap.count() == 3);
+  CHECK(bitmap.count(4, 299) == 1);
+  CHECK(bitmap.count(3, 4) == 1);
+  CHECK(bitmap.count(10, 10) == 0);
+
+  CHECK(bitmap.find_first_zero() == 0);
+  CHECK(bitmap.find_first_zero(3, 300) == 4);
+  CHECK(bitmap.find_first_zero(299, 300) == lockables::ConcurrentBitmap::npos);
+
+  for (std::size_t i = 64; i < 128; ++i) {
+    bitmap.set(i);
+  }
+  CHECK(bitmap.find_first_zero(64, 300) == 128);
+
+  lockables::ConcurrentBitmap empty{0};
+  CHECK(!empty.allocate());
+  CHECK(empty.count() == 0);
+}
+
+TEST_CASE("ConcurrentBitmap threads", "[lockables][ConcurrentBitmap]") {
+  constexpr std::size_t kNumThread = 4;
+  constexpr std::size_t kSize = 10000;
+  lockables::ConcurrentBitmap bitmap{kSize};
+
+  // Each thread allocates and frees bits. At the end every thread keeps what
+  // it has, every bit must belong to exactly one thread.
+  std::vector<std::future<std::vector<std::size_t>>> futures;
+  for (std::size_t i = 0; i < kNumThread; ++i) {
+    futures.push_back(std::async(std::launch::async, [&bitmap]() {
+      std::vector<std::size_t> held;
+      for (std::size_t n = 0; n < kSize; ++n) {
+        if (const auto index = bitmap.allocate()) {
+          held.push_back(*index);
+        }
+
+        if (n % 3 == 0 && !held.empty()) {
+          bitmap.reset(held.back());
+          held.pop_back();
+        }
+      }
+
+      return held;
+    }));
+  }
+
+  std::vector<std::size_t> all;
+  for (auto& future : futures) {
+    auto held = future.get();
+    all.insert(all.end(), held.begin(), held.end());
+  }
+
+  std::sort(all.begin(), all.end());
+  CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+  CHECK(bitmap.count() == all.size());
+}
@@ -0,0 +1,106 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/concurrent_vector.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("ConcurrentVector example", "[lockables][ConcurrentVector]") {
+  lockables::ConcurrentVector<int> events;
+
+  // Writer threads.
+  CHECK(events.push_back(1) == 0);
+  CHECK(events.push_back(2) == 1);
+
+  // Reader threads.
+  int sum = 0;
+  for (const int& event : events) {
+    sum += event;
+  }
+
+  CHECK(sum == 3);
+  CHECK(events.size() == 2);
+}
+
+TEST_CASE("ConcurrentVector stable addresses",
+          "[lockables][ConcurrentVector]") {
+  lockables::ConcurrentVector<std::string> vector;
+  CHECK(vector.empty());
+  CHECK_THROWS_AS(vector.at(0), std::out_of_range);
+
+  vector.emplace_back("first");
+  const std::string* first = &vector[0];
+
+  // Grow through several segments.
+  constexpr std::size_t kNumItem = 10000;
+  for (std::size_t i = 1; i < kNumItem; ++i) {
+    vector.push_back(std::to_string(i));
+  }
+
+  CHECK(vector.size() == kNumItem);
+  CHECK(&vector[0] == first);
+  CHECK(*first == "first");
+  CHECK(vector.at(kNumItem - 1) == std::to_string(kNumItem - 1));
+  CHECK_THROWS_AS(vector.at(kNumItem), std::out_of_range);
+
+  std::size_t index = 0;
+  bool in_order = true;
+  for (const auto& item : vector) {
+    if (index > 0) {
+      in_order = in_order && item == std::to_string(index);
+    }
+    ++index;
+  }
+  CHECK(in_order);
+  CHECK(index == kNumItem);
+}
+
+TEST_CASE("ConcurrentVector threads", "[lockables][ConcurrentVector]") {
+  constexpr int kNumWriter = 4;
+  constexpr int64_t kNumItem = 20000;
+
+  lockables::ConcurrentVector<int64_t> vector;
+  std::atomic<int> num_done{};
+
+  // Readers iterate while the writers append. Every element they see is
+  // fully constructed, so it is in the range [1, kNumItem].
+  auto reader = std::async(std::launch::async, [&vector, &num_done]() {
+    bool valid = true;
+    std::size_t last_size = 0;
+    while (num_done.load() < kNumWriter) {
+      std::size_t size = 0;
+      for (const auto& item : vector) {
+        valid = valid && item >= 1 && item <= kNumItem;
+        ++size;
+      }
+      // The published size never shrinks.
+      valid = valid && size >= last_size;
+      last_size = size;
+    }
+    return valid;
+  });
+
+  std::vector<std::future<void>> writers;
+  for (int i = 0; i < kNumWriter; ++i) {
+    writers.push_back(std::async(std::launch::async, [&vector, &num_done]() {
+      for (int64_t value = 1; value <= kNumItem; ++value) {
+        vector.push_back(value);
+      }
+      ++num_done;
+    }));
+  }
+
+  for (auto& writer : writers) {
+    writer.get();
+  }
+
+  CHECK(reader.get());
+  CHECK(vector.size() == kNumWriter * kNumItem);
+  CHECK(std::accumulate(vector.begin(), vector.end(), int64_t{0}) ==
+        kNumWriter * kNumItem * (kNumItem + 1) / 2);
+}
@@ -0,0 +1,134 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/double_buffered.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("DoubleBuffered example", "[lockables][DoubleBuffered]") {
+  lockables::DoubleBuffered<std::vector<int>> index;
+
+  // Writer. Rebuild the back buffer, then publish it.
+  {
+    auto back = index.with_back();
+    *back = {1, 2, 3, 4, 5};
+  }
+  index.swap();
+
+  // Reader. Never waits for the writer.
+  {
+    const auto guard = index.with_shared();
+    CHECK(std::binary_search(guard->begin(), guard->end(), 3));
+  }
+}
+
+TEST_CASE("DoubleBuffered swap", "[lockables][DoubleBuffered]") {
+  lockables::DoubleBuffered<std::vector<int>> buffer{1, 2, 3};
+
+  // Both buffers are constructed from the arguments.
+  CHECK(*buffer.with_shared() == std::vector<int>{1, 2, 3});
+  CHECK(*buffer.with_back() == std::vector<int>{1, 2, 3});
+
+  // Not visible until swap.
+  buffer.with_back()->push_back(4);
+  CHECK(buffer.with_shared()->size() == 3);
+
+  buffer.swap();
+  CHECK(buffer.with_shared()->size() == 4);
+
+  // The back buffer holds the value from before the swap.
+  CHECK(buffer.with_back()->size() == 3);
+
+  // Rebuild and swap in one call.
+  const auto size = buffer.update([](std::vector<int>& value) {
+    value.assign(10, 0);
+    return value.size();
+  });
+  CHECK(size == 10);
+  CHECK(buffer.with_shared()->size() == 10);
+
+  // Nothing is swapped if the update throws.
+  CHECK_THROWS(buffer.update([](std::vector<int>& value) {
+    value.clear();
+    throw std::runtime_error{"oops"};
+  }));
+  CHECK(buffer.with_shared()->size() == 10);
+}
+
+TEST_CASE("DoubleBuffered drain readers", "[lockables][DoubleBuffered]") {
+  lockables::DoubleBuffered<int> buffer{1};
+
+  std::promise<void> reading;
+  std::promise<void> release;
+  auto reader = std::async(std::launch::async, [&]() {
+    const auto guard = buffer.with_shared();
+    reading.set_value();
+    release.get_future().wait();
+    return *guard;
+  });
+  reading.get_future().wait();
+
+  // The reader does not block the rebuild of the other buffer, or the swap.
+  buffer.update([](int& value) { value = 2; });
+  CHECK(*buffer.with_shared() == 2);
+
+  // The reader is still on the old front, which is now the back buffer. The
+  // writer waits for the reader to finish before it reuses it.
+  auto writer = std::async(std::launch::async, [&]() {
+    buffer.update([](int& value) { value = 3; });
+  });
+
+  CHECK(writer.wait_for(std::chrono::milliseconds{50}) ==
+        std::future_status::timeout);
+  CHECK(*buffer.with_shared() == 2);
+
+  release.set_value();
+  CHECK(reader.get() == 1);
+  writer.get();
+
+  CHECK(*buffer.with_shared() == 3);
+}
+
+TEST_CASE("DoubleBuffered threads", "[lockables][DoubleBuffered]") {
+  constexpr std::size_t kSize = 1000;
+  constexpr std::size_t kNumReader = 3;
+  constexpr int kNumRebuild = 1000;
+
+  // Every element is equal to the version, so a reader that sees a partial
+  // rebuild will notice.
+  lockables::DoubleBuffered<std::vector<int>> buffer{
+      std::vector<int>(kSize, 0)};
+
+  auto writer = std::async(std::launch::async, [&]() {
+    for (int version = 1; version <= kNumRebuild; ++version) {
+      buffer.update(
+          [version](std::vector<int>& value) { value.assign(kSize, version); });
+    }
+  });
+
+  std::vector<std::future<bool>> readers;
+  for (std::size_t i = 0; i < kNumReader; ++i) {
+    readers.push_back(std::async(std::launch::async, [&]() {
+      bool ok = true;
+      int last = 0;
+      while (last < kNumRebuild) {
+        const auto guard = buffer.with_shared();
+        const int version = guard->front();
+        ok = ok && guard->size() == kSize && version >= last &&
+             std::all_of(guard->begin(), guard->end(),
+                         [version](int x) { return x == version; });
+        last = version;
+      }
+
+      return ok;
+    }));
+  }
+
+  writer.get();
+  for (auto& reader : readers) {
+    CHECK(reader.get());
+  }
+}
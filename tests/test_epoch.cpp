@@ -0,0 +1,262 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/epoch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Count the live nodes.
+struct Node {
+  explicit Node(std::atomic<int>& count) : count_{count} { ++count_; }
+  ~Node() { --count_; }
+
+  Node(const Node&) = delete;
+  Node(Node&&) noexcept = delete;
+  Node& operator=(const Node&) = delete;
+  Node& operator=(Node&&) noexcept = delete;
+
+  std::atomic<int>& count_;
+};
+
+// Advance past any epoch that a retired node may have been seen in.
+void collect_all(lockables::EpochDomain& domain) {
+  for (int i = 0; i < 4; ++i) {
+    domain.collect();
+  }
+}
+
+}  // namespace
+
+TEST_CASE("EpochDomain example", "[lockables][EpochDomain]") {
+  std::atomic<int> count{};
+
+  lockables::EpochDomain domain;
+  std::atomic<Node*> head{new Node{count}};
+
+  {
+    // Reader. Nodes reachable from head are not freed while guard is alive.
+    auto guard = domain.pin();
+
+    Node* node = head.load();
+    CHECK(node != nullptr);
+  }
+
+  // Writer. Unlink the node first, then retire it.
+  Node* node = head.exchange(nullptr);
+  domain.retire(node);
+  CHECK(domain.retired_approx() == 1);
+
+  collect_all(domain);
+  CHECK(count == 0);
+  CHECK(domain.retired_approx() == 0);
+}
+
+TEST_CASE("EpochDomain pinned reader", "[lockables][EpochDomain]") {
+  std::atomic<int> count{};
+  lockables::EpochDomain domain;
+
+  std::promise<void> pinned;
+  std::promise<void> release;
+  auto reader = std::async(std::launch::async, [&]() {
+    auto guard = domain.pin();
+    pinned.set_value();
+    release.get_future().wait();
+  });
+  pinned.get_future().wait();
+
+  const auto epoch = domain.epoch();
+  domain.retire(new Node{count});
+  collect_all(domain);
+
+  // The reader holds the epoch to within one of its own.
+  CHECK(count == 1);
+  CHECK(domain.epoch() <= epoch + 1);
+
+  release.set_value();
+  reader.get();
+
+  collect_all(domain);
+  CHECK(count == 0);
+}
+
+TEST_CASE("EpochDomain nested pin", "[lockables][EpochDomain]") {
+  std::atomic<int> count{};
+  lockables::EpochDomain domain;
+
+  {
+    auto outer = domain.pin();
+    {
+      auto inner = domain.pin();
+      inner.repin();
+    }
+
+    domain.retire(new Node{count});
+    collect_all(domain);
+
+    // Still pinned by outer.
+    CHECK(count == 1);
+
+    // Let the epoch move on while still pinned.
+    outer.repin();
+    collect_all(domain);
+    CHECK(count == 0);
+  }
+}
+
+TEST_CASE("EpochDomain destructor", "[lockables][EpochDomain]") {
+  std::atomic<int> count{};
+  {
+    lockables::EpochDomain domain;
+    for (int i = 0; i < 10; ++i) {
+      domain.retire(new Node{count});
+    }
+
+    CHECK(count == 10);
+  }
+
+  CHECK(count == 0);
+}
+
+TEST_CASE("EpochDomain thread exit", "[lockables][EpochDomain]") {
+  std::atomic<int> count{};
+  lockables::EpochDomain domain{1000};
+
+  // The node retired on the other thread stays in its record. The next
+  // thread to use the domain takes over the record and frees it.
+  std::thread{[&]() { domain.retire(new Node{count}); }}.join();
+  CHECK(domain.retired_approx() == 1);
+
+  collect_all(domain);
+  CHECK(count == 0);
+}
+
+TEST_CASE("EpochDomain bounded", "[lockables][EpochDomain]") {
+  std::atomic<int> count{};
+
+  constexpr std::size_t kMaxRetired = 8;
+  lockables::EpochDomain domain{1, kMaxRetired, std::chrono::seconds{10}};
+
+  std::promise<void> pinned;
+  std::promise<void> release;
+  auto reader = std::async(std::launch::async, [&]() {
+    auto guard = domain.pin();
+    pinned.set_value();
+    release.get_future().wait();
+  });
+  pinned.get_future().wait();
+
+  // The writer blocks once it has more than kMaxRetired nodes that it can not
+  // free because of the stalled reader.
+  std::atomic<std::size_t> num_retired{};
+  auto writer = std::async(std::launch::async, [&]() {
+    for (std::size_t i = 0; i < kMaxRetired * 4; ++i) {
+      domain.retire(new Node{count});
+      ++num_retired;
+    }
+  });
+
+  CHECK(writer.wait_for(std::chrono::milliseconds{50}) ==
+        std::future_status::timeout);
+  CHECK(num_retired == kMaxRetired);
+
+  release.set_value();
+  reader.get();
+  writer.get();
+
+  CHECK(num_retired == kMaxRetired * 4);
+  CHECK(domain.retired_approx() <= kMaxRetired);
+}
+
+TEST_CASE("EpochDomain bounded timeout", "[lockables][EpochDomain]") {
+  std::atomic<int> count{};
+
+  constexpr std::size_t kMaxRetired = 8;
+  lockables::EpochDomain domain{1, kMaxRetired, std::chrono::milliseconds{1}};
+
+  std::promise<void> pinned;
+  std::promise<void> release;
+  auto reader = std::async(std::launch::async, [&]() {
+    auto guard = domain.pin();
+    pinned.set_value();
+    release.get_future().wait();
+  });
+  pinned.get_future().wait();
+
+  // The reader never moves on while the writer runs. The writer waits for at
+  // most max_wait per retire and then goes on over the limit.
+  auto writer = std::async(std::launch::async, [&]() {
+    for (std::size_t i = 0; i < kMaxRetired * 4; ++i) {
+      domain.retire(new Node{count});
+    }
+  });
+
+  CHECK(writer.wait_for(std::chrono::seconds{10}) ==
+        std::future_status::ready);
+  CHECK(domain.retired_approx() > kMaxRetired);
+
+  release.set_value();
+  reader.get();
+  writer.get();
+
+  collect_all(domain);
+  CHECK(count == 0);
+}
+
+namespace {
+
+constexpr int kMagic = 0x600DF00D;
+
+struct Value {
+  int magic{};
+};
+
+// Overwrite the value before it is freed so that a reader that sees it late
+// is more likely to notice.
+void delete_value(void* ptr) {
+  auto* value = static_cast<Value*>(ptr);
+  value->magic = 0;
+  delete value;
+}
+
+}  // namespace
+
+TEST_CASE("EpochDomain threads", "[lockables][EpochDomain]") {
+  lockables::EpochDomain domain;
+
+  // Writers swap the value and retire the old one. Readers check that the
+  // value they load is still alive.
+  std::atomic<Value*> shared{new Value{kMagic}};
+
+  constexpr std::size_t kNumThread = 4;
+  constexpr int kNumIteration = 10000;
+
+  std::vector<std::future<bool>> futures;
+  for (std::size_t i = 0; i < kNumThread; ++i) {
+    futures.push_back(std::async(std::launch::async, [&, i]() {
+      bool ok = true;
+      for (int n = 0; n < kNumIteration; ++n) {
+        if (i % 2 == 0) {
+          Value* old = shared.exchange(new Value{kMagic});
+          domain.retire(old, &delete_value);
+        } else {
+          auto guard = domain.pin();
+          const Value* value = shared.load();
+          ok = ok && value->magic == kMagic;
+        }
+      }
+
+      return ok;
+    }));
+  }
+
+  for (auto& future : futures) {
+    CHECK(future.get());
+  }
+
+  delete shared.load();
+}
@@ -372,4 +372,20 @@ TEST_CASE("constructor", "[lockables][Guarded]") {
       CHECK(guard->empty());
     }
   }
+  {
+    // A mutex that does not take a name ignores it.
+    lockables::Guarded<std::vector<int>> value{lockables::LockName{"list"}, 4,
+                                               5, 6};
+    {
+      auto guard = value.with_shared();
+      CHECK(*guard == std::vector<int>{4, 5, 6});
+    }
+
+    const lockables::LockName name{"number"};
+    lockables::Guarded<int, std::shared_mutex> number{name, 7};
+    {
+      auto guard = number.with_shared();
+      CHECK(*guard == 7);
+    }
+  }
 }
@@ -0,0 +1,177 @@
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/guarded_map.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("GuardedMap example", "[lockables][GuardedMap]") {
+  lockables::GuardedMap<std::string, int> map;
+
+  // Writer access to the segment that owns the key "a".
+  map.with_exclusive("a", [](auto& segment) { segment["a"] += 10; });
+
+  // Reader access to the segment that owns the key "a".
+  const int copy = map.with_shared("a", [](const auto& segment) {
+    auto itr = segment.find("a");
+    return itr != segment.end() ? itr->second : 0;
+  });
+
+  CHECK(copy == 10);
+}
+
+TEST_CASE("GuardedMap segments", "[lockables][GuardedMap]") {
+  CHECK(lockables::GuardedMap<int, int>{}.num_segment() ==
+        lockables::GuardedMap<int, int>::kDefaultNumSegment);
+  CHECK(lockables::GuardedMap<int, int>{0}.num_segment() == 1);
+  CHECK(lockables::GuardedMap<int, int>{1}.num_segment() == 1);
+  CHECK(lockables::GuardedMap<int, int>{5}.num_segment() == 8);
+  CHECK(lockables::GuardedMap<int, int>{64}.num_segment() == 64);
+
+  // Keys are spread over all of the segments.
+  lockables::GuardedMap<int, int> map{8};
+  std::set<std::size_t> used;
+  for (int i = 0; i < 1000; ++i) {
+    const auto index = map.segment_index(i);
+    CHECK(index < map.num_segment());
+    CHECK(index == map.segment_index(i));
+    used.insert(index);
+  }
+
+  CHECK(used.size() == map.num_segment());
+}
+
+TEMPLATE_TEST_CASE("GuardedMap whole map operations",
+                   "[lockables][GuardedMap]", std::mutex, std::shared_mutex) {
+  lockables::GuardedMap<int, int, TestType> map{4};
+  map.reserve(1000);
+
+  for (int i = 0; i < 100; ++i) {
+    map.with_exclusive(i, [i](auto& segment) { segment.emplace(i, i * 2); });
+  }
+
+  CHECK(map.size() == 100);
+
+  int sum = 0;
+  std::size_t num_segment = 0;
+  map.with_all_shared([&](const auto& segment) {
+    ++num_segment;
+    for (const auto& [key, value] : segment) {
+      CHECK(value == key * 2);
+      sum += key;
+    }
+  });
+
+  CHECK(num_segment == 4);
+  CHECK(sum == 99 * 100 / 2);
+
+  map.with_all_exclusive([](auto& segment) { segment.clear(); });
+
+  CHECK(map.size() == 0);
+}
+
+namespace {
+
+// The thread sanitizer tracks at most 64 std mutexes held by one thread, a
+// whole map operation on many segments holds more. A spin lock on an atomic
+// is not a mutex to it.
+class SpinMutex {
+ public:
+  void lock() noexcept {
+    while (locked_.exchange(true, std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void unlock() noexcept { locked_.store(false, std::memory_order_release); }
+
+ private:
+  std::atomic<bool> locked_{};
+};
+
+}  // namespace
+
+TEST_CASE("GuardedMap whole map operations with many segments",
+          "[lockables][GuardedMap]") {
+  // Whole map operations lock the segments in a loop, not one stack frame per
+  // segment.
+  constexpr std::size_t kNumSegment = std::size_t{1} << 16;
+
+  lockables::GuardedMap<int, int, SpinMutex> map{kNumSegment};
+  CHECK(map.num_segment() == kNumSegment);
+
+  for (int i = 0; i < 100; ++i) {
+    map.with_exclusive(i, [i](auto& segment) { segment.emplace(i, i); });
+  }
+
+  CHECK(map.size() == 100);
+
+  std::size_t num_segment = 0;
+  map.with_all_exclusive([&num_segment](auto& segment) {
+    ++num_segment;
+    segment.clear();
+  });
+
+  CHECK(num_segment == kNumSegment);
+  CHECK(map.size() == 0);
+}
+
+TEST_CASE("GuardedMap M reader threads, N writer threads",
+          "[lockables][GuardedMap]") {
+  constexpr int kNumKey = 1000;
+  constexpr int kNumWriter = 4;
+  constexpr int kNumReader = 4;
+
+  lockables::GuardedMap<int, int> map;
+
+  const auto writer_func = [&map]() {
+    for (int i = 0; i < kNumKey; ++i) {
+      map.with_exclusive(i, [i](auto& segment) { segment[i] += 1; });
+    }
+  };
+
+  const auto reader_func = [&map]() {
+    int found = 0;
+    for (int i = 0; i < kNumKey; ++i) {
+      found += map.with_shared(i, [i](const auto& segment) {
+        return segment.count(i) > 0 ? 1 : 0;
+      });
+    }
+    return found;
+  };
+
+  std::vector<std::future<void>> writers;
+  std::vector<std::future<int>> readers;
+  for (int i = 0; i < kNumWriter; ++i) {
+    writers.push_back(std::async(std::launch::async, writer_func));
+  }
+  for (int i = 0; i < kNumReader; ++i) {
+    readers.push_back(std::async(std::launch::async, reader_func));
+  }
+
+  // Concurrent whole map reads see a consistent size.
+  for (int i = 0; i < 10; ++i) {
+    CHECK(map.size() <= kNumKey);
+  }
+
+  for (auto& future : writers) {
+    future.wait();
+  }
+  for (auto& future : readers) {
+    CHECK(future.get() <= kNumKey);
+  }
+
+  CHECK(map.size() == kNumKey);
+  map.with_all_shared([&](const auto& segment) {
+    for (const auto& item : segment) {
+      CHECK(item.second == kNumWriter);
+    }
+  });
+}
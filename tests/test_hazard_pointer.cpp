@@ -0,0 +1,172 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/hazard_pointer.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <vector>
+
+namespace {
+
+// Count the live nodes.
+struct Node {
+  explicit Node(std::atomic<int>& count) : count_{count} { ++count_; }
+  ~Node() { --count_; }
+
+  Node(const Node&) = delete;
+  Node(Node&&) noexcept = delete;
+  Node& operator=(const Node&) = delete;
+  Node& operator=(Node&&) noexcept = delete;
+
+  std::atomic<int>& count_;
+};
+
+constexpr int kMagic = 0x600DF00D;
+
+struct Value {
+  int magic{};
+};
+
+// Overwrite the value before it is freed so that a reader that sees it late
+// is more likely to notice.
+void delete_value(void* ptr) {
+  auto* value = static_cast<Value*>(ptr);
+  value->magic = 0;
+  delete value;
+}
+
+}  // namespace
+
+TEST_CASE("HazardDomain example", "[lockables][HazardDomain]") {
+  std::atomic<int> count{};
+
+  lockables::HazardDomain domain;
+  std::atomic<Node*> head{new Node{count}};
+
+  {
+    // Reader. The node is not freed while hazard protects it.
+    lockables::HazardPointer hazard = domain.make_hazard_pointer();
+
+    Node* node = hazard.protect(head);
+    CHECK(node != nullptr);
+
+    // Writer. Unlink the node first, then retire it.
+    domain.retire(head.exchange(nullptr));
+    domain.scan();
+    CHECK(count == 1);
+  }
+
+  domain.scan();
+  CHECK(count == 0);
+  CHECK(domain.retired_approx() == 0);
+}
+
+TEST_CASE("HazardDomain try_protect", "[lockables][HazardDomain]") {
+  std::atomic<int> count{};
+
+  lockables::HazardDomain domain;
+  Node* first = new Node{count};
+  Node* second = new Node{count};
+  std::atomic<Node*> head{first};
+
+  auto hazard = domain.make_hazard_pointer();
+
+  Node* node = first;
+  head.store(second);
+  CHECK(!hazard.try_protect(node, head));
+  CHECK(node == second);
+  CHECK(hazard.try_protect(node, head));
+
+  // first is not protected.
+  domain.retire(first);
+  domain.scan();
+  CHECK(count == 1);
+
+  domain.retire(head.exchange(nullptr));
+  domain.scan();
+  CHECK(count == 1);
+
+  hazard.reset_protection();
+  domain.scan();
+  CHECK(count == 0);
+}
+
+TEST_CASE("HazardDomain bounded", "[lockables][HazardDomain]") {
+  std::atomic<int> count{};
+
+  lockables::HazardDomain domain;
+  std::atomic<Node*> head{new Node{count}};
+
+  // A reader that never lets go keeps only the node it protects.
+  auto hazard = domain.make_hazard_pointer();
+  hazard.protect(head);
+
+  constexpr int kNumRetire = 10000;
+  constexpr auto kThreshold = lockables::HazardDomain::kMinScanThreshold;
+  for (int i = 0; i < kNumRetire; ++i) {
+    domain.retire(head.exchange(new Node{count}));
+    CHECK(domain.retired_approx() <= kThreshold);
+  }
+
+  CHECK(count <= static_cast<int>(kThreshold) + 1);
+
+  delete head.load();
+}
+
+TEST_CASE("HazardDomain slots", "[lockables][HazardDomain]") {
+  lockables::HazardDomain domain;
+
+  int value = 0;
+  std::atomic<int*> src{&value};
+
+  // Slots are reused once the hazard pointer is gone.
+  const void* first = nullptr;
+  {
+    auto hazard = domain.make_hazard_pointer();
+    first = hazard.protect(src);
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    auto a = domain.make_hazard_pointer();
+    auto b = domain.make_hazard_pointer();
+    CHECK(a.protect(src) == first);
+    CHECK(b.protect(src) == first);
+  }
+}
+
+TEST_CASE("HazardDomain threads", "[lockables][HazardDomain]") {
+  lockables::HazardDomain domain;
+
+  // Writers swap the value and retire the old one. Readers check that the
+  // value they protect is still alive.
+  std::atomic<Value*> shared{new Value{kMagic}};
+
+  constexpr std::size_t kNumThread = 4;
+  constexpr int kNumIteration = 10000;
+
+  std::vector<std::future<bool>> futures;
+  for (std::size_t i = 0; i < kNumThread; ++i) {
+    futures.push_back(std::async(std::launch::async, [&, i]() {
+      bool ok = true;
+      auto hazard = domain.make_hazard_pointer();
+      for (int n = 0; n < kNumIteration; ++n) {
+        if (i % 2 == 0) {
+          Value* old = shared.exchange(new Value{kMagic});
+          domain.retire(old, &delete_value);
+        } else {
+          const Value* value = hazard.protect(shared);
+          ok = ok && value->magic == kMagic;
+          hazard.reset_protection();
+        }
+      }
+
+      return ok;
+    }));
+  }
+
+  for (auto& future : futures) {
+    CHECK(future.get());
+  }
+
+  delete shared.load();
+}
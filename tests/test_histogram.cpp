@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/histogram.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+TEST_CASE("LatencyHistogram example", "[lockables][LatencyHistogram]") {
+  lockables::LatencyHistogram histogram;
+  histogram.record(150);
+  histogram.record(2000);
+
+  const std::uint64_t p99 = histogram.percentile(99.0);
+  CHECK(p99 >= 2000);
+  CHECK(p99 < 2000 + 2000 / 16);
+}
+
+TEST_CASE("LatencyHistogram buckets", "[lockables][LatencyHistogram]") {
+  using lockables::LatencyHistogram;
+
+  // One bucket per value below the sub-bucket count.
+  for (std::uint64_t value = 0; value < LatencyHistogram::kSubBucketCount;
+       ++value) {
+    CHECK(LatencyHistogram::bucket_index(value) == value);
+    CHECK(LatencyHistogram::bucket_upper(value) == value);
+  }
+
+  // Every value lies in its bucket and the bucket is within 1/16 of it.
+  for (std::uint64_t value = 1; value < (1ULL << 20); value = value * 3 + 1) {
+    const auto index = LatencyHistogram::bucket_index(value);
+    const auto upper = LatencyHistogram::bucket_upper(index);
+    CHECK(upper >= value);
+    CHECK(upper - value <= value / LatencyHistogram::kSubBucketCount);
+    CHECK(LatencyHistogram::bucket_index(upper) == index);
+    CHECK(LatencyHistogram::bucket_index(upper + 1) == index + 1);
+  }
+
+  // Large values are counted in the last bucket.
+  constexpr auto kLast = LatencyHistogram::kNumBucket - 1;
+  static_assert(LatencyHistogram::bucket_index(LatencyHistogram::kMaxValue) ==
+                kLast);
+  static_assert(LatencyHistogram::bucket_upper(kLast) ==
+                LatencyHistogram::kMaxValue);
+  CHECK(LatencyHistogram::bucket_index(~std::uint64_t{0}) == kLast);
+}
+
+TEST_CASE("LatencyHistogram percentile", "[lockables][LatencyHistogram]") {
+  lockables::LatencyHistogram histogram;
+  CHECK(histogram.count() == 0);
+  CHECK(histogram.percentile(50.0) == 0);
+  CHECK(histogram.max() == 0);
+
+  // 1 to 1000, each once.
+  for (std::uint64_t value = 1; value <= 1000; ++value) {
+    histogram.record(value);
+  }
+  CHECK(histogram.count() == 1000);
+
+  const auto p50 = histogram.percentile(50.0);
+  CHECK(p50 >= 500);
+  CHECK(p50 <= 500 + 500 / 16);
+
+  const auto p99 = histogram.percentile(99.0);
+  CHECK(p99 >= 990);
+  CHECK(p99 <= 990 + 990 / 16);
+
+  CHECK(histogram.percentile(0.0) == 1);
+  CHECK(histogram.percentile(100.0) == histogram.max());
+  CHECK(histogram.max() >= 1000);
+  CHECK(histogram.max() <= 1000 + 1000 / 16);
+}
+
+TEST_CASE("LatencyHistogram add and subtract",
+          "[lockables][LatencyHistogram]") {
+  lockables::LatencyHistogram before;
+  before.record(10, 100);
+
+  // Snapshot, record more, then subtract to get the interval.
+  lockables::LatencyHistogram after = before;
+  after.record(5000, 3);
+  after.subtract(before);
+
+  CHECK(after.count() == 3);
+  CHECK(after.percentile(50.0) >= 5000);
+  CHECK(after.bucket_count(lockables::LatencyHistogram::bucket_index(10)) ==
+        0);
+
+  after.add(before);
+  CHECK(after.count() == 103);
+  CHECK(after.percentile(50.0) == 10);
+
+  lockables::LatencyHistogram merged;
+  merged.add_bucket(lockables::LatencyHistogram::bucket_index(10), 100);
+  merged.subtract(before);
+  CHECK(merged.count() == 0);
+}
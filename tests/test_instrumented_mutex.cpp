@@ -0,0 +1,207 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/instrumented_mutex.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+struct Order {
+  int quantity{};
+};
+
+}  // namespace
+
+TEST_CASE("InstrumentedMutex example", "[lockables][InstrumentedMutex]") {
+  using lockables::LockName;
+
+  // Same as Guarded<Order, std::mutex>, unless instrumentation is compiled
+  // out with LOCKABLES_DISABLE_INSTRUMENTATION. The name identifies it in the
+  // registry.
+  lockables::Guarded<Order, lockables::instrumented_mutex_t<std::mutex>> order{
+      LockName{"order"}};
+
+  {
+    auto guard = order.with_exclusive();
+    guard->quantity = 10;
+  }
+
+  // Print the statistics of every live instrumented mutex, the most waited on
+  // first.
+  std::ostringstream out;
+  lockables::LockRegistry::instance().dump(out);
+  CHECK(out.str().find("acquisitions") != std::string::npos);
+  CHECK(out.str().find("order") != std::string::npos);
+}
+
+TEST_CASE("InstrumentedMutex stats", "[lockables][InstrumentedMutex]") {
+  lockables::InstrumentedMutex<std::mutex> mutex{"stats"};
+  CHECK(mutex.name() == "stats");
+
+  for (int i = 0; i < 10; ++i) {
+    std::scoped_lock lock{mutex};
+  }
+
+  CHECK(mutex.try_lock());
+  CHECK(!mutex.try_lock());
+  mutex.unlock();
+
+  const auto stats = mutex.stats();
+  CHECK(stats.acquisitions == 11);
+  CHECK(stats.contended == 0);
+  CHECK(stats.wait_total.count() == 0);
+  CHECK(stats.hold_max <= stats.hold_total);
+}
+
+TEST_CASE("InstrumentedMutex contended", "[lockables][InstrumentedMutex]") {
+  using namespace std::chrono_literals;
+
+  lockables::Guarded<int, lockables::InstrumentedMutex<std::mutex>> value;
+
+  std::promise<void> locked;
+  auto holder = std::async(std::launch::async, [&]() {
+    auto guard = value.with_exclusive();
+    locked.set_value();
+    std::this_thread::sleep_for(20ms);
+    *guard = 1;
+  });
+  locked.get_future().wait();
+
+  // Blocks until the holder is done.
+  CHECK(*value.with_shared() == 1);
+  holder.get();
+
+  const auto entries = lockables::LockRegistry::instance().snapshot();
+  REQUIRE(!entries.empty());
+
+  // The most waited on mutex is first.
+  const auto& stats = entries.front().stats;
+  CHECK(stats.acquisitions == 2);
+  CHECK(stats.contended == 1);
+  CHECK(stats.wait_total >= 10ms);
+  CHECK(stats.wait_max == stats.wait_total);
+  CHECK(stats.hold_max >= 10ms);
+
+  // The uncontended acquisition waited zero, the contended one is in the
+  // buckets that its thread allocated for it.
+  const auto& wait = entries.front().histograms.wait;
+  CHECK(wait.count() == 2);
+  CHECK(wait.bucket_count(0) == 1);
+  CHECK(wait.max() >= 10'000'000);
+}
+
+TEST_CASE("InstrumentedMutex histograms", "[lockables][InstrumentedMutex]") {
+  using namespace std::chrono_literals;
+
+  lockables::InstrumentedMutex<std::mutex> mutex;
+
+  // Each thread records into its own buckets, merged on read.
+  constexpr int kNumThread = 4;
+  constexpr int kNumLock = 100;
+  std::vector<std::future<void>> threads;
+  for (int i = 0; i < kNumThread; ++i) {
+    threads.push_back(std::async(std::launch::async, [&mutex]() {
+      for (int j = 0; j < kNumLock; ++j) {
+        std::scoped_lock lock{mutex};
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.get();
+  }
+
+  {
+    std::scoped_lock lock{mutex};
+    std::this_thread::sleep_for(10ms);
+  }
+
+  const auto histograms = mutex.histograms();
+  const auto stats = mutex.stats();
+  CHECK(stats.acquisitions == kNumThread * kNumLock + 1);
+  CHECK(histograms.wait.count() == stats.acquisitions);
+  CHECK(histograms.hold.count() == stats.acquisitions);
+
+  // The one long hold is the max, most holds are much shorter.
+  CHECK(histograms.hold.max() >= 10'000'000);
+  CHECK(histograms.hold.percentile(50.0) < 10'000'000);
+  CHECK(histograms.wait.max() >=
+        static_cast<std::uint64_t>(stats.wait_max.count()));
+
+  // Records of exited threads are reused by new threads.
+  auto reused = std::async(std::launch::async, [&mutex]() {
+    std::scoped_lock lock{mutex};
+  });
+  reused.get();
+  CHECK(mutex.stats().acquisitions == stats.acquisitions + 1);
+}
+
+TEST_CASE("InstrumentedMutex shared", "[lockables][InstrumentedMutex]") {
+  using Mutex = lockables::InstrumentedMutex<std::shared_mutex>;
+
+  // Same lock selection as the wrapped mutex.
+  static_assert(std::is_same_v<lockables::shared_lock_t<Mutex>,
+                               std::shared_lock<Mutex>>);
+  static_assert(
+      std::is_same_v<
+          lockables::shared_lock_t<lockables::InstrumentedMutex<std::mutex>>,
+          std::scoped_lock<lockables::InstrumentedMutex<std::mutex>>>);
+
+  lockables::Guarded<int, Mutex> value{1};
+
+  // Two readers at the same time.
+  {
+    const auto reader = value.with_shared();
+    auto other = std::async(std::launch::async,
+                            [&]() { return *value.with_shared(); });
+    CHECK(other.get() == 1);
+  }
+
+  {
+    auto writer = value.with_exclusive();
+    *writer = 2;
+  }
+
+  // Lock both values at once, std::scoped_lock uses try_lock.
+  lockables::Guarded<int, Mutex> other{3};
+  lockables::with_exclusive([](int& x, int& y) { x += y; }, value, other);
+  CHECK(*value.with_shared() == 5);
+}
+
+TEST_CASE("InstrumentedMutex registry", "[lockables][InstrumentedMutex]") {
+  auto& registry = lockables::LockRegistry::instance();
+  const auto size = registry.size();
+
+  {
+    std::vector<lockables::InstrumentedMutex<std::mutex>> mutexes(3);
+    lockables::InstrumentedMutex<std::mutex> named{"orders"};
+    CHECK(registry.size() == size + 4);
+
+    named.lock();
+    named.unlock();
+
+    std::ostringstream out;
+    registry.dump(out);
+    CHECK(out.str().find("orders") != std::string::npos);
+
+    bool found = false;
+    for (const auto& entry : registry.snapshot()) {
+      if (entry.name == "orders") {
+        found = true;
+        CHECK(entry.stats.acquisitions == 1);
+      }
+    }
+    CHECK(found);
+  }
+
+  // Removed on destruction.
+  CHECK(registry.size() == size);
+}
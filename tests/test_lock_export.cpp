@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/instrumented_mutex.hpp>
+#include <lockables/lock_export.hpp>
+
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+
+namespace {
+
+struct Order {
+  int quantity{};
+};
+
+bool contains(const std::string& text, const std::string& part) {
+  return text.find(part) != std::string::npos;
+}
+
+}  // namespace
+
+TEST_CASE("Lock export example", "[lockables][LockExport]") {
+  using lockables::LockName;
+
+  lockables::Guarded<Order, lockables::InstrumentedMutex<std::mutex>> order{
+      LockName{"order"}};
+
+  {
+    auto guard = order.with_exclusive();
+    guard->quantity = 10;
+  }
+
+  std::ostringstream json;
+  lockables::write_json(json);
+  CHECK(contains(json.str(), "{\"locks\":["));
+  CHECK(contains(json.str(), "{\"name\":\"order\",\"id\":"));
+
+  std::ostringstream prometheus;
+  lockables::write_prometheus(prometheus);
+  CHECK(contains(prometheus.str(),
+                 "lockables_acquisitions_total{name=\"order\""));
+}
+
+TEST_CASE("Lock export JSON", "[lockables][LockExport]") {
+  lockables::InstrumentedMutex<std::mutex> mutex{"json \"quoted\"\n"};
+  for (int i = 0; i < 3; ++i) {
+    std::scoped_lock lock{mutex};
+  }
+
+  std::ostringstream out;
+  lockables::write_json(out);
+  const auto text = out.str();
+
+  // Escaped name, one object with every field.
+  const auto begin = text.find("{\"name\":\"json \\\"quoted\\\"\\n\"");
+  REQUIRE(begin != std::string::npos);
+  const auto object = text.substr(begin, text.find('}', begin) - begin);
+  CHECK(contains(object, ",\"acquisitions\":3,\"contended\":0,"));
+  CHECK(contains(object, "\"wait_total_ns\":0,"));
+  CHECK(contains(object, "\"wait_p99_ns\":0,"));
+  CHECK(contains(object, "\"hold_p999_ns\":"));
+  CHECK(text.back() == '\n');
+}
+
+TEST_CASE("Lock export Prometheus", "[lockables][LockExport]") {
+  lockables::Guarded<int, lockables::InstrumentedMutex<std::shared_mutex>>
+      value{lockables::LockName{"prometheus"}};
+  for (int i = 0; i < 5; ++i) {
+    const auto guard = value.with_shared();
+  }
+
+  std::ostringstream out;
+  lockables::write_prometheus(out);
+  const auto text = out.str();
+
+  CHECK(contains(text, "# TYPE lockables_acquisitions_total counter\n"));
+  CHECK(contains(text, "# TYPE lockables_wait_seconds summary\n"));
+  CHECK(contains(text, "# TYPE lockables_hold_max_seconds gauge\n"));
+
+  const std::string labels = "{name=\"prometheus\",id=\"";
+  CHECK(contains(text, "lockables_acquisitions_total" + labels));
+  CHECK(contains(text, "lockables_wait_seconds" + labels));
+  CHECK(contains(text, "lockables_wait_seconds_sum" + labels));
+  CHECK(contains(text, "lockables_hold_seconds_count" + labels));
+
+  // Uncontended, every wait is zero seconds.
+  const auto line = text.find("lockables_wait_seconds" + labels);
+  const auto end = text.find('\n', line);
+  const auto sample = text.substr(line, end - line);
+  CHECK(contains(sample, ",quantile=\"0.5\"} 0.000000000"));
+
+  const auto count = text.find("lockables_hold_seconds_count" + labels);
+  CHECK(text.substr(count, text.find('\n', count) - count).back() == '5');
+}
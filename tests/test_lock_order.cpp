@@ -0,0 +1,284 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/lock_order.hpp>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Account {
+  int balance{};
+};
+
+// Collect violations instead of writing them to std::cerr.
+class ReporterScope {
+ public:
+  explicit ReporterScope(lockables::LockOrderGraph::Reporter reporter)
+      : previous_{lockables::LockOrderGraph::instance().set_reporter(
+            std::move(reporter))} {}
+
+  ReporterScope(const ReporterScope&) = delete;
+  ReporterScope(ReporterScope&&) noexcept = delete;
+  ReporterScope& operator=(const ReporterScope&) = delete;
+  ReporterScope& operator=(ReporterScope&&) noexcept = delete;
+  ~ReporterScope() {
+    lockables::LockOrderGraph::instance().set_reporter(std::move(previous_));
+  }
+
+ private:
+  lockables::LockOrderGraph::Reporter previous_;
+};
+
+// Some tests lock in the wrong order on purpose. The thread sanitizer reports
+// that for the std mutex types, which it intercepts, but a spin lock on an
+// atomic is not a mutex to it.
+class SpinMutex {
+ public:
+  void lock() noexcept {
+    while (!try_lock()) {
+      std::this_thread::yield();
+    }
+  }
+
+  bool try_lock() noexcept {
+    int expected = 0;
+    return state_.compare_exchange_strong(expected, kWriter,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed);
+  }
+
+  void unlock() noexcept { state_.store(0, std::memory_order_release); }
+
+  void lock_shared() noexcept {
+    while (!try_lock_shared()) {
+      std::this_thread::yield();
+    }
+  }
+
+  bool try_lock_shared() noexcept {
+    int expected = state_.load(std::memory_order_relaxed);
+    return expected != kWriter &&
+           state_.compare_exchange_strong(expected, expected + 1,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed);
+  }
+
+  void unlock_shared() noexcept {
+    state_.fetch_sub(1, std::memory_order_release);
+  }
+
+ private:
+  static constexpr int kWriter = -1;
+
+  // Number of readers, or kWriter.
+  std::atomic<int> state_{};
+};
+
+}  // namespace
+
+namespace lockables {
+
+template <>
+struct SharedLock<SpinMutex> {
+  using type = std::shared_lock<SpinMutex>;
+};
+
+}  // namespace lockables
+
+TEST_CASE("CheckedMutex example", "[lockables][CheckedMutex]") {
+  using lockables::LockName;
+  using Mutex = lockables::CheckedMutex<SpinMutex>;
+
+  std::vector<lockables::LockOrderViolation> violations;
+  ReporterScope reporter{[&violations](const auto& violation) {
+    violations.push_back(violation);
+  }};
+
+  lockables::Guarded<Account, Mutex> from{LockName{"from"}};
+  lockables::Guarded<Account, Mutex> to{LockName{"to"}};
+
+  {
+    auto guard1 = from.with_exclusive();
+    auto guard2 = to.with_exclusive();
+  }
+
+  CHECK(violations.empty());
+
+  {
+    // Reports "to" while holding "from" and "from" while holding "to", with
+    // both call stacks.
+    auto guard2 = to.with_exclusive();
+    auto guard1 = from.with_exclusive();
+  }
+
+  REQUIRE(violations.size() == 1);
+  const auto& cycle = violations.front().cycle;
+  REQUIRE(cycle.size() == 2);
+  CHECK(cycle[0].from == "to");
+  CHECK(cycle[0].to == "from");
+  CHECK(cycle[1].from == "from");
+  CHECK(cycle[1].to == "to");
+
+  // Only the first time.
+  {
+    auto guard2 = to.with_exclusive();
+    auto guard1 = from.with_exclusive();
+  }
+
+  CHECK(violations.size() == 1);
+
+  std::ostringstream out;
+  lockables::write_violation(out, violations.front());
+  CHECK(out.str().find("acquiring \"from\" while holding \"to\"") !=
+        std::string::npos);
+}
+
+TEST_CASE("CheckedMutex cycle across threads", "[lockables][CheckedMutex]") {
+  using Mutex = lockables::CheckedMutex<SpinMutex>;
+  static_assert(std::is_same_v<lockables::shared_lock_t<Mutex>,
+                               std::shared_lock<Mutex>>);
+
+  std::vector<lockables::LockOrderViolation> violations;
+  ReporterScope reporter{[&violations](const auto& violation) {
+    violations.push_back(violation);
+  }};
+
+  lockables::Guarded<int, Mutex> a{lockables::LockName{"a"}};
+  lockables::Guarded<int, Mutex> b{lockables::LockName{"b"}};
+  lockables::Guarded<int, Mutex> c{lockables::LockName{"c"}};
+
+  // a -> b on one thread, b -> c on another. One at a time, so this test
+  // never deadlocks.
+  std::async(std::launch::async, [&]() {
+    const auto guard1 = a.with_shared();
+    const auto guard2 = b.with_shared();
+  }).get();
+  std::async(std::launch::async, [&]() {
+    auto guard1 = b.with_exclusive();
+    auto guard2 = c.with_exclusive();
+  }).get();
+
+  CHECK(violations.empty());
+
+  // c -> a closes the cycle.
+  {
+    auto guard1 = c.with_exclusive();
+    const auto guard2 = a.with_shared();
+  }
+
+  REQUIRE(violations.size() == 1);
+  const auto& cycle = violations.front().cycle;
+  REQUIRE(cycle.size() == 3);
+  CHECK(cycle[0].from == "c");
+  CHECK(cycle[0].to == "a");
+  CHECK(cycle[1].to == "b");
+  CHECK(cycle[2].to == "c");
+}
+
+TEST_CASE("CheckedMutex with_exclusive", "[lockables][CheckedMutex]") {
+  using Mutex = lockables::CheckedMutex<std::mutex>;
+
+  std::vector<lockables::LockOrderViolation> violations;
+  ReporterScope reporter{[&violations](const auto& violation) {
+    violations.push_back(violation);
+  }};
+
+  lockables::Guarded<int, Mutex> value1{1};
+  lockables::Guarded<int, Mutex> value2{2};
+
+  // The deadlock avoidance of std::scoped_lock locks in any order, it only
+  // blocks while it holds none of the locks.
+  const auto sum = [](int& x, int& y) { return x + y; };
+  CHECK(lockables::with_exclusive(sum, value1, value2) == 3);
+  CHECK(lockables::with_exclusive(sum, value2, value1) == 3);
+
+  // Locks that are held are ordered before the next blocking lock.
+  lockables::Guarded<int, Mutex> value3{3};
+  lockables::with_exclusive(
+      [&value3](int& x, int& y) { *value3.with_exclusive() += x + y; }, value1,
+      value2);
+  CHECK(*value3.with_shared() == 6);
+
+  CHECK(violations.empty());
+}
+
+TEST_CASE("CheckedMutex with_exclusive held", "[lockables][CheckedMutex]") {
+  using Mutex = lockables::CheckedMutex<SpinMutex>;
+
+  std::vector<lockables::LockOrderViolation> violations;
+  ReporterScope reporter{[&violations](const auto& violation) {
+    violations.push_back(violation);
+  }};
+
+  lockables::Guarded<int, Mutex> held{lockables::LockName{"held"}};
+  lockables::Guarded<int, Mutex> a{lockables::LockName{"a"}};
+  lockables::Guarded<int, Mutex> b{lockables::LockName{"b"}};
+
+  const auto size = lockables::LockOrderGraph::instance().size();
+
+  // std::scoped_lock blocks on a and tries b. Both are ordered after held,
+  // the try could have failed and blocked on b while holding held.
+  {
+    auto guard = held.with_exclusive();
+    lockables::with_exclusive([](int&, int&) {}, a, b);
+  }
+
+  CHECK(lockables::LockOrderGraph::instance().size() == size + 2);
+  CHECK(violations.empty());
+
+  // b -> held closes the cycle.
+  {
+    auto guard1 = b.with_exclusive();
+    auto guard2 = held.with_exclusive();
+  }
+
+  REQUIRE(violations.size() == 1);
+  const auto& cycle = violations.front().cycle;
+  REQUIRE(cycle.size() == 2);
+  CHECK(cycle[0].from == "b");
+  CHECK(cycle[0].to == "held");
+  CHECK(cycle[1].to == "b");
+}
+
+TEST_CASE("CheckedMutex reporter throws", "[lockables][CheckedMutex]") {
+  using Mutex = lockables::CheckedMutex<std::mutex>;
+
+  ReporterScope reporter{[](const lockables::LockOrderViolation&) {
+    throw std::logic_error{"lock order"};
+  }};
+
+  const auto size = lockables::LockOrderGraph::instance().size();
+  {
+    lockables::Guarded<int, Mutex> value1{1};
+    lockables::Guarded<int, Mutex> value2{2};
+
+    {
+      auto guard1 = value1.with_exclusive();
+      auto guard2 = value2.with_exclusive();
+    }
+
+    CHECK(lockables::LockOrderGraph::instance().size() == size + 1);
+
+    // Fail fast, before blocking. The lock is not acquired.
+    {
+      auto guard2 = value2.with_exclusive();
+      CHECK_THROWS_AS(value1.with_exclusive(), std::logic_error);
+    }
+
+    CHECK(*value1.with_shared() == 1);
+    CHECK(*value2.with_shared() == 2);
+  }
+
+  // Removed on destruction.
+  CHECK(lockables::LockOrderGraph::instance().size() == size);
+}
@@ -0,0 +1,152 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/lock_table.hpp>
+
+#include <array>
+#include <cstddef>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST_CASE("LockTable example", "[lockables][LockTable]") {
+  struct Record {
+    int count{};
+  };
+
+  lockables::LockTable<std::shared_mutex> locks;
+  std::array<Record, 16> records{};
+
+  // Writer. Exclusive lock on the stripe of key 7.
+  locks.with_exclusive(7, [&]() { records[7].count += 1; });
+
+  // Reader. Shared lock on the stripe of key 7.
+  const int count = locks.with_shared(7, [&]() { return records[7].count; });
+  CHECK(count == 1);
+
+  // Writer. Lock the stripes of both keys without deadlock.
+  locks.with_exclusive_all(std::array{7, 12}, [&]() {
+    std::swap(records[7], records[12]);
+  });
+
+  CHECK(records[7].count == 0);
+  CHECK(records[12].count == 1);
+}
+
+TEST_CASE("LockTable stripe index", "[lockables][LockTable]") {
+  using Table = lockables::LockTable<std::mutex, 16>;
+
+  // Same key, same stripe.
+  CHECK(Table::stripe_index(42) == Table::stripe_index(42));
+  CHECK(Table::stripe_index(std::string{"key"}) ==
+        Table::stripe_index(std::string{"key"}));
+
+  // Sequential keys spread over all of the stripes.
+  std::array<int, Table::kNumStripe> histogram{};
+  for (int key = 0; key < 1024; ++key) {
+    const auto index = Table::stripe_index(key);
+    REQUIRE(index < Table::kNumStripe);
+    ++histogram[index];
+  }
+
+  for (const int count : histogram) {
+    CHECK(count > 0);
+  }
+
+  // One stripe means every key shares the mutex.
+  CHECK(lockables::LockTable<std::mutex, 1>::stripe_index(42) == 0);
+}
+
+TEST_CASE("LockTable multiple keys", "[lockables][LockTable]") {
+  using Table = lockables::LockTable<std::mutex, 4>;
+  Table locks;
+
+  // Find two different keys that map to the same stripe.
+  int other = 1;
+  while (Table::stripe_index(other) != Table::stripe_index(0)) {
+    ++other;
+  }
+
+  // Each stripe is locked once, std::mutex would deadlock on a second lock.
+  const std::vector<int> keys{0, other, 0, 1, 2, 3, other};
+  const int result = locks.with_exclusive_all(keys, []() { return 1; });
+  CHECK(result == 1);
+
+  // The locks are released.
+  for (const int key : keys) {
+    locks.with_exclusive(key, []() {});
+  }
+
+  // Empty range is a no-op lock.
+  CHECK(locks.with_exclusive_all(std::vector<int>{}, []() { return 2; }) == 2);
+
+  // Readers use the exclusive lock if the mutex has no shared mode.
+  CHECK(locks.with_shared_all(keys, []() { return 3; }) == 3);
+}
+
+TEST_CASE("LockTable exception", "[lockables][LockTable]") {
+  lockables::LockTable<std::mutex, 8> locks;
+  const std::array keys{1, 2, 3, 4};
+
+  CHECK_THROWS(locks.with_exclusive_all(
+      keys, []() -> int { throw std::runtime_error{"oops"}; }));
+
+  // The locks are released after the callback throws.
+  CHECK(locks.with_exclusive_all(keys, []() { return 1; }) == 1);
+}
+
+TEST_CASE("LockTable shared", "[lockables][LockTable]") {
+  lockables::LockTable<std::shared_mutex, 8> locks;
+  const std::array keys{1, 2, 3};
+
+  // Readers hold the stripes in shared mode at the same time.
+  locks.with_shared_all(keys, [&]() {
+    auto reader = std::async(std::launch::async, [&]() {
+      return locks.with_shared_all(keys, []() { return true; });
+    });
+    CHECK(reader.get());
+  });
+}
+
+TEST_CASE("LockTable threads", "[lockables][LockTable]") {
+  constexpr std::size_t kNumKey = 100;
+  constexpr std::size_t kNumThread = 4;
+  constexpr int kNumIteration = 1000;
+
+  // The table guards an external array, one counter per key.
+  lockables::LockTable<std::mutex, 16> locks;
+  std::array<int, kNumKey> counters{};
+
+  std::vector<std::future<void>> futures;
+  for (std::size_t i = 0; i < kNumThread; ++i) {
+    futures.push_back(std::async(std::launch::async, [&, i]() {
+      for (int n = 0; n < kNumIteration; ++n) {
+        const std::size_t key = (i + static_cast<std::size_t>(n)) % kNumKey;
+        const std::size_t next = (key + 1) % kNumKey;
+        if (n % 2 == 0) {
+          locks.with_exclusive(key, [&]() { counters[key] += 2; });
+        } else {
+          // Move one from the next key to this one, total is unchanged.
+          locks.with_exclusive_all(std::array{next, key}, [&]() {
+            counters[key] += 1;
+            counters[next] -= 1;
+          });
+        }
+      }
+    }));
+  }
+
+  for (auto& future : futures) {
+    future.get();
+  }
+
+  int total = 0;
+  for (const int count : counters) {
+    total += count;
+  }
+
+  // Half of the iterations add two, the other half move one.
+  CHECK(total == static_cast<int>(kNumThread) * kNumIteration);
+}
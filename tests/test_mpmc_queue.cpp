@@ -0,0 +1,192 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/mpmc_queue.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("MpmcQueue example", "[lockables][MpmcQueue]") {
+  lockables::MpmcQueue<int> queue{1024};
+
+  // Producer.
+  CHECK(queue.try_push(1));
+  queue.push(2);
+
+  // Consumer.
+  int value = 0;
+  CHECK(queue.try_pop(value));
+  CHECK(value == 1);
+  CHECK(queue.pop() == 2);
+  CHECK(!queue.try_pop(value));
+}
+
+TEST_CASE("MpmcQueue full and empty", "[lockables][MpmcQueue]") {
+  lockables::MpmcQueue<std::string> queue{3};
+  CHECK(queue.capacity() == 4);
+  CHECK(queue.size_approx() == 0);
+
+  // Wrap around the ring a few times.
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 4; ++i) {
+      CHECK(queue.try_push(std::to_string(i)));
+    }
+    CHECK(!queue.try_push("full"));
+    CHECK(queue.size_approx() == 4);
+
+    std::string value;
+    for (int i = 0; i < 4; ++i) {
+      CHECK(queue.try_pop(value));
+      CHECK(value == std::to_string(i));
+    }
+    CHECK(!queue.try_pop(value));
+    CHECK(queue.size_approx() == 0);
+  }
+
+  // Destructor cleans up the elements that are still queued.
+  CHECK(queue.try_emplace(std::size_t{10}, 'x'));
+  CHECK(queue.try_push(std::string(100, 'y')));
+}
+
+TEST_CASE("MpmcQueue batch", "[lockables][MpmcQueue]") {
+  lockables::MpmcQueue<int> queue{8};
+
+  const std::vector<int> input{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  CHECK(queue.try_push_n(input.begin(), input.size()) == 8);
+
+  std::vector<int> output(10);
+  CHECK(queue.try_pop_n(output.begin(), 3) == 3);
+  CHECK(queue.try_pop_n(output.begin() + 3, 10) == 5);
+  CHECK(queue.try_pop_n(output.begin(), 10) == 0);
+  CHECK(std::vector<int>(output.begin(), output.begin() + 8) ==
+        std::vector<int>(input.begin(), input.begin() + 8));
+
+  // Blocking batch push waits for the consumer to drain the queue.
+  auto producer = std::async(std::launch::async, [&queue, &input]() {
+    for (int i = 0; i < 10; ++i) {
+      queue.push_n(input.begin(), input.size());
+    }
+  });
+
+  int sum = 0;
+  std::size_t num_popped = 0;
+  while (num_popped < input.size() * 10) {
+    const auto count = queue.pop_n(output.begin(), output.size());
+    CHECK(count > 0);
+    for (std::size_t i = 0; i < count; ++i) {
+      sum += output[i];
+    }
+    num_popped += count;
+  }
+
+  producer.get();
+  CHECK(sum == 550);
+  CHECK(queue.size_approx() == 0);
+}
+
+TEST_CASE("MpmcQueue threads", "[lockables][MpmcQueue]") {
+  constexpr int kNumProducer = 4;
+  constexpr int kNumConsumer = 4;
+  constexpr int64_t kNumItem = 10000;
+
+  // Small capacity so producers and consumers both block.
+  lockables::MpmcQueue<int64_t> queue{16};
+
+  std::vector<std::future<void>> producers;
+  for (int i = 0; i < kNumProducer; ++i) {
+    producers.push_back(std::async(std::launch::async, [&queue]() {
+      for (int64_t value = 1; value <= kNumItem; ++value) {
+        queue.push(value);
+      }
+    }));
+  }
+
+  std::vector<std::future<int64_t>> consumers;
+  for (int i = 0; i < kNumConsumer; ++i) {
+    consumers.push_back(std::async(std::launch::async, [&queue]() {
+      int64_t sum = 0;
+      for (int64_t count = 0; count < kNumItem; ++count) {
+        sum += queue.pop();
+      }
+      return sum;
+    }));
+  }
+
+  for (auto& producer : producers) {
+    producer.get();
+  }
+
+  int64_t sum = 0;
+  for (auto& consumer : consumers) {
+    sum += consumer.get();
+  }
+
+  CHECK(sum == kNumProducer * kNumItem * (kNumItem + 1) / 2);
+  CHECK(queue.size_approx() == 0);
+}
+
+TEST_CASE("MpmcQueue move only", "[lockables][MpmcQueue]") {
+  lockables::MpmcQueue<std::unique_ptr<int>> queue{2};
+
+  CHECK(queue.try_push(std::make_unique<int>(1)));
+  queue.push(std::make_unique<int>(2));
+
+  auto value = std::make_unique<int>(3);
+  CHECK(!queue.try_push(std::move(value)));
+  // Not moved from if the push fails.
+  REQUIRE(value);
+
+  std::unique_ptr<int> result;
+  CHECK(queue.try_pop(result));
+  REQUIRE(result);
+  CHECK(*result == 1);
+
+  result = queue.pop();
+  REQUIRE(result);
+  CHECK(*result == 2);
+}
+
+namespace {
+
+// Constructor throws for negative values. Move is noexcept.
+struct ThrowingConstructor {
+  ThrowingConstructor() = default;
+
+  explicit ThrowingConstructor(int init) : value{init} {
+    if (init < 0) {
+      throw std::invalid_argument{"negative"};
+    }
+  }
+
+  int value{};
+};
+
+}  // namespace
+
+TEST_CASE("MpmcQueue throwing constructor", "[lockables][MpmcQueue]") {
+  lockables::MpmcQueue<ThrowingConstructor> queue{2};
+
+  CHECK(queue.try_emplace(1));
+  CHECK_THROWS_AS(queue.try_emplace(-1), std::invalid_argument);
+  CHECK(queue.size_approx() == 1);
+
+  // The failed push did not claim a cell. Both cells are still usable.
+  CHECK(queue.try_emplace(2));
+  CHECK(!queue.try_emplace(3));
+
+  ThrowingConstructor result;
+  CHECK(queue.try_pop(result));
+  CHECK(result.value == 1);
+  CHECK(queue.pop().value == 2);
+  CHECK(!queue.try_pop(result));
+
+  // A later lap over the same cells still works.
+  for (int i = 0; i < 4; ++i) {
+    CHECK_THROWS_AS(queue.try_emplace(-i - 1), std::invalid_argument);
+    CHECK(queue.try_emplace(i));
+    CHECK(queue.pop().value == i);
+  }
+}
@@ -0,0 +1,135 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/object_pool.hpp>
+
+#include <cstddef>
+#include <future>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST_CASE("ObjectPool example", "[lockables][ObjectPool]") {
+  lockables::ObjectPool<std::vector<char>> pool;
+  {
+    auto buffer = pool.acquire();
+    auto guard = buffer->with_exclusive();
+
+    // The value may be left over from an earlier use.
+    guard->clear();
+    guard->resize(4096);
+  }
+
+  CHECK(pool.size() == 1);
+
+  // Same object, the capacity is still there.
+  auto buffer = pool.acquire();
+  CHECK(buffer->with_shared()->capacity() >= 4096);
+  CHECK(pool.size() == 1);
+}
+
+TEST_CASE("ObjectPool recycles objects", "[lockables][ObjectPool]") {
+  using Pool = lockables::ObjectPool<int>;
+  Pool pool;
+
+  // Enough objects to spill several batches to the global free list and take
+  // them back.
+  constexpr std::size_t kNumObject = Pool::kBatchSize * 5 + 3;
+
+  std::set<const Pool::value_type*> first;
+  {
+    std::vector<Pool::Handle> handles;
+    for (std::size_t i = 0; i < kNumObject; ++i) {
+      handles.push_back(pool.acquire());
+      first.insert(handles.back().get());
+    }
+  }
+
+  CHECK(first.size() == kNumObject);
+  CHECK(pool.size() == kNumObject);
+
+  std::set<const Pool::value_type*> second;
+  {
+    std::vector<Pool::Handle> handles;
+    for (std::size_t i = 0; i < kNumObject; ++i) {
+      handles.push_back(pool.acquire());
+      second.insert(handles.back().get());
+    }
+  }
+
+  CHECK(second == first);
+  CHECK(pool.size() == kNumObject);
+}
+
+TEST_CASE("ObjectPool thread exit", "[lockables][ObjectPool]") {
+  using Pool = lockables::ObjectPool<int>;
+  Pool pool;
+
+  // The objects released on another thread go back to the global list when
+  // that thread exits.
+  constexpr std::size_t kNumObject = 10;
+  std::thread thread{[&pool]() {
+    std::vector<Pool::Handle> handles;
+    for (std::size_t i = 0; i < kNumObject; ++i) {
+      handles.push_back(pool.acquire());
+    }
+  }};
+  thread.join();
+
+  std::vector<Pool::Handle> handles;
+  for (std::size_t i = 0; i < kNumObject; ++i) {
+    handles.push_back(pool.acquire());
+  }
+
+  CHECK(pool.size() == kNumObject);
+
+  // Use a pool on this thread after it is gone.
+  {
+    Pool other;
+    auto handle = other.acquire();
+  }
+  {
+    Pool other;
+    auto handle = other.acquire();
+    CHECK(other.size() == 1);
+  }
+}
+
+TEST_CASE("ObjectPool threads", "[lockables][ObjectPool]") {
+  using Pool = lockables::ObjectPool<int>;
+  Pool pool;
+
+  constexpr std::size_t kNumThread = 4;
+  constexpr std::size_t kNumIteration = 1000;
+  constexpr std::size_t kNumHeld = Pool::kBatchSize * 3;
+
+  std::vector<std::future<bool>> futures;
+  for (std::size_t i = 0; i < kNumThread; ++i) {
+    futures.push_back(std::async(std::launch::async, [&pool]() {
+      bool ok = true;
+      for (std::size_t n = 0; n < kNumIteration; ++n) {
+        std::vector<Pool::Handle> handles;
+        for (std::size_t j = 0; j < kNumHeld; ++j) {
+          handles.push_back(pool.acquire());
+          // Nobody else holds this object. Leave it at zero on release.
+          auto guard = handles.back()->with_exclusive();
+          ok = ok && *guard == 0;
+          *guard = 1;
+        }
+
+        for (auto& handle : handles) {
+          *handle->with_exclusive() = 0;
+        }
+      }
+
+      return ok;
+    }));
+  }
+
+  for (auto& future : futures) {
+    CHECK(future.get());
+  }
+
+  // A new object is only created when the global list is empty. Each thread
+  // holds at most kNumHeld objects, caches at most two batches, and may have
+  // one more batch in transit.
+  CHECK(pool.size() <= kNumThread * (kNumHeld + 3 * Pool::kBatchSize));
+}
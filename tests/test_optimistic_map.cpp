@@ -0,0 +1,200 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/optimistic_map.hpp>
+
+#include <cstdint>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("OptimisticMap example", "[lockables][OptimisticMap]") {
+  lockables::OptimisticMap<int64_t, int64_t> map{1024};
+
+  // Writer locks the bucket for key 1. Inserts Value{} if the key is missing.
+  map.with_exclusive(1, [](int64_t& value) { value += 10; });
+
+  // Reader does not lock.
+  int64_t copy = 0;
+  const bool found =
+      map.with_shared(1, [&copy](const int64_t& value) { copy = value; });
+
+  CHECK(found);
+  CHECK(copy == 10);
+}
+
+TEST_CASE("OptimisticMap insert, find, erase", "[lockables][OptimisticMap]") {
+  lockables::OptimisticMap<int, int> map{100};
+  CHECK(map.capacity() == 128);
+  CHECK(map.size() == 0);
+  CHECK(!map.find(1));
+
+  for (int i = 0; i < 100; ++i) {
+    const int result = map.with_exclusive(i, [i](int& value) {
+      value = i * 2;
+      return value;
+    });
+    CHECK(result == i * 2);
+  }
+
+  CHECK(map.size() == 100);
+
+  for (int i = 0; i < 100; ++i) {
+    const auto value = map.find(i);
+    REQUIRE(value);
+    CHECK(*value == i * 2);
+  }
+
+  CHECK(!map.find(100));
+  CHECK(!map.with_shared(100, [](const int&) {}));
+
+  // Erase leaves a tombstone that the same key can reuse.
+  CHECK(map.erase(50));
+  CHECK(!map.erase(50));
+  CHECK(!map.erase(1000));
+  CHECK(!map.find(50));
+  CHECK(map.size() == 99);
+
+  // Value is reset when a key is inserted again.
+  map.with_exclusive(50, [](int& value) { CHECK(value == 0); });
+  CHECK(map.find(50) == 0);
+  CHECK(map.size() == 100);
+}
+
+TEST_CASE("OptimisticMap full", "[lockables][OptimisticMap]") {
+  lockables::OptimisticMap<int, int> map{4};
+
+  for (int i = 0; i < 4; ++i) {
+    map.with_exclusive(i, [](int& value) { value = 1; });
+  }
+
+  // Existing keys are still writable.
+  map.with_exclusive(3, [](int& value) { value = 2; });
+  CHECK(map.find(3) == 2);
+
+  CHECK_THROWS_AS(map.with_exclusive(4, [](int&) {}), std::length_error);
+  CHECK(map.size() == 4);
+}
+
+TEST_CASE("OptimisticMap key churn", "[lockables][OptimisticMap]") {
+  constexpr int kCapacity = 64;
+
+  lockables::OptimisticMap<int, int> map{kCapacity};
+
+  // Distinct keys, far more than the capacity. Erased keys leave tombstones
+  // that new keys reuse.
+  for (int key = 0; key < 100 * kCapacity; ++key) {
+    map.with_exclusive(key, [key](int& value) { value = key; });
+    REQUIRE(map.find(key) == key);
+    REQUIRE(map.erase(key));
+  }
+
+  CHECK(map.size() == 0);
+
+  for (int key = 0; key < kCapacity; ++key) {
+    map.with_exclusive(key, [key](int& value) { value = key; });
+  }
+
+  CHECK(map.size() == kCapacity);
+  for (int key = 0; key < kCapacity; ++key) {
+    CHECK(map.find(key) == key);
+  }
+}
+
+TEST_CASE("OptimisticMap key churn threads", "[lockables][OptimisticMap]") {
+  constexpr int64_t kNumThread = 4;
+  constexpr int64_t kNumLive = 16;
+  constexpr int64_t kNumIteration = 20000;
+  constexpr int64_t kShared = -1;
+
+  lockables::OptimisticMap<int64_t, int64_t> map{128};
+
+  // Each thread inserts distinct keys and erases them kNumLive later. All
+  // threads also add to one shared key. A key placed in two buckets would
+  // lose some of the increments.
+  const auto func = [&map, kShared](int64_t thread) {
+    const int64_t first = thread * kNumIteration;
+    for (int64_t i = 0; i < kNumIteration; ++i) {
+      map.with_exclusive(first + i, [](int64_t& value) { value = 1; });
+      if (i >= kNumLive) {
+        map.erase(first + i - kNumLive);
+      }
+      map.with_exclusive(kShared, [](int64_t& value) { ++value; });
+    }
+  };
+
+  std::vector<std::future<void>> futures;
+  for (int64_t thread = 0; thread < kNumThread; ++thread) {
+    futures.push_back(std::async(std::launch::async, func, thread));
+  }
+  for (auto& future : futures) {
+    future.wait();
+  }
+
+  CHECK(map.find(kShared) == kNumThread * kNumIteration);
+  CHECK(map.size() == kNumThread * kNumLive + 1);
+  for (int64_t thread = 0; thread < kNumThread; ++thread) {
+    const int64_t last = (thread + 1) * kNumIteration;
+    for (int64_t key = last - kNumLive; key < last; ++key) {
+      CHECK(map.find(key) == 1);
+    }
+    CHECK(!map.find(last - kNumLive - 1));
+  }
+}
+
+TEST_CASE("OptimisticMap M reader threads, N writer threads",
+          "[lockables][OptimisticMap]") {
+  constexpr int64_t kNumKey = 1000;
+  constexpr int kNumWriter = 4;
+  constexpr int kNumReader = 4;
+  constexpr int kNumIteration = 10;
+
+  lockables::OptimisticMap<int64_t, int64_t> map{4 * kNumKey};
+
+  // Writers increment every key. Value is (count << 32) | key so readers can
+  // detect a torn read.
+  const auto writer_func = [&map]() {
+    for (int n = 0; n < kNumIteration; ++n) {
+      for (int64_t key = 0; key < kNumKey; ++key) {
+        map.with_exclusive(key, [key](int64_t& value) {
+          value = (((value >> 32) + 1) << 32) | key;
+        });
+      }
+    }
+  };
+
+  const auto reader_func = [&map]() {
+    int num_torn = 0;
+    for (int n = 0; n < kNumIteration; ++n) {
+      for (int64_t key = 0; key < kNumKey; ++key) {
+        map.with_shared(key, [&num_torn, key](const int64_t& value) {
+          if ((value & 0xFFFFFFFF) != key) {
+            ++num_torn;
+          }
+        });
+      }
+    }
+    return num_torn;
+  };
+
+  std::vector<std::future<void>> writers;
+  std::vector<std::future<int>> readers;
+  for (int i = 0; i < kNumWriter; ++i) {
+    writers.push_back(std::async(std::launch::async, writer_func));
+  }
+  for (int i = 0; i < kNumReader; ++i) {
+    readers.push_back(std::async(std::launch::async, reader_func));
+  }
+
+  for (auto& future : writers) {
+    future.wait();
+  }
+  for (auto& future : readers) {
+    CHECK(future.get() == 0);
+  }
+
+  CHECK(map.size() == kNumKey);
+  for (int64_t key = 0; key < kNumKey; ++key) {
+    const auto value = map.find(key);
+    REQUIRE(value);
+    CHECK((*value >> 32) == kNumWriter * kNumIteration);
+  }
+}
@@ -0,0 +1,135 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/owned_mutex.hpp>
+
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+namespace {
+
+bool is_deadlock(const std::system_error& error) {
+  return error.code() == std::errc::resource_deadlock_would_occur;
+}
+
+struct Violation : std::runtime_error {
+  explicit Violation(const lockables::LockViolation& violation)
+      : std::runtime_error{"violation"}, kind{violation.kind} {}
+
+  lockables::LockViolation::Kind kind;
+};
+
+[[noreturn]] void throw_violation(const lockables::LockViolation& violation) {
+  throw Violation{violation};
+}
+
+}  // namespace
+
+TEST_CASE("OwnedMutex example", "[lockables][OwnedMutex]") {
+  using lockables::LockName;
+
+  lockables::Guarded<int, lockables::owned_mutex_t<std::mutex>> value{
+      LockName{"value"}};
+
+  {
+    auto guard = value.with_exclusive();
+
+    // Throws std::system_error instead of a deadlock.
+    try {
+      auto recursive = value.with_exclusive();
+      FAIL("recursive lock did not throw");
+    } catch (const std::system_error& error) {
+      CHECK(is_deadlock(error));
+      CHECK(std::string{error.what()}.find("\"value\"") != std::string::npos);
+    }
+
+    // Also through the reader path.
+    CHECK_THROWS_AS(value.with_shared(), std::system_error);
+
+    *guard = 10;
+  }
+
+  // Still usable after the violation.
+  CHECK(*value.with_shared() == 10);
+}
+
+TEST_CASE("OwnedMutex shared", "[lockables][OwnedMutex]") {
+  using Mutex = lockables::OwnedMutex<std::shared_mutex>;
+  static_assert(std::is_same_v<lockables::shared_lock_t<Mutex>,
+                               std::shared_lock<Mutex>>);
+
+  lockables::Guarded<int, Mutex> value{1};
+
+  {
+    auto writer = value.with_exclusive();
+    CHECK_THROWS_AS(value.with_shared(), std::system_error);
+    CHECK_THROWS_AS(value.with_exclusive(), std::system_error);
+  }
+
+  // Readers are not owners.
+  {
+    const auto reader = value.with_shared();
+    auto other = std::async(std::launch::async,
+                            [&]() { return *value.with_shared(); });
+    CHECK(other.get() == 1);
+  }
+}
+
+TEST_CASE("OwnedMutex owner", "[lockables][OwnedMutex]") {
+  lockables::OwnedMutex<std::mutex> mutex;
+  CHECK(!mutex.owned_by_this_thread());
+
+  mutex.lock();
+  CHECK(mutex.owned_by_this_thread());
+
+  // Another thread is not the owner, try_lock fails as usual.
+  auto other = std::async(std::launch::async, [&mutex]() {
+    return !mutex.owned_by_this_thread() && !mutex.try_lock();
+  });
+  CHECK(other.get());
+
+  // The owner fails fast, even with try_lock.
+  CHECK_THROWS_AS(mutex.try_lock(), std::system_error);
+
+  mutex.unlock();
+  CHECK(!mutex.owned_by_this_thread());
+
+  auto owner = std::async(std::launch::async, [&mutex]() {
+    std::scoped_lock lock{mutex};
+    return mutex.owned_by_this_thread();
+  });
+  CHECK(owner.get());
+  CHECK(!mutex.owned_by_this_thread());
+}
+
+TEST_CASE("OwnedMutex handler", "[lockables][OwnedMutex]") {
+  using Mutex = lockables::OwnedMutex<std::shared_mutex>;
+
+  const auto previous = lockables::set_lock_violation_handler(&throw_violation);
+
+  lockables::Guarded<int, Mutex> value1{1};
+  lockables::Guarded<int, Mutex> value2{2};
+
+  {
+    auto guard = value1.with_exclusive();
+    try {
+      const auto reader = value1.with_shared();
+      FAIL("shared lock did not throw");
+    } catch (const Violation& violation) {
+      CHECK(violation.kind ==
+            lockables::LockViolation::Kind::kSharedWhileExclusive);
+    }
+  }
+
+  // The same value twice in the free with_exclusive function.
+  const auto sum = [](int& x, int& y) { return x + y; };
+  CHECK(lockables::with_exclusive(sum, value1, value2) == 3);
+  CHECK_THROWS_AS(lockables::with_exclusive(sum, value1, value1), Violation);
+  CHECK(lockables::with_exclusive(sum, value2, value1) == 3);
+
+  CHECK(lockables::set_lock_violation_handler(previous) == &throw_violation);
+}
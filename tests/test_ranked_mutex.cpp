@@ -0,0 +1,165 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/ranked_mutex.hpp>
+
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+// Checked in every build type.
+template <unsigned Rank, typename Mutex = std::mutex>
+using CheckedRank = lockables::RankedMutex<Rank, Mutex, true>;
+
+struct Accounts {
+  int balance{};
+};
+
+struct Ledger {
+  int entries{};
+};
+
+// Single threaded log of lock and unlock calls.
+std::vector<int>& lock_log() {
+  static std::vector<int> log;
+  return log;
+}
+
+int& failing_id() {
+  static int id = 0;
+  return id;
+}
+
+template <int Id>
+class LoggingMutex {
+ public:
+  void lock() {
+    if (failing_id() == Id) {
+      throw std::runtime_error{"lock failed"};
+    }
+    mutex_.lock();
+    lock_log().push_back(Id);
+  }
+
+  bool try_lock() {
+    lock();
+    return true;
+  }
+
+  void unlock() {
+    lock_log().push_back(-Id);
+    mutex_.unlock();
+  }
+
+ private:
+  std::mutex mutex_;
+};
+
+}  // namespace
+
+TEST_CASE("RankedMutex example", "[lockables][RankedMutex]") {
+  // Lower ranks are locked first.
+  lockables::Guarded<Accounts, CheckedRank<1>> accounts;
+  lockables::Guarded<Ledger, CheckedRank<2>> ledger;
+
+  // Locks accounts and then ledger, in any argument order.
+  lockables::with_exclusive(
+      [](Ledger& x, Accounts& y) {
+        x.entries += 1;
+        y.balance += 10;
+      },
+      ledger, accounts);
+
+  {
+    auto guard = ledger.with_exclusive();
+
+    // Checked builds throw std::system_error, rank 1 after rank 2.
+    try {
+      auto nested = accounts.with_exclusive();
+      FAIL("nested lock of a lower rank did not throw");
+    } catch (const std::system_error& error) {
+      CHECK(error.code() == std::errc::resource_deadlock_would_occur);
+    }
+  }
+
+  CHECK(accounts.with_shared()->balance == 10);
+  CHECK(ledger.with_shared()->entries == 1);
+}
+
+TEST_CASE("RankedMutex lock order", "[lockables][RankedMutex]") {
+  using Lock = lockables::exclusive_lock_t<
+      lockables::RankedMutex<30, LoggingMutex<3>>,
+      lockables::RankedMutex<10, LoggingMutex<1>>>;
+  static_assert(
+      std::is_same_v<Lock, lockables::RankedLock<
+                               lockables::RankedMutex<30, LoggingMutex<3>>,
+                               lockables::RankedMutex<10, LoggingMutex<1>>>>);
+  static_assert(std::is_same_v<lockables::exclusive_lock_t<std::mutex>,
+                               std::scoped_lock<std::mutex>>);
+
+  lockables::Guarded<int, CheckedRank<30, LoggingMutex<3>>> value3{3};
+  lockables::Guarded<int, CheckedRank<10, LoggingMutex<1>>> value1{1};
+  lockables::Guarded<int, CheckedRank<20, LoggingMutex<2>>> value2{2};
+
+  lock_log().clear();
+  const int sum = lockables::with_exclusive(
+      [](int& x, int& y, int& z) { return x + y + z; }, value3, value1,
+      value2);
+  CHECK(sum == 6);
+
+  // Ascending rank order, then unlock in reverse.
+  CHECK(lock_log() == std::vector<int>{1, 2, 3, -3, -2, -1});
+
+  // Unlock what was locked if a lock throws.
+  lock_log().clear();
+  failing_id() = 2;
+  CHECK_THROWS_AS(lockables::with_exclusive([](int&, int&, int&) {}, value1,
+                                            value2, value3),
+                  std::runtime_error);
+  failing_id() = 0;
+  CHECK(lock_log() == std::vector<int>{1, -1});
+}
+
+TEST_CASE("RankedMutex nested", "[lockables][RankedMutex]") {
+  using Mutex = CheckedRank<20, std::shared_mutex>;
+  static_assert(std::is_same_v<lockables::shared_lock_t<Mutex>,
+                               std::shared_lock<Mutex>>);
+
+  lockables::Guarded<int, CheckedRank<10>> low{10};
+  lockables::Guarded<int, Mutex> middle{20};
+  lockables::Guarded<int, Mutex> same{20};
+  lockables::Guarded<int, CheckedRank<30>> high{30};
+
+  {
+    const auto guard = middle.with_shared();
+
+    // Higher is ok, lower or equal may deadlock.
+    CHECK(*high.with_shared() == 30);
+    CHECK_THROWS_AS(low.with_exclusive(), std::system_error);
+    CHECK_THROWS_AS(same.with_shared(), std::system_error);
+    CHECK_THROWS_AS(lockables::with_exclusive([](int&) {}, low),
+                    std::system_error);
+
+    // A try_lock cannot deadlock.
+    CheckedRank<10> mutex;
+    CHECK(mutex.try_lock());
+    mutex.unlock();
+  }
+
+  // Released, start over from the lowest rank.
+  {
+    auto guard = low.with_exclusive();
+    CHECK(*middle.with_shared() == 20);
+  }
+
+  // Unchecked, no thread local state.
+  lockables::Guarded<int, lockables::RankedMutex<1, std::mutex, false>> first;
+  {
+    const auto guard = middle.with_shared();
+    CHECK(*first.with_shared() == 0);
+  }
+}
@@ -0,0 +1,188 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/serial_guarded.hpp>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("SerialGuarded example", "[lockables][SerialGuarded]") {
+  lockables::ThreadPool pool;
+  lockables::SerialGuarded<int> value{pool, 9};
+
+  std::future<int> result = lockables::async_with_exclusive(
+      [](int& x) {
+        // Runs on a pool thread with exclusive access to value.
+        x += 10;
+        return x;
+      },
+      value);
+
+  CHECK(result.get() == 19);
+}
+
+TEST_CASE("async_with_exclusive multiple example",
+          "[lockables][SerialGuarded][async_with_exclusive]") {
+  lockables::ThreadPool pool;
+  lockables::SerialGuarded<int> value1{pool, 1};
+  lockables::SerialGuarded<int> value2{pool, 2};
+
+  auto future = lockables::async_with_exclusive(
+      [](int& x, int& y) {
+        // Writer with exclusive access to value1 and value2.
+        x += y;
+        y /= 2;
+        return x;
+      },
+      value1, value2);
+
+  CHECK(future.get() == 3);
+}
+
+TEST_CASE("ThreadPool runs posted tasks", "[lockables][ThreadPool]") {
+  constexpr int kNumTask = 1000;
+
+  std::atomic<int> count{0};
+  {
+    lockables::ThreadPool pool{4};
+    CHECK(pool.size() == 4);
+
+    for (int i = 0; i < kNumTask; ++i) {
+      pool.post([&count]() { count += 1; });
+    }
+
+    // Destructor runs all of the queued tasks.
+  }
+
+  CHECK(count == kNumTask);
+}
+
+TEST_CASE("Strand runs tasks in order, one at a time",
+          "[lockables][ThreadPool][Strand]") {
+  constexpr int kNumTask = 1000;
+
+  std::vector<int> order;
+  std::atomic<int> running{0};
+  std::atomic<bool> overlap{false};
+  {
+    // The strand must outlive the pool, which runs all of the queued tasks in
+    // its destructor.
+    auto pool = std::make_unique<lockables::ThreadPool>(4);
+    lockables::Strand<> strand{*pool};
+
+    for (int i = 0; i < kNumTask; ++i) {
+      strand.post([&, i]() {
+        if (running.fetch_add(1) != 0) {
+          overlap = true;
+        }
+        order.push_back(i);
+        running.fetch_sub(1);
+      });
+    }
+
+    pool.reset();
+  }
+
+  CHECK(!overlap);
+  REQUIRE(order.size() == kNumTask);
+  for (int i = 0; i < kNumTask; ++i) {
+    CHECK(order[static_cast<std::size_t>(i)] == i);
+  }
+}
+
+TEST_CASE("async_with_exclusive from many threads",
+          "[lockables][SerialGuarded][async_with_exclusive]") {
+  constexpr int kNumIteration = 1000;
+  constexpr int kNumThread = 4;
+
+  lockables::ThreadPool pool{4};
+  lockables::SerialGuarded<int> value1{pool, 0};
+  lockables::SerialGuarded<int> value2{pool, 0};
+  lockables::SerialGuarded<std::string> value3{pool};
+
+  const auto client = [&]() {
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < kNumIteration; ++i) {
+      futures.push_back(
+          lockables::async_with_exclusive([](int& x) { x += 1; }, value1));
+
+      // Move one unit from value1 to value2. Alternate the argument order.
+      if (i % 2 == 0) {
+        futures.push_back(lockables::async_with_exclusive(
+            [](int& x, int& y) {
+              x -= 1;
+              y += 1;
+            },
+            value1, value2));
+      } else {
+        futures.push_back(lockables::async_with_exclusive(
+            [](std::string& str, int& y, int& x) {
+              str.push_back('.');
+              x -= 1;
+              y += 1;
+            },
+            value3, value2, value1));
+      }
+    }
+
+    for (auto& future : futures) {
+      future.wait();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThread; ++i) {
+    threads.emplace_back(client);
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto result = lockables::async_with_exclusive(
+      [](int& x, int& y, std::string& str) {
+        return x == 0 && y == kNumThread * kNumIteration &&
+               str.size() == kNumThread * kNumIteration / 2;
+      },
+      value1, value2, value3);
+
+  CHECK(result.get());
+}
+
+TEST_CASE("async_with_exclusive propagates exceptions",
+          "[lockables][SerialGuarded][async_with_exclusive]") {
+  lockables::ThreadPool pool{2};
+  lockables::SerialGuarded<int> value{pool, 1};
+
+  auto future = lockables::async_with_exclusive(
+      [](int& x) -> int {
+        if (x == 1) {
+          throw std::runtime_error{"oops"};
+        }
+        return x;
+      },
+      value);
+
+  CHECK_THROWS_AS(future.get(), std::runtime_error);
+
+  // The strand was released.
+  auto next = lockables::async_with_exclusive([](int& x) { return x + 1; },
+                                              value);
+  CHECK(next.get() == 2);
+}
+
+TEST_CASE("async_with_exclusive returns a reference",
+          "[lockables][SerialGuarded][async_with_exclusive]") {
+  lockables::ThreadPool pool{2};
+  lockables::SerialGuarded<int> value{pool, 1};
+
+  // No! Same as with_exclusive, the user must not keep a reference to the
+  // guarded value. But it is allowed to compile.
+  auto future =
+      lockables::async_with_exclusive([](int& x) -> int& { return x; }, value);
+
+  [[maybe_unused]] int& unguarded_reference = future.get();
+}
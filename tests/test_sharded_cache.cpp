@@ -0,0 +1,118 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/sharded_cache.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("ShardedCache example", "[lockables][ShardedCache]") {
+  lockables::ShardedCache<std::string, std::string> cache{1024};
+
+  int num_call = 0;
+  const auto load = [&num_call](const std::string& path) {
+    ++num_call;
+    return "contents of " + path;
+  };
+
+  CHECK(cache.get_or_compute("logo.png", load) == "contents of logo.png");
+  CHECK(cache.get_or_compute("logo.png", load) == "contents of logo.png");
+  CHECK(num_call == 1);
+
+  CHECK(cache.get("logo.png") == "contents of logo.png");
+  CHECK(!cache.get("missing.png"));
+}
+
+TEST_CASE("ShardedCache put, get, erase", "[lockables][ShardedCache]") {
+  lockables::ShardedCache<int, int> cache{100, 4};
+  CHECK(cache.num_shard() == 4);
+  CHECK(cache.capacity() == 100);
+  CHECK(cache.size() == 0);
+
+  cache.put(1, 10);
+  cache.put(2, 20);
+  cache.put(1, 11);
+  CHECK(cache.size() == 2);
+  CHECK(cache.get(1) == 11);
+  CHECK(cache.get(2) == 20);
+
+  CHECK(cache.erase(1));
+  CHECK(!cache.erase(1));
+  CHECK(!cache.get(1));
+  CHECK(cache.get(2) == 20);
+  CHECK(cache.size() == 1);
+
+  // Never holds more than its capacity.
+  for (int key = 0; key < 1000; ++key) {
+    cache.put(key, key);
+  }
+  CHECK(cache.size() == 100);
+}
+
+TEST_CASE("ShardedCache CLOCK eviction", "[lockables][ShardedCache]") {
+  // One shard so the eviction order is easy to follow.
+  lockables::ShardedCache<int, int> cache{4, 1};
+
+  for (int key = 0; key < 4; ++key) {
+    cache.put(key, key);
+  }
+
+  // Hits set the reference bit and give keys 0 and 2 a second chance.
+  CHECK(cache.get(0));
+  CHECK(cache.get(2));
+
+  cache.put(4, 4);
+  CHECK(!cache.get(1));
+
+  cache.put(5, 5);
+  CHECK(!cache.get(3));
+
+  CHECK(cache.get(0) == 0);
+  CHECK(cache.get(2) == 2);
+  CHECK(cache.get(4) == 4);
+  CHECK(cache.get(5) == 5);
+}
+
+TEST_CASE("ShardedCache get_or_compute deduplicates misses",
+          "[lockables][ShardedCache]") {
+  constexpr int kNumThread = 8;
+
+  lockables::ShardedCache<int, int> cache{64};
+  std::atomic<int> num_call{};
+
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < kNumThread; ++i) {
+    results.push_back(std::async(std::launch::async, [&cache, &num_call]() {
+      return cache.get_or_compute(7, [&num_call](const int& key) {
+        ++num_call;
+        // Slow enough that the other threads see the pending result.
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        return key * 2;
+      });
+    }));
+  }
+
+  for (auto& result : results) {
+    CHECK(result.get() == 14);
+  }
+
+  CHECK(num_call == 1);
+}
+
+TEST_CASE("ShardedCache get_or_compute exception",
+          "[lockables][ShardedCache]") {
+  lockables::ShardedCache<int, int> cache{64};
+
+  CHECK_THROWS_AS(cache.get_or_compute(
+                      1, [](const int&) -> int {
+                        throw std::runtime_error{"compute failed"};
+                      }),
+                  std::runtime_error);
+
+  // Nothing was cached and the next caller computes again.
+  CHECK(!cache.get(1));
+  CHECK(cache.get_or_compute(1, [](const int& key) { return key + 1; }) == 2);
+}
@@ -0,0 +1,136 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/skip_list.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST_CASE("SkipList example", "[lockables][SkipList]") {
+  lockables::SkipList<int, std::string> map;
+
+  CHECK(map.insert(1, "one"));
+  CHECK(map.insert(3, "three"));
+
+  CHECK(map.find(1) == "one");
+
+  // Visit the keys in [1, 3) in order.
+  std::vector<int> keys;
+  map.for_each(1, 3, [&keys](const int& key, const std::string&) {
+    keys.push_back(key);
+  });
+  CHECK(keys == std::vector<int>{1});
+
+  CHECK(map.erase(1));
+  CHECK(!map.find(1));
+}
+
+TEST_CASE("SkipList ordered map", "[lockables][SkipList]") {
+  lockables::SkipList<int, int> map;
+  CHECK(map.empty());
+  CHECK(!map.lower_bound(0));
+
+  // Insert in a scrambled order.
+  for (int i = 0; i < 1000; ++i) {
+    const int key = (i * 7919) % 1000;
+    CHECK(map.insert(key * 2, key));
+  }
+
+  CHECK(map.size() == 1000);
+  CHECK(!map.insert(10, -1));
+  CHECK(map.find(10) == 5);
+  CHECK(!map.find(11));
+  CHECK(map.contains(1998));
+  CHECK(!map.contains(2000));
+
+  CHECK(map.lower_bound(11) == std::pair<int, int>{12, 6});
+  CHECK(map.lower_bound(12) == std::pair<int, int>{12, 6});
+  CHECK(!map.lower_bound(1999));
+
+  // Erase every other key.
+  for (int key = 0; key < 2000; key += 4) {
+    CHECK(map.erase(key));
+  }
+  CHECK(!map.erase(0));
+  CHECK(!map.erase(1));
+  CHECK(map.size() == 500);
+  CHECK(map.lower_bound(0) == std::pair<int, int>{2, 1});
+
+  std::vector<int> keys;
+  map.for_each([&keys](const int& key, const int& value) {
+    CHECK(key == value * 2);
+    keys.push_back(key);
+  });
+
+  REQUIRE(keys.size() == 500);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    CHECK(keys[i] == static_cast<int>(i) * 4 + 2);
+  }
+
+  int sum = 0;
+  map.for_each(100, 120, [&sum](const int&, const int& value) {
+    sum += value;
+  });
+  // Keys 102, 106, 110, 114, 118
+  CHECK(sum == 51 + 53 + 55 + 57 + 59);
+}
+
+TEST_CASE("SkipList threads", "[lockables][SkipList]") {
+  constexpr int kNumWriter = 4;
+  constexpr int kNumKey = 2000;
+
+  lockables::SkipList<int, int> map;
+  std::atomic<bool> done{};
+
+  // Scans never see keys out of order.
+  auto reader = std::async(std::launch::async, [&map, &done]() {
+    bool in_order = true;
+    while (!done.load()) {
+      int last = -1;
+      map.for_each([&in_order, &last](const int& key, const int& value) {
+        in_order = in_order && key > last && key == value;
+        last = key;
+      });
+    }
+    return in_order;
+  });
+
+  // Each writer owns the keys equal to its index mod kNumWriter. Insert all,
+  // erase the odd ones, insert them again, erase them again.
+  std::vector<std::future<bool>> writers;
+  for (int i = 0; i < kNumWriter; ++i) {
+    writers.push_back(std::async(std::launch::async, [&map, i]() {
+      bool valid = true;
+      for (int round = 0; round < 3; ++round) {
+        for (int key = i; key < kNumKey; key += kNumWriter) {
+          if (round == 0 || key % 2 == 1) {
+            valid = valid && map.insert(key, key) == (round != 2);
+          }
+        }
+        for (int key = i; key < kNumKey; key += kNumWriter) {
+          if (key % 2 == 1 && round != 1) {
+            valid = valid && map.erase(key);
+          }
+        }
+      }
+      return valid;
+    }));
+  }
+
+  for (auto& writer : writers) {
+    CHECK(writer.get());
+  }
+  done.store(true);
+
+  CHECK(reader.get());
+  CHECK(map.size() == kNumKey / 2);
+
+  int count = 0;
+  map.for_each([&count](const int& key, const int&) {
+    CHECK(key % 2 == 0);
+    ++count;
+  });
+  CHECK(count == kNumKey / 2);
+}
@@ -0,0 +1,97 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/snapshot.hpp>
+
+#include <cstddef>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Config {
+  std::string host{};
+  int port{};
+};
+
+}  // namespace
+
+TEST_CASE("Snapshot example", "[lockables][Snapshot]") {
+  lockables::Snapshot<Config> config{"localhost", 80};
+
+  {
+    // Reader. Never blocks, the value does not change while guard is alive.
+    auto guard = config.with_shared();
+
+    CHECK(guard->host == "localhost");
+    CHECK(guard->port == 80);
+
+    // Writer. Modify a copy of the current value.
+    config.update([](Config& copy) { copy.port = 8080; });
+
+    CHECK(guard->port == 80);
+  }
+
+  CHECK(config.load().port == 8080);
+}
+
+TEST_CASE("Snapshot update", "[lockables][Snapshot]") {
+  lockables::Snapshot<std::vector<int>> snapshot;
+
+  const auto size = snapshot.update([](std::vector<int>& copy) {
+    copy.push_back(1);
+    return copy.size();
+  });
+  CHECK(size == 1);
+
+  CHECK_THROWS_AS(snapshot.update([](std::vector<int>& copy) {
+    copy.push_back(2);
+    throw std::runtime_error{"failed"};
+  }),
+                  std::runtime_error);
+  CHECK(snapshot.load() == std::vector<int>{1});
+
+  snapshot.store(std::vector<int>{3, 4});
+  CHECK(snapshot.with_shared()->size() == 2);
+}
+
+TEST_CASE("Snapshot threads", "[lockables][Snapshot]") {
+  // The writer keeps the vector filled with one value. Readers check that
+  // every version they see is consistent.
+  lockables::Snapshot<std::vector<int>> snapshot{std::vector<int>(64, 0)};
+
+  constexpr std::size_t kNumReader = 3;
+  constexpr int kNumIteration = 1000;
+
+  auto writer = std::async(std::launch::async, [&]() {
+    for (int i = 1; i <= kNumIteration; ++i) {
+      snapshot.update([i](std::vector<int>& copy) {
+        for (int& x : copy) {
+          x = i;
+        }
+      });
+    }
+  });
+
+  std::vector<std::future<bool>> readers;
+  for (std::size_t i = 0; i < kNumReader; ++i) {
+    readers.push_back(std::async(std::launch::async, [&]() {
+      bool ok = true;
+      for (int n = 0; n < kNumIteration; ++n) {
+        const auto guard = snapshot.with_shared();
+        for (int x : *guard) {
+          ok = ok && x == guard->front();
+        }
+      }
+
+      return ok;
+    }));
+  }
+
+  writer.get();
+  for (auto& reader : readers) {
+    CHECK(reader.get());
+  }
+
+  CHECK(snapshot.load().front() == kNumIteration);
+}
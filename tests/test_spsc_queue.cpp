@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/spsc_queue.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Message {
+  int64_t id{};
+  std::array<char, 56> payload{};
+};
+
+}  // namespace
+
+TEST_CASE("SpscQueue example", "[lockables][SpscQueue]") {
+  lockables::SpscQueue<Message> queue{1024};
+
+  // Producer thread. Fill in the next slot in place.
+  if (Message* slot = queue.reserve()) {
+    slot->id = 1;
+    queue.commit();
+  }
+
+  // Consumer thread. Read the front slot in place.
+  const Message* front = queue.peek();
+  REQUIRE(front != nullptr);
+  CHECK(front->id == 1);
+  queue.release();
+
+  CHECK(queue.peek() == nullptr);
+}
+
+TEST_CASE("SpscQueue full and empty", "[lockables][SpscQueue]") {
+  lockables::SpscQueue<std::string> queue{3};
+  CHECK(queue.capacity() == 4);
+
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 4; ++i) {
+      CHECK(queue.try_push(std::to_string(i)));
+    }
+    CHECK(!queue.try_push("full"));
+    CHECK(queue.reserve() == nullptr);
+    CHECK(queue.size_approx() == 4);
+
+    std::string value;
+    for (int i = 0; i < 4; ++i) {
+      CHECK(queue.try_pop(value));
+      CHECK(value == std::to_string(i));
+    }
+    CHECK(!queue.try_pop(value));
+    CHECK(queue.peek() == nullptr);
+    CHECK(queue.size_approx() == 0);
+  }
+}
+
+TEST_CASE("SpscQueue batch", "[lockables][SpscQueue]") {
+  lockables::SpscQueue<int> queue{8};
+
+  const std::vector<int> input{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  CHECK(queue.try_push_n(input.begin(), input.size()) == 8);
+  CHECK(queue.try_push_n(input.begin(), input.size()) == 0);
+
+  std::vector<int> output(10);
+  CHECK(queue.try_pop_n(output.begin(), 3) == 3);
+  CHECK(queue.try_push_n(input.begin() + 8, 2) == 2);
+  CHECK(queue.try_pop_n(output.begin() + 3, 10) == 7);
+  CHECK(queue.try_pop_n(output.begin(), 10) == 0);
+  CHECK(output == input);
+}
+
+TEST_CASE("SpscQueue threads", "[lockables][SpscQueue]") {
+  constexpr int64_t kNumItem = 100000;
+
+  lockables::SpscQueue<Message> queue{64};
+
+  auto producer = std::async(std::launch::async, [&queue]() {
+    for (int64_t id = 1; id <= kNumItem;) {
+      if (Message* slot = queue.reserve()) {
+        slot->id = id++;
+        slot->payload.fill(static_cast<char>(id));
+        queue.commit();
+      }
+    }
+  });
+
+  int64_t expected = 1;
+  bool in_order = true;
+  while (expected <= kNumItem) {
+    if (const Message* front = queue.peek()) {
+      in_order = in_order && front->id == expected;
+      ++expected;
+      queue.release();
+    }
+  }
+
+  producer.get();
+  CHECK(in_order);
+  CHECK(queue.size_approx() == 0);
+}
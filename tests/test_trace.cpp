@@ -0,0 +1,44 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/instrumented_mutex.hpp>
+#include <lockables/trace.hpp>
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+TEST_CASE("Trace example", "[lockables][Trace]") {
+  using lockables::LockName;
+
+  // The probes are a nop without a tracer, and without LOCKABLES_ENABLE_USDT
+  // there are none. Either way the scopes work the same.
+  lockables::Guarded<int, lockables::InstrumentedMutex<std::shared_mutex>>
+      value{LockName{"value"}, 1};
+
+  {
+    auto guard = value.with_exclusive();
+    *guard += 1;
+  }
+
+  {
+    const auto guard = value.with_shared();
+    CHECK(*guard == 2);
+  }
+}
+
+TEST_CASE("Trace name", "[lockables][Trace]") {
+  using lockables::LockName;
+  using lockables::detail::trace_name;
+
+  lockables::InstrumentedMutex<std::mutex> named{LockName{"named"}};
+  CHECK(std::string{trace_name(named)} == "named");
+
+  lockables::InstrumentedMutex<std::mutex> unnamed;
+  CHECK(std::string{trace_name(unnamed)}.empty());
+
+  std::mutex mutex;
+  CHECK(trace_name(mutex) == nullptr);
+
+  int x = 0;
+  CHECK(lockables::detail::trace_lock_begin(&x, mutex) == &x);
+}
@@ -0,0 +1,109 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/triple_buffer.hpp>
+
+#include <array>
+#include <cstdint>
+#include <future>
+#include <string>
+
+namespace {
+
+struct Frame {
+  int64_t id{};
+  std::array<int64_t, 15> samples{};
+};
+
+// Every sample matches the id, so a torn frame is easy to spot.
+void fill(Frame& frame, int64_t id) {
+  frame.id = id;
+  frame.samples.fill(id);
+}
+
+bool is_complete(const Frame& frame) {
+  for (const auto sample : frame.samples) {
+    if (sample != frame.id) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE("TripleBuffer example", "[lockables][TripleBuffer]") {
+  lockables::TripleBuffer<Frame> frames;
+
+  // Writer thread. Fill in the back buffer, then publish it.
+  frames.write([](Frame& frame) { fill(frame, 1); });
+  frames.publish();
+
+  // Reader thread. The freshest complete frame.
+  {
+    auto frame = frames.read();
+    CHECK(frame->id == 1);
+    CHECK(is_complete(*frame));
+  }
+}
+
+TEST_CASE("TripleBuffer latest value", "[lockables][TripleBuffer]") {
+  lockables::TripleBuffer<std::string> buffer{"initial"};
+
+  // Nothing published yet.
+  CHECK(!buffer.has_fresh());
+  CHECK(*buffer.read() == "initial");
+
+  // Not visible until publish.
+  buffer.write([](std::string& value) { value = "first"; });
+  CHECK(*buffer.read() == "initial");
+
+  buffer.publish();
+  CHECK(buffer.has_fresh());
+  CHECK(*buffer.read() == "first");
+  CHECK(!buffer.has_fresh());
+
+  // Read again without a new value.
+  CHECK(*buffer.read() == "first");
+
+  // The reader skips values that were replaced before it read them.
+  for (int i = 0; i < 5; ++i) {
+    const auto size = buffer.write([i](std::string& value) {
+      value = std::to_string(i);
+      return value.size();
+    });
+    CHECK(size == 1);
+    buffer.publish();
+  }
+
+  CHECK(*buffer.read() == "4");
+  CHECK(*buffer.read() == "4");
+}
+
+TEST_CASE("TripleBuffer threads", "[lockables][TripleBuffer]") {
+  constexpr int64_t kNumFrame = 100000;
+
+  lockables::TripleBuffer<Frame> frames;
+
+  auto writer = std::async(std::launch::async, [&]() {
+    for (int64_t id = 1; id <= kNumFrame; ++id) {
+      frames.write([id](Frame& frame) { fill(frame, id); });
+      frames.publish();
+    }
+  });
+
+  // The reader sees complete frames with ids that never go backwards.
+  auto reader = std::async(std::launch::async, [&]() {
+    bool ok = true;
+    int64_t last = 0;
+    while (last < kNumFrame) {
+      const auto frame = frames.read();
+      ok = ok && is_complete(*frame) && frame->id >= last;
+      last = frame->id;
+    }
+
+    return ok;
+  });
+
+  writer.get();
+  CHECK(reader.get());
+}
@@ -0,0 +1,97 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/work_stealing_deque.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+TEST_CASE("WorkStealingDeque example", "[lockables][WorkStealingDeque]") {
+  lockables::WorkStealingDeque<int> deque;
+
+  // Owner thread.
+  deque.push(1);
+  deque.push(2);
+  deque.push(3);
+  CHECK(deque.size_approx() == 3);
+
+  // Owner pops the newest value.
+  CHECK(deque.pop() == 3);
+
+  // Thief steals the oldest value.
+  CHECK(deque.steal() == 1);
+
+  CHECK(deque.pop() == 2);
+  CHECK(!deque.pop());
+  CHECK(!deque.steal());
+  CHECK(deque.empty_approx());
+}
+
+TEST_CASE("WorkStealingDeque grow", "[lockables][WorkStealingDeque]") {
+  lockables::WorkStealingDeque<int> deque{2};
+
+  // Wrap the circular array before it grows.
+  deque.push(0);
+  CHECK(deque.steal() == 0);
+
+  for (int i = 1; i <= 1000; ++i) {
+    deque.push(i);
+  }
+  CHECK(deque.size_approx() == 1000);
+
+  for (int i = 1; i <= 500; ++i) {
+    CHECK(deque.steal() == i);
+  }
+  for (int i = 1000; i > 500; --i) {
+    CHECK(deque.pop() == i);
+  }
+  CHECK(!deque.pop());
+}
+
+TEST_CASE("WorkStealingDeque threads", "[lockables][WorkStealingDeque]") {
+  constexpr int kNumThief = 4;
+  constexpr int64_t kNumItem = 100000;
+
+  // Start small so the owner grows the array while thieves are stealing.
+  lockables::WorkStealingDeque<int64_t> deque{4};
+  std::atomic<bool> done{};
+
+  std::vector<std::future<int64_t>> thieves;
+  for (int i = 0; i < kNumThief; ++i) {
+    thieves.push_back(std::async(std::launch::async, [&deque, &done]() {
+      int64_t sum = 0;
+      for (;;) {
+        if (auto value = deque.steal()) {
+          sum += *value;
+        } else if (done.load() && deque.empty_approx()) {
+          break;
+        }
+      }
+      return sum;
+    }));
+  }
+
+  // Owner pushes and pops at the same time.
+  int64_t sum = 0;
+  for (int64_t value = 1; value <= kNumItem; ++value) {
+    deque.push(value);
+    if (value % 3 == 0) {
+      if (auto popped = deque.pop()) {
+        sum += *popped;
+      }
+    }
+  }
+
+  while (auto popped = deque.pop()) {
+    sum += *popped;
+  }
+  done.store(true);
+
+  for (auto& thief : thieves) {
+    sum += thief.get();
+  }
+
+  // Every value is taken exactly once.
+  CHECK(sum == kNumItem * (kNumItem + 1) / 2);
+}
@@ -0,0 +1,116 @@
+#include <catch2/catch_test_macros.hpp>
+#include <lockables/guarded.hpp>
+#include <lockables/work_stealing_pool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("WorkStealingPool example", "[lockables][WorkStealingPool]") {
+  std::vector<lockables::Guarded<int>> values(1000);
+  lockables::WorkStealingPool pool{4};
+
+  // Update every value in parallel. Each value is locked by exactly one
+  // worker. Blocks until all of the callbacks have returned.
+  lockables::parallel_for_each_exclusive(pool, values,
+                                         [](int& x) { x += 10; });
+
+  for (auto& value : values) {
+    const auto guard = value.with_shared();
+    CHECK(*guard == 10);
+  }
+}
+
+TEST_CASE("WorkStealingPool post", "[lockables][WorkStealingPool]") {
+  constexpr int kNumTask = 1000;
+
+  std::atomic<int> count{};
+  {
+    lockables::WorkStealingPool pool{4};
+    CHECK(pool.size() == 4);
+
+    for (int i = 0; i < kNumTask; ++i) {
+      pool.post([&pool, &count]() {
+        // Tasks posted from a worker go on its own deque.
+        pool.post([&count]() { ++count; });
+        ++count;
+      });
+    }
+
+    // Destructor runs all of the queued tasks.
+  }
+
+  CHECK(count == kNumTask * 2);
+}
+
+TEST_CASE("WorkStealingPool parallel_for_each_exclusive",
+          "[lockables][WorkStealingPool]") {
+  lockables::WorkStealingPool pool{3};
+
+  SECTION("empty range") {
+    std::vector<lockables::Guarded<int>> values;
+    int count = 0;
+    lockables::parallel_for_each_exclusive(pool, values,
+                                           [&count](int&) { ++count; });
+    CHECK(count == 0);
+  }
+
+  SECTION("grain") {
+    std::vector<lockables::Guarded<int>> values(1001);
+    for (const std::size_t grain : {1U, 7U, 2000U}) {
+      lockables::parallel_for_each_exclusive(
+          pool, values, [](int& x) { ++x; }, grain);
+    }
+
+    for (auto& value : values) {
+      const auto guard = value.with_shared();
+      CHECK(*guard == 3);
+    }
+  }
+
+  SECTION("other threads lock the same values") {
+    std::vector<lockables::Guarded<int>> values(100);
+
+    auto writer = std::async(std::launch::async, [&values]() {
+      for (int i = 0; i < 100; ++i) {
+        for (auto& value : values) {
+          auto guard = value.with_exclusive();
+          *guard += 1;
+        }
+      }
+    });
+
+    for (int i = 0; i < 100; ++i) {
+      lockables::parallel_for_each_exclusive(pool, values,
+                                             [](int& x) { x += 1; });
+    }
+
+    writer.get();
+
+    for (auto& value : values) {
+      const auto guard = value.with_shared();
+      CHECK(*guard == 200);
+    }
+  }
+
+  SECTION("exception") {
+    std::vector<lockables::Guarded<int>> values(100);
+    CHECK_THROWS_AS(lockables::parallel_for_each_exclusive(
+                        pool, values,
+                        [](int& x) {
+                          ++x;
+                          if (x == 1) {
+                            throw std::runtime_error{"first visit"};
+                          }
+                        }),
+                    std::runtime_error);
+
+    // All of the values were still visited.
+    for (auto& value : values) {
+      const auto guard = value.with_shared();
+      CHECK(*guard == 1);
+    }
+  }
+}
@@ -0,0 +1,27 @@
+//
+// Must not compile with -Wthread-safety -Werror. The guarded member is read
+// after the lock is released.
+//
+#include <lockables/annotated_mutex.hpp>
+
+#include <mutex>
+
+namespace {
+
+struct Account {
+  lockables::AnnotatedMutex<std::mutex> mutex;
+  int balance LOCKABLES_GUARDED_BY(mutex) = 0;
+};
+
+}  // namespace
+
+int thread_safety_fail(Account& account) {
+  {
+    lockables::AnnotatedLock lock{account.mutex};
+    account.balance += 10;
+  }
+
+  // warning: reading variable 'balance' requires holding mutex
+  // 'account.mutex'
+  return account.balance;
+}
@@ -0,0 +1,22 @@
+//
+// Must not compile with -Wthread-safety -Werror. The guarded member is written
+// without holding the lock.
+//
+#include <lockables/annotated_mutex.hpp>
+
+#include <mutex>
+
+namespace {
+
+struct Account {
+  lockables::AnnotatedMutex<std::mutex> mutex;
+  int balance LOCKABLES_GUARDED_BY(mutex) = 0;
+};
+
+}  // namespace
+
+void thread_safety_fail(Account& account) {
+  // warning: writing variable 'balance' requires holding mutex 'account.mutex'
+  // exclusively
+  account.balance += 10;
+}
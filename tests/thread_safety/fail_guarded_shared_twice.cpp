@@ -0,0 +1,20 @@
+//
+// Must not compile with -Wthread-safety -Werror. A second reader lock of a
+// Guarded<T> in one scope. It deadlocks if a writer is waiting between the two.
+//
+#include <lockables/annotated_mutex.hpp>
+#include <lockables/guarded.hpp>
+
+#include <shared_mutex>
+
+int thread_safety_fail(
+    const lockables::Guarded<int,
+                             lockables::AnnotatedMutex<std::shared_mutex>>&
+        value) {
+  const auto guard = value.with_shared();
+
+  // warning: acquiring mutex 'value.mutex_' that is already held
+  const auto recursive = value.with_shared();
+
+  return *guard + *recursive;
+}
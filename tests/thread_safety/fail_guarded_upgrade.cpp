@@ -0,0 +1,21 @@
+//
+// Must not compile with -Wthread-safety -Werror. A writer lock of a
+// Guarded<T> while the same scope holds a reader lock. The shared lock can not
+// be upgraded, this waits for itself.
+//
+#include <lockables/annotated_mutex.hpp>
+#include <lockables/guarded.hpp>
+
+#include <shared_mutex>
+
+int thread_safety_fail(
+    lockables::Guarded<int, lockables::AnnotatedMutex<std::shared_mutex>>&
+        value) {
+  const auto reader = value.with_shared();
+
+  // warning: acquiring mutex 'value.mutex_' that is already held
+  auto writer = value.with_exclusive();
+
+  *writer += 1;
+  return *reader;
+}
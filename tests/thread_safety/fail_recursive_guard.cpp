@@ -0,0 +1,18 @@
+//
+// Must not compile with -Wthread-safety -Werror. The second lock of the same
+// Guarded<T> in one scope is a self-deadlock.
+//
+#include <lockables/annotated_mutex.hpp>
+#include <lockables/guarded.hpp>
+
+#include <mutex>
+
+int thread_safety_fail(
+    lockables::Guarded<int, lockables::AnnotatedMutex<std::mutex>>& value) {
+  auto guard = value.with_exclusive();
+
+  // warning: acquiring mutex 'value.mutex_' that is already held
+  auto recursive = value.with_exclusive();
+
+  return *guard + *recursive;
+}
@@ -0,0 +1,24 @@
+//
+// Must not compile with -Wthread-safety -Werror. A function that requires the
+// lock is called without it.
+//
+#include <lockables/annotated_mutex.hpp>
+
+#include <mutex>
+
+namespace {
+
+struct Account {
+  void add(int amount) LOCKABLES_REQUIRES(mutex) { balance += amount; }
+
+  lockables::AnnotatedMutex<std::mutex> mutex;
+  int balance LOCKABLES_GUARDED_BY(mutex) = 0;
+};
+
+}  // namespace
+
+void thread_safety_fail(Account& account) {
+  // warning: calling function 'add' requires holding mutex 'account.mutex'
+  // exclusively
+  account.add(10);
+}
@@ -0,0 +1,13 @@
+//
+// Must not compile with -Wthread-safety -Werror. A plain lock() without the
+// matching unlock(), see CP.20: Use RAII, never plain lock()/unlock().
+//
+#include <lockables/annotated_mutex.hpp>
+
+#include <mutex>
+
+void thread_safety_fail(lockables::AnnotatedMutex<std::mutex>& mutex) {
+  mutex.lock();
+
+  // warning: mutex 'mutex' is still held at the end of function
+}
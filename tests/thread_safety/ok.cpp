@@ -0,0 +1,54 @@
+//
+// Must compile with -Wthread-safety -Werror. Correct use of the annotated
+// types, the counterpart of the fail_*.cpp files.
+//
+#include <lockables/annotated_mutex.hpp>
+#include <lockables/guarded.hpp>
+
+#include <shared_mutex>
+
+namespace {
+
+class Account {
+ public:
+  void deposit(int amount) {
+    lockables::AnnotatedLock lock{mutex_};
+    add(amount);
+  }
+
+  [[nodiscard]] int balance() const {
+    lockables::AnnotatedSharedLock lock{mutex_};
+    return balance_;
+  }
+
+ private:
+  void add(int amount) LOCKABLES_REQUIRES(mutex_) { balance_ += amount; }
+
+  mutable lockables::AnnotatedMutex<std::shared_mutex> mutex_;
+  int balance_ LOCKABLES_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace
+
+int thread_safety_ok() {
+  using Mutex = lockables::AnnotatedMutex<std::shared_mutex>;
+
+  lockables::Guarded<int, Mutex> value{1};
+  {
+    auto guard = value.with_exclusive();
+    *guard += 1;
+  }
+
+  int copy = 0;
+  {
+    const auto guard = value.with_shared();
+    copy = *guard;
+  }
+
+  lockables::Guarded<int, Mutex> other{2};
+  lockables::with_exclusive([](int& x, int& y) { x += y; }, value, other);
+
+  Account account;
+  account.deposit(copy);
+  return account.balance();
+}